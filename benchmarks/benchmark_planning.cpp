@@ -0,0 +1,214 @@
+#include "hotel/concurrentplanning.h"
+#include "hotel/planning.h"
+
+#include "persistence/binary/snapshot.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <thread>
+
+/**
+ * Benchmarks for the planning board
+ *
+ * Usage: benchmark_planning [number of reservations]
+ */
+
+namespace
+{
+  std::atomic<size_t> allocationCount{0};
+} // namespace
+
+void* operator new(std::size_t size)
+{
+  ++allocationCount;
+  if (auto p = std::malloc(size == 0 ? 1 : size))
+    return p;
+  throw std::bad_alloc();
+}
+
+// The default memory resource of std::pmr allocates through the aligned versions
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+  ++allocationCount;
+  auto align = std::max(static_cast<std::size_t>(alignment), sizeof(void*));
+  if (auto p = std::aligned_alloc(align, (std::max<std::size_t>(size, 1) + align - 1) / align * align))
+    return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+namespace
+{
+  using Clock = std::chrono::steady_clock;
+
+  double millisecondsSince(Clock::time_point start)
+  {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+  }
+
+  // Creates reservations spread over 200 rooms, each of them with two atoms
+  std::vector<hotel::Reservation> makeReservations(int count)
+  {
+    using namespace boost::gregorian;
+    const int numRooms = 200;
+    const date start(2017, 1, 1);
+
+    std::vector<hotel::Reservation> reservations;
+    reservations.reserve(count);
+    for (int i = 0; i < count; ++i)
+    {
+      auto room = i % numRooms;
+      auto from = start + days((i / numRooms) * 6);
+      hotel::Reservation reservation("Reservation number " + std::to_string(i) + " of the benchmark", room,
+                                     date_period(from, from + days(3)));
+      reservation.addContinuation(room, from + days(5));
+      reservation.setId(i + 1);
+      reservations.push_back(std::move(reservation));
+    }
+    return reservations;
+  }
+
+  void benchmarkLoadAndClear(const std::vector<hotel::Reservation>& reservations, bool arena, int iterations)
+  {
+    hotel::PlanningBoard board;
+    board.setArenaAllocationEnabled(arena);
+
+    double loadTime = 0;
+    double clearTime = 0;
+    size_t allocations = 0;
+    for (int i = 0; i < iterations; ++i)
+    {
+      auto allocationsBefore = allocationCount.load();
+      auto start = Clock::now();
+      board.addReservations(reservations);
+      loadTime += millisecondsSince(start);
+      allocations += allocationCount.load() - allocationsBefore;
+
+      start = Clock::now();
+      board.clear();
+      clearTime += millisecondsSince(start);
+    }
+
+    std::cout << (arena ? "arena" : "heap ") << "  load: " << loadTime / iterations << " ms"
+              << "  clear: " << clearTime / iterations << " ms"
+              << "  allocations per load: " << allocations / iterations << std::endl;
+  }
+
+  void benchmarkCopy(const std::vector<hotel::Reservation>& reservations, int iterations)
+  {
+    double copyTime = 0;
+    size_t allocations = 0;
+    for (int i = 0; i < iterations; ++i)
+    {
+      auto allocationsBefore = allocationCount.load();
+      auto start = Clock::now();
+      auto copy = reservations;
+      copyTime += millisecondsSince(start);
+      allocations += allocationCount.load() - allocationsBefore;
+    }
+
+    std::cout << "copy: " << copyTime / iterations << " ms"
+              << "  allocations per reservation: " << static_cast<double>(allocations) / iterations / reservations.size()
+              << std::endl;
+  }
+
+  void benchmarkPeriodQueries(const std::vector<hotel::Reservation>& reservations, int queries)
+  {
+    using namespace boost::gregorian;
+    hotel::PlanningBoard board;
+    board.addReservations(reservations);
+    auto extent = board.getPlanningExtent();
+
+    size_t found = 0;
+    auto start = Clock::now();
+    for (int i = 0; i < queries; ++i)
+    {
+      auto from = extent.begin() + days((i * 37) % std::max<int>(1, extent.length().days()));
+      found += board.getReservationsInPeriod(date_period(from, from + days(14))).size();
+    }
+    std::cout << "period queries: " << millisecondsSince(start) / queries << " ms per query"
+              << "  (" << found / queries << " reservations on average)" << std::endl;
+  }
+
+  void benchmarkSnapshot(const std::vector<hotel::Reservation>& reservations, int iterations)
+  {
+    const std::string fileName = "benchmark.snapshot";
+    hotel::HotelCollection hotels;
+    hotel::PlanningBoard board;
+    board.addReservations(reservations);
+    auto start = Clock::now();
+    persistence::binary::writeSnapshot(fileName, hotels, board);
+    auto writeTime = millisecondsSince(start);
+
+    double openTime = 0;
+    double loadTime = 0;
+    for (int i = 0; i < iterations; ++i)
+    {
+      start = Clock::now();
+      persistence::binary::SnapshotFile file;
+      file.open(fileName);
+      openTime += millisecondsSince(start);
+
+      start = Clock::now();
+      hotel::HotelCollection loadedHotels;
+      hotel::PlanningBoard loadedBoard;
+      loadedBoard.setArenaAllocationEnabled(true);
+      file.load(loadedHotels, loadedBoard);
+      loadTime += millisecondsSince(start);
+    }
+    std::remove(fileName.c_str());
+
+    std::cout << "snapshot  write: " << writeTime << " ms"
+              << "  open (map and validate): " << openTime / iterations << " ms"
+              << "  load into arena board: " << loadTime / iterations << " ms" << std::endl;
+  }
+
+  void benchmarkConcurrentInsert(const std::vector<hotel::Reservation>& reservations, int numberOfThreads)
+  {
+    hotel::ConcurrentPlanningBoard board;
+    std::vector<std::thread> threads;
+    std::atomic<size_t> added{0};
+    auto start = Clock::now();
+    for (int t = 0; t < numberOfThreads; ++t)
+      threads.emplace_back([&, t]() {
+        // Every thread validates and inserts every n-th reservation, the rooms are shared between all threads
+        for (auto i = static_cast<size_t>(t); i < reservations.size(); i += static_cast<size_t>(numberOfThreads))
+          if (board.tryAddReservation(reservations[i]) != nullptr)
+            ++added;
+      });
+    for (auto& thread : threads)
+      thread.join();
+    auto time = millisecondsSince(start);
+
+    std::cout << "concurrent insert, " << numberOfThreads << " threads: " << time << " ms  ("
+              << static_cast<double>(added.load()) / time * 1000 << " reservations/s, " << board.numberOfRetries()
+              << " retries)" << std::endl;
+  }
+} // namespace
+
+int main(int argc, char** argv)
+{
+  int count = argc > 1 ? std::atoi(argv[1]) : 100000;
+  const int iterations = 5;
+
+  auto reservations = makeReservations(count);
+  std::cout << "Loading and clearing " << count << " reservations (" << iterations << " iterations)" << std::endl;
+  benchmarkLoadAndClear(reservations, false, iterations);
+  benchmarkLoadAndClear(reservations, true, iterations);
+  benchmarkCopy(reservations, iterations);
+  benchmarkPeriodQueries(reservations, 100);
+  benchmarkSnapshot(reservations, iterations);
+  for (int numberOfThreads : {1, 2, 4, 8, 16, 32})
+    benchmarkConcurrentInsert(reservations, numberOfThreads);
+  return 0;
+}
@@ -0,0 +1,183 @@
+#include "persistence/sqlite/sqlitebackend.h"
+#include "persistence/sqlite/sqlitestorage.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * Benchmarks for the durability profiles and the schema of the sqlite backend
+ *
+ * Every commit stores a single reservation and waits for the result, thus the latency includes the whole round trip
+ * through the worker thread of the backend. The burst measurement queues all messages at once, which the backend
+ * commits in groups.
+ *
+ * The load benchmark creates a database with the schema of version 0 (dates as ISO strings, no indexes), migrates it
+ * to the current schema and loads all reservations as well as single reservations by id.
+ *
+ * Usage: benchmark_sqlite [number of commits] [number of atoms]
+ */
+
+namespace
+{
+  using Clock = std::chrono::steady_clock;
+  using persistence::sqlite::SqliteOptions;
+
+  const char* databaseFile = "benchmark.db";
+
+  double millisecondsSince(Clock::time_point start)
+  {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+  }
+
+  void removeDatabase()
+  {
+    for (auto suffix : {"", "-wal", "-shm", "-journal"})
+      std::remove((std::string(databaseFile) + suffix).c_str());
+  }
+
+  void benchmarkCommits(const std::string& name, const SqliteOptions& options, int commits)
+  {
+    using namespace boost::gregorian;
+    removeDatabase();
+
+    std::vector<double> latencies;
+    latencies.reserve(commits);
+    double totalTime = 0;
+    double burstTime = 0;
+    {
+      persistence::sqlite::SqliteBackend backend(databaseFile, options);
+      hotel::Hotel hotel("Hotel");
+      hotel.addRoomCategory(std::make_unique<hotel::RoomCategory>("DZ", "Double room"));
+      for (int i = 0; i < 100; ++i)
+        hotel.addRoom(std::make_unique<hotel::HotelRoom>(std::to_string(i)), "DZ");
+      backend.queueOperation(persistence::op::StoreNew{std::make_unique<hotel::Hotel>(hotel)}).wait();
+
+      auto makeReservation = [](int i) {
+        auto from = date(2017, 1, 1) + days((i / 100) * 7);
+        return std::make_unique<hotel::Reservation>("Reservation " + std::to_string(i), i % 100 + 1,
+                                                    date_period(from, from + days(5)));
+      };
+
+      auto start = Clock::now();
+      for (int i = 0; i < commits; ++i)
+      {
+        auto commitStart = Clock::now();
+        backend.queueOperation(persistence::op::StoreNew{makeReservation(i)}).wait();
+        latencies.push_back(millisecondsSince(commitStart));
+      }
+      totalTime = millisecondsSince(start);
+
+      // Start the burst from the same state, the validation of reservations depends on the size of the database
+      backend.queueOperation(persistence::op::EraseAllData{}).wait();
+      backend.queueOperation(persistence::op::StoreNew{std::make_unique<hotel::Hotel>(hotel)}).wait();
+      start = Clock::now();
+      std::vector<fas::Future<std::vector<persistence::TaskResult>>> futures;
+      for (int i = 0; i < commits; ++i)
+        futures.push_back(backend.queueOperation(persistence::op::StoreNew{makeReservation(i)}));
+      for (auto& future : futures)
+        future.wait();
+      burstTime = millisecondsSince(start);
+    }
+    removeDatabase();
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) {
+      return latencies[std::min(latencies.size() - 1, static_cast<size_t>(p * latencies.size()))];
+    };
+    std::cout << name << "  median: " << percentile(0.5) << " ms  p99: " << percentile(0.99) << " ms"
+              << "  throughput: " << commits / totalTime * 1000 << " commits/s"
+              << "  burst: " << commits / burstTime * 1000 << " messages/s" << std::endl;
+  }
+
+  void createLegacyDatabase(int atoms)
+  {
+    // Two atoms per reservation in neighbouring rooms, 1000 rooms
+    sqlite3* db = nullptr;
+    sqlite3_open(databaseFile, &db);
+    auto sql = "CREATE TABLE h_hotel (id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, "
+               "revision INTEGER NOT NULL DEFAULT 1, name TEXT NOT NULL);"
+               "CREATE TABLE h_room_category (id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, "
+               "hotel_id INTEGER NOT NULL, short_code TEXT NOT NULL, name TEXT NOT NULL);"
+               "CREATE TABLE h_room (id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, "
+               "hotel_id INTEGER NOT NULL, category_id INTEGER NOT NULL, name TEXT NOT NULL);"
+               "CREATE TABLE h_reservation (id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, "
+               "revision INTEGER NOT NULL DEFAULT 1, description TEXT NOT NULL, status TEXT NOT NULL, "
+               "adults INTEGER NOT NULL, children INTEGER NOT NULL);"
+               "CREATE TABLE h_reservation_atom (id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, "
+               "reservation_id INTEGER NOT NULL, room_id INTEGER NOT NULL, "
+               "date_from TEXT NOT NULL, date_to TEXT NOT NULL);"
+               "BEGIN;"
+               "WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < " +
+               std::to_string(atoms / 2) +
+               ") INSERT INTO h_reservation (id, description, status, adults, children) "
+               "SELECT i, 'Reservation ' || i, 'new', 2, 0 FROM n;"
+               "WITH RECURSIVE n(i) AS (SELECT 0 UNION ALL SELECT i + 1 FROM n WHERE i < " +
+               std::to_string(atoms - 1) +
+               ") INSERT INTO h_reservation_atom (reservation_id, room_id, date_from, date_to) "
+               "SELECT i / 2 + 1, (i / 2) % 1000 + 1 + i % 2, "
+               "strftime('%Y%m%d', '2017-01-01', '+' || ((i / 2000) * 8 + (i % 2) * 4) || ' days'), "
+               "strftime('%Y%m%d', '2017-01-01', '+' || ((i / 2000) * 8 + (i % 2) * 4 + 4) || ' days') FROM n;"
+               "COMMIT;";
+    char* error = nullptr;
+    if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &error) != SQLITE_OK)
+      std::cerr << "Cannot create the database: " << error << std::endl;
+    sqlite3_free(error);
+    sqlite3_close(db);
+  }
+
+  void benchmarkLoad(int atoms)
+  {
+    removeDatabase();
+    createLegacyDatabase(atoms);
+    {
+      auto start = Clock::now();
+      persistence::sqlite::SqliteStorage storage(databaseFile);
+      std::cout << "Migrating " << atoms << " atoms to schema version "
+                << persistence::sqlite::SqliteStorage::schemaVersion << ": " << millisecondsSince(start) << " ms"
+                << std::endl;
+
+      start = Clock::now();
+      auto reservations = storage.loadAll<hotel::Reservation>();
+      std::cout << "Loading " << reservations.size() << " reservations: " << millisecondsSince(start) << " ms"
+                << std::endl;
+
+      const int loads = 100;
+      start = Clock::now();
+      for (int i = 0; i < loads; ++i)
+        storage.loadById<hotel::Reservation>(1 + i * static_cast<int>(reservations.size() / loads));
+      std::cout << "Loading a reservation by id: " << millisecondsSince(start) / loads << " ms" << std::endl;
+    }
+    removeDatabase();
+  }
+} // namespace
+
+int main(int argc, char** argv)
+{
+  int commits = argc > 1 ? std::atoi(argv[1]) : 300;
+  int atoms = argc > 2 ? std::atoi(argv[2]) : 1000000;
+  std::cout << "Committing " << commits << " single reservation transactions" << std::endl;
+
+  benchmarkCommits("legacy (rollback journal, synchronous=full)", SqliteOptions::legacy(), commits);
+
+  SqliteOptions options;
+  options.synchronous = SqliteOptions::Synchronous::Full;
+  benchmarkCommits("wal, synchronous=full                     ", options, commits);
+
+  benchmarkCommits("wal, synchronous=normal (default)         ", SqliteOptions(), commits);
+
+  options = SqliteOptions();
+  options.checkpointPolicy = SqliteOptions::CheckpointPolicy::WhenIdle;
+  benchmarkCommits("wal, synchronous=normal, idle checkpoints ", options, commits);
+
+  options = SqliteOptions();
+  options.synchronous = SqliteOptions::Synchronous::Off;
+  benchmarkCommits("wal, synchronous=off                      ", options, commits);
+
+  benchmarkLoad(atoms);
+  return 0;
+}
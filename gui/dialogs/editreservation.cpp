@@ -256,7 +256,8 @@ namespace gui
       }
       else if (_status == Status::Ready && _referenceVersion != std::nullopt)
       {
-        auto description = QString::fromStdString(_referenceVersion->description());
+        auto referenceDescription = _referenceVersion->description();
+        auto description = QString::fromUtf8(referenceDescription.data(), static_cast<int>(referenceDescription.size()));
         auto fromDate = _referenceVersion->dateRange().begin();
         auto toDate = _referenceVersion->dateRange().end();
         auto fromDateText = QDate(fromDate.year(), fromDate.month(), fromDate.day()).toString("dd-MM-yyyy");
@@ -61,7 +61,7 @@ namespace gui::dialogs
 
     static Tuple ItemToTuple(const hotel::Reservation& item)
     {
-      return {{item.status(), item.description(), item.numberOfAdults(), item.numberOfChildren()}};
+      return {{item.status(), std::string(item.description()), item.numberOfAdults(), item.numberOfChildren()}};
     }
 
     static void SetItemFromTuple(hotel::Reservation& item, const Tuple& tuple)
@@ -103,11 +103,7 @@ namespace gui
 
   void PlanningWidget::reservationsAdded(const std::vector<hotel::Reservation> &reservations)
   {
-    for (auto& reservation : reservations)
-    {
-      auto reservationPtr = _context.addReservation(reservation);
-      _planningBoard->addReservation(reservationPtr);
-    }
+    _planningBoard->addReservations(_context.addReservations(reservations));
     updateDateRange();
   }
 
@@ -115,10 +111,11 @@ namespace gui
   {
     for (auto& reservation : reservations)
     {
-      _planningBoard->removeReservation(reservation.id());
-      _context.removeReservation(reservation.id());
-      auto reservationPtr = _context.addReservation(reservation);
-      _planningBoard->addReservation(reservationPtr);
+      // Reservations are changed in place, thus the scene items and the selection keep pointing to them
+      if (auto reservationPtr = _context.updateReservation(reservation))
+        _planningBoard->updateReservation(reservationPtr);
+      else
+        _planningBoard->addReservation(_context.addReservation(reservation));
     }
     updateDateRange();
   }
@@ -32,6 +32,33 @@ namespace gui
       return _reservations.addReservation(std::make_unique<hotel::Reservation>(reservation));
     }
 
+    std::vector<const hotel::Reservation*> Context::addReservations(const std::vector<hotel::Reservation>& reservations)
+    {
+      for (auto& reservation : reservations)
+      {
+        assert(reservation.id() != 0);
+        if (_activeTool)
+          _activeTool->reservationAdded(reservation);
+      }
+
+      auto addedReservations = _reservations.addReservations(reservations);
+      return std::vector<const hotel::Reservation*>(addedReservations.begin(), addedReservations.end());
+    }
+
+    const hotel::Reservation* Context::updateReservation(const hotel::Reservation& reservation)
+    {
+      assert(reservation.id() != 0);
+      if (_reservations.getReservationById(reservation.id()) == nullptr)
+        return nullptr;
+
+      if (_activeTool)
+      {
+        _activeTool->reservationRemoved(reservation.id());
+        _activeTool->reservationAdded(reservation);
+      }
+      return _reservations.replaceReservation(reservation.id(), reservation);
+    }
+
     void Context::removeHotel(int hotelId)
     {
       _hotels.erase(std::remove_if(_hotels.begin(), _hotels.end(),
@@ -51,6 +51,12 @@ namespace gui
       // Modifying data calls
       void addHotel(const hotel::Hotel& hotel);
       const hotel::Reservation* addReservation(const hotel::Reservation& reservation);
+      std::vector<const hotel::Reservation*> addReservations(const std::vector<hotel::Reservation>& reservations);
+      /**
+       * @brief updateReservation changes the reservation with the same id in place
+       * @return The updated reservation, which keeps its address, or nullptr if there is no such reservation
+       */
+      const hotel::Reservation* updateReservation(const hotel::Reservation& reservation);
       void removeHotel(int hotelId);
       void removeReservation(int reservationId);
 
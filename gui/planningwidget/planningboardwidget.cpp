@@ -136,6 +136,21 @@ namespace gui
       }
     }
 
+    void PlanningBoardWidget::updateReservation(const hotel::Reservation* reservation)
+    {
+      for (auto item : _scene->items())
+      {
+        auto reservationItem = dynamic_cast<PlanningBoardReservationItem*>(item);
+        if (reservationItem != nullptr && reservationItem->reservation() == reservation)
+        {
+          reservationItem->updateLayout();
+          return;
+        }
+      }
+
+      addReservation(reservation);
+    }
+
     void PlanningBoardWidget::removeReservation(int reservationId)
     {
       // Find the given reservation
@@ -36,6 +36,8 @@ namespace gui
       PlanningBoardWidget(Context* context);
       void addReservation(const hotel::Reservation* reservation);
       void addReservations(const std::vector<const hotel::Reservation*>& reservations);
+      //! Updates the layout of the item showing the given reservation, after it has been changed in place
+      void updateReservation(const hotel::Reservation* reservation);
       void removeReservation(int reservationId);
       void removeReservations(const std::vector<const hotel::Reservation*>& reservations);
       void removeAllReservations();
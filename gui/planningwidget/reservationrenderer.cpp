@@ -157,7 +157,8 @@ namespace gui
     {
       using ReservationStatus = hotel::Reservation::ReservationStatus;
 
-      auto description = QString::fromStdString(reservation.description());
+      auto description =
+          QString::fromUtf8(reservation.description().data(), static_cast<int>(reservation.description().size()));
       QString text;
 
       if (reservation.status() == ReservationStatus::Temporary)
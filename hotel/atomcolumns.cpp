@@ -0,0 +1,182 @@
+#include "hotel/atomcolumns.h"
+
+#include <cassert>
+#include <limits>
+
+namespace hotel
+{
+  namespace
+  {
+    // Holes never intersect any period (see periodsIntersect)
+    constexpr DayNumber holeDay = std::numeric_limits<DayNumber>::max();
+
+    // Branch free version of periodsIntersect(), so that the scans can be vectorized
+    inline uint8_t intersects(DayNumber aFrom, DayNumber aTo, DayNumber bFrom, DayNumber bTo)
+    {
+      auto aLast = aTo - 1;
+      auto bLast = bTo - 1;
+      return ((bFrom >= aFrom) & (bFrom <= aLast)) | ((aFrom >= bFrom) & (aFrom <= bLast)) |
+             ((bFrom < aFrom) & (bLast >= aFrom));
+    }
+  } // namespace
+
+  size_t AtomColumns::append(const Reservation& reservation)
+  {
+    auto owner = static_cast<uint32_t>(_blocks.size());
+    auto& atoms = reservation.atoms();
+    _blocks.push_back({static_cast<uint32_t>(_roomIds.size()), static_cast<uint32_t>(atoms.size())});
+    for (auto& atom : atoms)
+    {
+      _roomIds.push_back(atom.roomId());
+      _fromDays.push_back(atom.fromDay());
+      _toDays.push_back(atom.toDay());
+      _owners.push_back(owner);
+    }
+    return owner;
+  }
+
+  void AtomColumns::erase(size_t owner)
+  {
+    assert(owner < _blocks.size());
+
+    // Turn the atoms of the owner into holes
+    auto block = _blocks[owner];
+    for (auto i = block.begin; i < block.begin + block.size; ++i)
+    {
+      _fromDays[i] = holeDay;
+      _toDays[i] = holeDay;
+    }
+    _numberOfHoles += block.size;
+
+    // Move the last owner into the freed index
+    if (owner + 1 != _blocks.size())
+    {
+      auto lastBlock = _blocks.back();
+      for (auto i = lastBlock.begin; i < lastBlock.begin + lastBlock.size; ++i)
+        _owners[i] = static_cast<uint32_t>(owner);
+      _blocks[owner] = lastBlock;
+    }
+    _blocks.pop_back();
+
+    if (_numberOfHoles * 2 > _roomIds.size())
+      compact();
+  }
+
+  void AtomColumns::replace(size_t owner, const Reservation& reservation)
+  {
+    assert(owner < _blocks.size());
+
+    auto& atoms = reservation.atoms();
+    auto& block = _blocks[owner];
+    if (block.size != atoms.size())
+    {
+      for (auto i = block.begin; i < block.begin + block.size; ++i)
+      {
+        _fromDays[i] = holeDay;
+        _toDays[i] = holeDay;
+      }
+      _numberOfHoles += block.size;
+
+      block = {static_cast<uint32_t>(_roomIds.size()), static_cast<uint32_t>(atoms.size())};
+      _roomIds.resize(_roomIds.size() + atoms.size());
+      _fromDays.resize(_fromDays.size() + atoms.size());
+      _toDays.resize(_toDays.size() + atoms.size());
+      _owners.resize(_owners.size() + atoms.size(), static_cast<uint32_t>(owner));
+    }
+
+    auto i = block.begin;
+    for (auto& atom : atoms)
+    {
+      _roomIds[i] = atom.roomId();
+      _fromDays[i] = atom.fromDay();
+      _toDays[i] = atom.toDay();
+      ++i;
+    }
+
+    if (_numberOfHoles * 2 > _roomIds.size())
+      compact();
+  }
+
+  void AtomColumns::clear()
+  {
+    _roomIds.clear();
+    _fromDays.clear();
+    _toDays.clear();
+    _owners.clear();
+    _blocks.clear();
+    _numberOfHoles = 0;
+  }
+
+  std::vector<size_t> AtomColumns::findOwners(DayNumber fromDay, DayNumber toDay) const
+  {
+    auto n = _roomIds.size();
+    std::vector<uint8_t> matches(n);
+    auto from = _fromDays.data();
+    auto to = _toDays.data();
+    for (size_t i = 0; i < n; ++i)
+      matches[i] = intersects(from[i], to[i], fromDay, toDay);
+    return collectOwners(matches);
+  }
+
+  std::vector<size_t> AtomColumns::findOwners(int firstRoomId, int lastRoomId, DayNumber fromDay,
+                                              DayNumber toDay) const
+  {
+    auto n = _roomIds.size();
+    std::vector<uint8_t> matches(n);
+    auto rooms = _roomIds.data();
+    auto from = _fromDays.data();
+    auto to = _toDays.data();
+    for (size_t i = 0; i < n; ++i)
+      matches[i] = (rooms[i] >= firstRoomId) & (rooms[i] <= lastRoomId) & intersects(from[i], to[i], fromDay, toDay);
+    return collectOwners(matches);
+  }
+
+  void AtomColumns::compact()
+  {
+    std::vector<int> roomIds;
+    std::vector<DayNumber> fromDays;
+    std::vector<DayNumber> toDays;
+    std::vector<uint32_t> owners;
+    auto n = numberOfAtoms();
+    roomIds.reserve(n);
+    fromDays.reserve(n);
+    toDays.reserve(n);
+    owners.reserve(n);
+
+    for (size_t owner = 0; owner < _blocks.size(); ++owner)
+    {
+      auto& block = _blocks[owner];
+      auto begin = static_cast<uint32_t>(roomIds.size());
+      for (auto i = block.begin; i < block.begin + block.size; ++i)
+      {
+        roomIds.push_back(_roomIds[i]);
+        fromDays.push_back(_fromDays[i]);
+        toDays.push_back(_toDays[i]);
+        owners.push_back(static_cast<uint32_t>(owner));
+      }
+      block.begin = begin;
+    }
+
+    _roomIds = std::move(roomIds);
+    _fromDays = std::move(fromDays);
+    _toDays = std::move(toDays);
+    _owners = std::move(owners);
+    _numberOfHoles = 0;
+  }
+
+  std::vector<size_t> AtomColumns::collectOwners(const std::vector<uint8_t>& matches) const
+  {
+    // An owner may match with several atoms, thus mark the owners first to get each of them once and in order
+    std::vector<uint8_t> ownerMatches(_blocks.size(), 0);
+    for (size_t i = 0; i < matches.size(); ++i)
+      if (matches[i])
+        ownerMatches[_owners[i]] = 1;
+
+    std::vector<size_t> result;
+    for (size_t owner = 0; owner < ownerMatches.size(); ++owner)
+      if (ownerMatches[owner])
+        result.push_back(owner);
+    return result;
+  }
+
+} // namespace hotel
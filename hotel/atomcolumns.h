@@ -0,0 +1,89 @@
+#ifndef HOTEL_ATOMCOLUMNS_H
+#define HOTEL_ATOMCOLUMNS_H
+
+#include "hotel/daynumber.h"
+#include "hotel/reservation.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace hotel
+{
+  /**
+   * @brief The AtomColumns class mirrors the reservation atoms of a planning board as a structure of arrays
+   *
+   * The room id, the first day and the end day of all atoms are stored in separate contiguous arrays, together with the
+   * index of the owning reservation. Scans over all atoms (e.g. "which reservations intersect this period?") thus run
+   * over a few dense integer arrays, which the compiler can vectorize, instead of chasing the pointers to the
+   * reservations and their atoms.
+   *
+   * The owners are numbered 0..n-1, exactly like the reservation slots of the PlanningBoard. The atoms of one owner are
+   * stored as one contiguous block. Removing an owner leaves a hole in the columns, which is filled by compacting the
+   * columns once the holes make up more than half of them.
+   *
+   * @see PlanningBoard
+   */
+  class AtomColumns
+  {
+  public:
+    /**
+     * @brief append adds the atoms of the given reservation as a new owner
+     * @return The index of the new owner, i.e. the number of owners before the call
+     */
+    size_t append(const Reservation& reservation);
+    /**
+     * @brief erase removes the atoms of the given owner
+     *
+     * The last owner takes the index of the removed owner, mirroring how the PlanningBoard fills the freed reservation
+     * slot.
+     */
+    void erase(size_t owner);
+    /**
+     * @brief replace replaces the atoms of the given owner with the atoms of the given reservation
+     *
+     * The owner keeps its index. If the number of atoms does not change, the atoms are overwritten in place, otherwise
+     * the old block becomes a hole and the new atoms are appended.
+     */
+    void replace(size_t owner, const Reservation& reservation);
+    void clear();
+
+    size_t numberOfOwners() const { return _blocks.size(); }
+    size_t numberOfAtoms() const { return _roomIds.size() - _numberOfHoles; }
+
+    /**
+     * @brief findOwners returns the owners with at least one atom intersecting the period [fromDay, toDay)
+     * @return The owner indexes in ascending order
+     * @note The intersection has the same semantics as periodsIntersect()
+     */
+    std::vector<size_t> findOwners(DayNumber fromDay, DayNumber toDay) const;
+    /**
+     * @brief findOwners returns the owners with at least one atom in a room of [firstRoomId, lastRoomId] intersecting
+     *        the period [fromDay, toDay)
+     * @return The owner indexes in ascending order
+     */
+    std::vector<size_t> findOwners(int firstRoomId, int lastRoomId, DayNumber fromDay, DayNumber toDay) const;
+
+  private:
+    // The atoms of an owner are stored in [begin, begin + size)
+    struct Block
+    {
+      uint32_t begin;
+      uint32_t size;
+    };
+
+    // Compacts the columns, removing all holes
+    void compact();
+    // Converts the per atom match flags into the list of matching owners
+    std::vector<size_t> collectOwners(const std::vector<uint8_t>& matches) const;
+
+    std::vector<int> _roomIds;
+    std::vector<DayNumber> _fromDays;
+    std::vector<DayNumber> _toDays;
+    std::vector<uint32_t> _owners;
+    std::vector<Block> _blocks;
+    size_t _numberOfHoles = 0;
+  };
+
+} // namespace hotel
+
+#endif // HOTEL_ATOMCOLUMNS_H
@@ -0,0 +1,320 @@
+#include "hotel/availabilitybitmap.h"
+
+#include <algorithm>
+#include <atomic>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define HOTEL_AVX2_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace hotel
+{
+  namespace
+  {
+    // Bitwise kernels over rows of n words
+    struct Kernels
+    {
+      void (*andInto)(uint64_t* dst, const uint64_t* src, size_t n);    // dst &= src
+      void (*andNotInto)(uint64_t* dst, const uint64_t* src, size_t n); // dst &= ~src
+      bool (*anyBit)(const uint64_t* src, size_t n);
+    };
+
+    // Note: andInto is used in place with src ahead of dst (src > dst), thus the kernels must process the words in
+    // ascending order and must not assume that dst and src do not alias.
+    void andIntoScalar(uint64_t* dst, const uint64_t* src, size_t n)
+    {
+      for (size_t i = 0; i < n; ++i)
+        dst[i] &= src[i];
+    }
+
+    void andNotIntoScalar(uint64_t* dst, const uint64_t* src, size_t n)
+    {
+      for (size_t i = 0; i < n; ++i)
+        dst[i] &= ~src[i];
+    }
+
+    bool anyBitScalar(const uint64_t* src, size_t n)
+    {
+      uint64_t acc = 0;
+      for (size_t i = 0; i < n; ++i)
+        acc |= src[i];
+      return acc != 0;
+    }
+
+    const Kernels scalarKernels{andIntoScalar, andNotIntoScalar, anyBitScalar};
+
+#ifdef HOTEL_AVX2_KERNELS
+    __attribute__((target("avx2"))) void andIntoAvx2(uint64_t* dst, const uint64_t* src, size_t n)
+    {
+      size_t i = 0;
+      for (; i + 4 <= n; i += 4)
+      {
+        auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+        auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_and_si256(a, b));
+      }
+      andIntoScalar(dst + i, src + i, n - i);
+    }
+
+    __attribute__((target("avx2"))) void andNotIntoAvx2(uint64_t* dst, const uint64_t* src, size_t n)
+    {
+      size_t i = 0;
+      for (; i + 4 <= n; i += 4)
+      {
+        auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+        auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_andnot_si256(b, a));
+      }
+      andNotIntoScalar(dst + i, src + i, n - i);
+    }
+
+    __attribute__((target("avx2"))) bool anyBitAvx2(const uint64_t* src, size_t n)
+    {
+      size_t i = 0;
+      auto acc = _mm256_setzero_si256();
+      for (; i + 4 <= n; i += 4)
+        acc = _mm256_or_si256(acc, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)));
+      return !_mm256_testz_si256(acc, acc) || anyBitScalar(src + i, n - i);
+    }
+
+    const Kernels avx2Kernels{andIntoAvx2, andNotIntoAvx2, anyBitAvx2};
+#endif
+
+    bool cpuSupportsAvx2()
+    {
+#ifdef HOTEL_AVX2_KERNELS
+      return __builtin_cpu_supports("avx2");
+#else
+      return false;
+#endif
+    }
+
+    const Kernels* bestKernels()
+    {
+#ifdef HOTEL_AVX2_KERNELS
+      if (cpuSupportsAvx2())
+        return &avx2Kernels;
+#endif
+      return &scalarKernels;
+    }
+
+    // Searches may run while the kernels are switched, each of them loads the kernels once and keeps using them
+    std::atomic<const Kernels*> activeKernels{bestKernels()};
+  } // namespace
+
+  void AvailabilityBitmap::occupy(int roomId, DayNumber fromDay, DayNumber toDay)
+  {
+    if (toDay <= fromDay)
+      return;
+
+    slotForRoom(roomId);
+    reserveDays(fromDay, toDay);
+    setBits(roomId, fromDay, toDay, true);
+  }
+
+  void AvailabilityBitmap::release(int roomId, DayNumber fromDay, DayNumber toDay)
+  {
+    // Days outside of the stored range are free anyway
+    fromDay = std::max(fromDay, _firstDay);
+    toDay = std::min(toDay, _firstDay + _numDays);
+    if (toDay <= fromDay || _roomSlots.count(roomId) == 0)
+      return;
+
+    setBits(roomId, fromDay, toDay, false);
+  }
+
+  void AvailabilityBitmap::clear()
+  {
+    _roomSlots.clear();
+    _stride = 0;
+    _firstDay = 0;
+    _numDays = 0;
+    _bits.clear();
+  }
+
+  bool AvailabilityBitmap::isOccupied(int roomId, DayNumber day) const
+  {
+    auto slotIt = _roomSlots.find(roomId);
+    auto dayRow = row(day);
+    if (slotIt == _roomSlots.end() || dayRow == nullptr)
+      return false;
+
+    return (dayRow[slotIt->second / wordBits] >> (slotIt->second % wordBits)) & 1;
+  }
+
+  std::vector<int> AvailabilityBitmap::freeRooms(const std::vector<int>& roomIds, DayNumber fromDay, int nights) const
+  {
+    // An empty period still occupies its begin date (see date_period::intersects)
+    nights = std::max(nights, 1);
+
+    // Start with all requested rooms and remove the ones occupied on any of the days
+    auto kernels = activeKernels.load(std::memory_order_relaxed);
+    auto free = makeMask(roomIds);
+    for (auto day = fromDay; day < fromDay + nights; ++day)
+    {
+      auto dayRow = row(day);
+      if (dayRow != nullptr)
+        kernels->andNotInto(free.data(), dayRow, _stride);
+    }
+    return roomsInRow(roomIds, free.data());
+  }
+
+  std::optional<AvailabilityBitmap::FreeRun> AvailabilityBitmap::findFreeRun(const std::vector<int>& roomIds,
+                                                                            DayNumber earliestDay,
+                                                                            DayNumber latestDay, int nights) const
+  {
+    nights = std::max(nights, 1);
+    if (latestDay < earliestDay || roomIds.empty())
+      return std::nullopt;
+
+    // Rooms which have never been occupied are always free
+    auto isUnknown = [this](int roomId) { return _roomSlots.count(roomId) == 0; };
+    if (std::any_of(roomIds.begin(), roomIds.end(), isUnknown))
+      return FreeRun{earliestDay, freeRooms(roomIds, earliestDay, nights)};
+
+    // Compute the free rooms for every day of the search range, including the nights after the latest start day
+    size_t startDays = static_cast<size_t>(latestDay - earliestDay) + 1;
+    size_t rows = startDays + static_cast<size_t>(nights) - 1;
+    auto kernels = activeKernels.load(std::memory_order_relaxed);
+    auto mask = makeMask(roomIds);
+    std::vector<uint64_t> window(rows * _stride);
+    for (size_t i = 0; i < rows; ++i)
+    {
+      auto windowRow = window.data() + i * _stride;
+      std::copy(mask.begin(), mask.end(), windowRow);
+      auto dayRow = row(earliestDay + static_cast<DayNumber>(i));
+      if (dayRow != nullptr)
+        kernels->andNotInto(windowRow, dayRow, _stride);
+    }
+
+    // Reduce the rows to windows of length "nights": after each doubling step row i holds the rooms free for all of
+    // the days [i, i + length). The last step combines two overlapping windows to reach the exact number of nights.
+    size_t length = 1;
+    size_t validRows = rows;
+    while (length * 2 <= static_cast<size_t>(nights))
+    {
+      kernels->andInto(window.data(), window.data() + length * _stride, (validRows - length) * _stride);
+      validRows -= length;
+      length *= 2;
+    }
+    if (length < static_cast<size_t>(nights))
+    {
+      auto shift = static_cast<size_t>(nights) - length;
+      kernels->andInto(window.data(), window.data() + shift * _stride, (validRows - shift) * _stride);
+      validRows -= shift;
+    }
+
+    for (size_t i = 0; i < startDays; ++i)
+    {
+      auto windowRow = window.data() + i * _stride;
+      if (kernels->anyBit(windowRow, _stride))
+        return FreeRun{earliestDay + static_cast<DayNumber>(i), roomsInRow(roomIds, windowRow)};
+    }
+    return std::nullopt;
+  }
+
+  bool AvailabilityBitmap::hasVectorizedKernels() { return cpuSupportsAvx2(); }
+
+  void AvailabilityBitmap::setVectorizedKernelsEnabled(bool enabled)
+  {
+    activeKernels.store(enabled ? bestKernels() : &scalarKernels, std::memory_order_relaxed);
+  }
+
+  void AvailabilityBitmap::setBits(int roomId, DayNumber fromDay, DayNumber toDay, bool occupied)
+  {
+    auto slot = _roomSlots.at(roomId);
+    auto word = slot / wordBits;
+    auto bit = uint64_t(1) << (slot % wordBits);
+    for (auto day = fromDay; day < toDay; ++day)
+    {
+      auto& value = _bits[static_cast<size_t>(day - _firstDay) * _stride + word];
+      value = occupied ? (value | bit) : (value & ~bit);
+    }
+  }
+
+  size_t AvailabilityBitmap::slotForRoom(int roomId)
+  {
+    auto slotIt = _roomSlots.find(roomId);
+    if (slotIt != _roomSlots.end())
+      return slotIt->second;
+
+    auto slot = _roomSlots.size();
+    reserveSlots(slot + 1);
+    _roomSlots[roomId] = slot;
+    return slot;
+  }
+
+  void AvailabilityBitmap::reserveDays(DayNumber fromDay, DayNumber toDay)
+  {
+    if (_numDays == 0)
+    {
+      _firstDay = fromDay;
+      _numDays = toDay - fromDay;
+      _bits.assign(static_cast<size_t>(_numDays) * _stride, 0);
+      return;
+    }
+
+    auto endDay = _firstDay + _numDays;
+    if (fromDay >= _firstDay && toDay <= endDay)
+      return;
+
+    // Grow by at least half of the current size, so that a board growing day by day is not copied over and over
+    auto newFirstDay = fromDay < _firstDay ? std::min(fromDay, _firstDay - _numDays / 2) : _firstDay;
+    auto newEndDay = toDay > endDay ? std::max(toDay, endDay + _numDays / 2) : endDay;
+    std::vector<uint64_t> bits(static_cast<size_t>(newEndDay - newFirstDay) * _stride, 0);
+    std::copy(_bits.begin(), _bits.end(), bits.begin() + static_cast<size_t>(_firstDay - newFirstDay) * _stride);
+
+    _bits = std::move(bits);
+    _firstDay = newFirstDay;
+    _numDays = newEndDay - newFirstDay;
+  }
+
+  void AvailabilityBitmap::reserveSlots(size_t slots)
+  {
+    auto words = (slots + wordBits - 1) / wordBits;
+    auto stride = (words + strideAlignment - 1) / strideAlignment * strideAlignment;
+    if (stride <= _stride)
+      return;
+
+    stride = std::max(stride, _stride * 2);
+    std::vector<uint64_t> bits(static_cast<size_t>(_numDays) * stride, 0);
+    for (size_t day = 0; day < static_cast<size_t>(_numDays); ++day)
+      std::copy_n(_bits.begin() + day * _stride, _stride, bits.begin() + day * stride);
+
+    _bits = std::move(bits);
+    _stride = stride;
+  }
+
+  std::vector<uint64_t> AvailabilityBitmap::makeMask(const std::vector<int>& roomIds) const
+  {
+    std::vector<uint64_t> mask(_stride, 0);
+    for (auto roomId : roomIds)
+    {
+      auto slotIt = _roomSlots.find(roomId);
+      if (slotIt != _roomSlots.end())
+        mask[slotIt->second / wordBits] |= uint64_t(1) << (slotIt->second % wordBits);
+    }
+    return mask;
+  }
+
+  std::vector<int> AvailabilityBitmap::roomsInRow(const std::vector<int>& roomIds, const uint64_t* row) const
+  {
+    std::vector<int> result;
+    for (auto roomId : roomIds)
+    {
+      auto slotIt = _roomSlots.find(roomId);
+      if (slotIt == _roomSlots.end() || ((row[slotIt->second / wordBits] >> (slotIt->second % wordBits)) & 1))
+        result.push_back(roomId);
+    }
+    return result;
+  }
+
+  const uint64_t* AvailabilityBitmap::row(DayNumber day) const
+  {
+    if (day < _firstDay || day >= _firstDay + _numDays)
+      return nullptr;
+    return _bits.data() + static_cast<size_t>(day - _firstDay) * _stride;
+  }
+
+} // namespace hotel
@@ -0,0 +1,101 @@
+#ifndef HOTEL_AVAILABILITYBITMAP_H
+#define HOTEL_AVAILABILITYBITMAP_H
+
+#include "hotel/daynumber.h"
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace hotel
+{
+  /**
+   * @brief The AvailabilityBitmap class stores the occupancy of a set of rooms as one bit per room and day
+   *
+   * The bitmap is stored day-major: each day is one row of bits, where every room owns one bit column. This makes the
+   * typical front desk question ("which of these rooms are free for N nights starting at D?") a bitwise reduction over
+   * N rows, which handles all rooms at once. The reductions are vectorized with AVX2 if the CPU supports it, with a
+   * scalar fallback otherwise.
+   *
+   * Days outside of the stored range and rooms which have never been occupied are free.
+   *
+   * @note The bitmap does not verify that occupied periods do not overlap. This is the responsibility of the caller.
+   *
+   * @see PlanningBoard::setAvailabilityBitmapEnabled
+   */
+  class AvailabilityBitmap
+  {
+  public:
+    //! Result of a free run search
+    struct FreeRun
+    {
+      //! The first day at which at least one room is available
+      DayNumber fromDay;
+      //! All of the rooms which are available from this day on
+      std::vector<int> roomIds;
+    };
+
+    //! @brief occupy marks the days [fromDay, toDay) of the given room as occupied
+    void occupy(int roomId, DayNumber fromDay, DayNumber toDay);
+    //! @brief release marks the days [fromDay, toDay) of the given room as free
+    void release(int roomId, DayNumber fromDay, DayNumber toDay);
+    void clear();
+
+    //! @brief isOccupied returns true if the given room is occupied on the given day
+    bool isOccupied(int roomId, DayNumber day) const;
+
+    /**
+     * @brief freeRooms returns all of the given rooms which are free for the given number of nights from fromDay on
+     * @return The free rooms, in the same order as roomIds
+     */
+    std::vector<int> freeRooms(const std::vector<int>& roomIds, DayNumber fromDay, int nights) const;
+
+    /**
+     * @brief findFreeRun searches for the first day in [earliestDay, latestDay] at which at least one of the given rooms
+     *        is free for the given number of nights
+     * @return The first such day together with all rooms available from that day on, or nothing if there is no
+     *         such day.
+     */
+    std::optional<FreeRun> findFreeRun(const std::vector<int>& roomIds, DayNumber earliestDay, DayNumber latestDay,
+                                       int nights) const;
+
+    //! @brief hasVectorizedKernels returns true if the CPU supports the vectorized (AVX2) kernels
+    static bool hasVectorizedKernels();
+    /**
+     * @brief setVectorizedKernelsEnabled selects between the vectorized and the scalar kernels for all bitmaps
+     *
+     * The kernels may be switched while other threads search, each search keeps the kernels it has started with.
+     * @note This is mainly meant for testing and benchmarking, by default the vectorized kernels are used if the CPU
+     *       supports them.
+     */
+    static void setVectorizedKernelsEnabled(bool enabled);
+
+  private:
+    // Number of bits per word
+    static constexpr size_t wordBits = 64;
+    // The stride of a row is always a multiple of this number of words (i.e. 256 bits, the width of an AVX2 register)
+    static constexpr size_t strideAlignment = 4;
+
+    void setBits(int roomId, DayNumber fromDay, DayNumber toDay, bool occupied);
+    size_t slotForRoom(int roomId);
+    void reserveDays(DayNumber fromDay, DayNumber toDay);
+    void reserveSlots(size_t slots);
+
+    // Builds a row with the bits of the given rooms set, rooms without a slot are ignored
+    std::vector<uint64_t> makeMask(const std::vector<int>& roomIds) const;
+    // Returns the given rooms whose bit is set in the given row, rooms without a slot are always included
+    std::vector<int> roomsInRow(const std::vector<int>& roomIds, const uint64_t* row) const;
+    // Returns the row of the given day or nullptr if the day is outside of the stored range
+    const uint64_t* row(DayNumber day) const;
+
+    std::unordered_map<int, size_t> _roomSlots;
+    size_t _stride = 0;
+    DayNumber _firstDay = 0;
+    DayNumber _numDays = 0;
+    std::vector<uint64_t> _bits;
+  };
+
+} // namespace hotel
+
+#endif // HOTEL_AVAILABILITYBITMAP_H
@@ -0,0 +1,203 @@
+#include "hotel/availabilitysearch.h"
+
+#include <algorithm>
+#include <future>
+#include <limits>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+
+namespace hotel
+{
+  namespace
+  {
+    /**
+     * Runs the search for every element of items and returns the results in the same order. The items are split into
+     * consecutive chunks, one per hardware thread, a single item is searched on the calling thread.
+     */
+    template <class Item, class Search> auto searchAll(std::vector<Item> items, Search search)
+    {
+      using Result = decltype(search(items.front()));
+      std::vector<Result> results(items.size());
+      auto numberOfThreads =
+          std::min(items.size(), static_cast<size_t>(std::max(1u, std::thread::hardware_concurrency())));
+      if (numberOfThreads < 2)
+      {
+        for (size_t i = 0; i < items.size(); ++i)
+          results[i] = search(items[i]);
+        return results;
+      }
+
+      std::vector<std::future<void>> chunks;
+      for (size_t chunk = 0; chunk < numberOfThreads; ++chunk)
+      {
+        auto begin = items.size() * chunk / numberOfThreads;
+        auto end = items.size() * (chunk + 1) / numberOfThreads;
+        chunks.push_back(std::async(std::launch::async, [&, begin, end]() {
+          for (auto i = begin; i < end; ++i)
+            results[i] = search(items[i]);
+        }));
+      }
+      for (auto& chunk : chunks)
+        chunk.get();
+      return results;
+    }
+  } // namespace
+
+  RoomAvailability::RoomAvailability(int roomId, int hotelId, int categoryId, boost::gregorian::date_period dateRange,
+                                     int gapBefore, int gapAfter)
+      : _hotelId(hotelId), _categoryId(categoryId), _dateRange(dateRange), _gapBefore(gapBefore), _gapAfter(gapAfter)
+  {
+    setId(roomId);
+  }
+
+  int RoomAvailability::leftoverGap() const
+  {
+    constexpr auto unbounded = std::numeric_limits<int>::max();
+    if (_gapBefore == unbounded || _gapAfter == unbounded)
+      return unbounded;
+    return _gapBefore + _gapAfter;
+  }
+
+  bool operator==(const RoomAvailability& a, const RoomAvailability& b)
+  {
+    return a.roomId() == b.roomId() && a.hotelId() == b.hotelId() && a.categoryId() == b.categoryId() &&
+           a.dateRange() == b.dateRange() && a.gapBefore() == b.gapBefore() && a.gapAfter() == b.gapAfter();
+  }
+
+  bool operator!=(const RoomAvailability& a, const RoomAvailability& b) { return !(a == b); }
+
+  AvailabilitySearch::AvailabilitySearch(const HotelCollection& hotels, const PlanningBoard& planning)
+      : _hotels(hotels), _planning(planning)
+  {
+  }
+
+  std::vector<RoomAvailability> AvailabilitySearch::findFreeRooms(std::optional<int> hotelId,
+                                                                  std::optional<int> categoryId,
+                                                                  boost::gregorian::date_period period) const
+  {
+    auto searchHotel = [this, period](const HotelRooms& hotelRooms) {
+      std::vector<RoomAvailability> results;
+      auto freeRooms = _planning.getFreeRooms(hotelRooms.roomIds, period);
+      for (size_t i = 0, j = 0; i < hotelRooms.roomIds.size() && j < freeRooms.size(); ++i)
+      {
+        // The free rooms are returned in the same order as they have been requested
+        if (hotelRooms.roomIds[i] == freeRooms[j])
+        {
+          results.push_back(makeResult(hotelRooms.hotelId, freeRooms[j], hotelRooms.categoryIds[i], period));
+          ++j;
+        }
+      }
+      return results;
+    };
+
+    std::vector<RoomAvailability> results;
+    for (auto& hotelResults : searchAll(collectRooms(hotelId, categoryId), searchHotel))
+      std::move(hotelResults.begin(), hotelResults.end(), std::back_inserter(results));
+    rank(results);
+    return results;
+  }
+
+  std::vector<RoomAvailability> AvailabilitySearch::findEarliestFreeRooms(std::optional<int> hotelId,
+                                                                          std::optional<int> categoryId,
+                                                                          boost::gregorian::date earliest,
+                                                                          boost::gregorian::date latest,
+                                                                          int nights) const
+  {
+    using namespace boost::gregorian;
+    auto searchHotel = [this, earliest, latest, nights](const HotelRooms& hotelRooms) {
+      std::vector<RoomAvailability> results;
+      auto run = _planning.findFirstFreeRun(hotelRooms.roomIds, earliest, latest, nights);
+      if (!run)
+        return results;
+
+      date_period period(run->first, run->first + days(nights));
+      auto& freeRooms = run->second;
+      for (size_t i = 0, j = 0; i < hotelRooms.roomIds.size() && j < freeRooms.size(); ++i)
+      {
+        if (hotelRooms.roomIds[i] == freeRooms[j])
+        {
+          results.push_back(makeResult(hotelRooms.hotelId, freeRooms[j], hotelRooms.categoryIds[i], period));
+          ++j;
+        }
+      }
+      return results;
+    };
+
+    // Only keep the rooms of the hotels with the earliest arrival date
+    std::vector<RoomAvailability> results;
+    for (auto& hotelResults : searchAll(collectRooms(hotelId, categoryId), searchHotel))
+    {
+      if (hotelResults.empty())
+        continue;
+      auto arrival = hotelResults.front().dateRange().begin();
+      if (!results.empty() && arrival > results.front().dateRange().begin())
+        continue;
+      if (!results.empty() && arrival < results.front().dateRange().begin())
+        results.clear();
+      std::move(hotelResults.begin(), hotelResults.end(), std::back_inserter(results));
+    }
+    rank(results);
+    return results;
+  }
+
+  std::vector<AvailabilitySearch::HotelRooms> AvailabilitySearch::collectRooms(std::optional<int> hotelId,
+                                                                               std::optional<int> categoryId) const
+  {
+    std::vector<HotelRooms> result;
+    if (categoryId)
+    {
+      // Only visit the rooms of the category, grouped by their hotel
+      std::unordered_map<int, size_t> hotelSlots;
+      for (auto room : _hotels.allRoomsByCategory(*categoryId))
+      {
+        auto hotel = _hotels.findHotelByRoomId(room->id());
+        if (hotel == nullptr || (hotelId && hotel->id() != *hotelId))
+          continue;
+
+        auto slotIt = hotelSlots.emplace(hotel->id(), result.size()).first;
+        if (slotIt->second == result.size())
+          result.push_back(HotelRooms{hotel->id(), {}, {}});
+        result[slotIt->second].roomIds.push_back(room->id());
+        result[slotIt->second].categoryIds.push_back(*categoryId);
+      }
+      return result;
+    }
+
+    for (auto& hotel : _hotels.hotels())
+    {
+      if (hotelId && hotel->id() != *hotelId)
+        continue;
+
+      HotelRooms hotelRooms{hotel->id(), {}, {}};
+      for (auto& room : hotel->rooms())
+      {
+        auto roomCategoryId = room->category() ? room->category()->id() : 0;
+        if (categoryId && roomCategoryId != *categoryId)
+          continue;
+        hotelRooms.roomIds.push_back(room->id());
+        hotelRooms.categoryIds.push_back(roomCategoryId);
+      }
+
+      if (!hotelRooms.roomIds.empty())
+        result.push_back(std::move(hotelRooms));
+    }
+    return result;
+  }
+
+  RoomAvailability AvailabilitySearch::makeResult(int hotelId, int roomId, int categoryId,
+                                                  boost::gregorian::date_period period) const
+  {
+    return RoomAvailability(roomId, hotelId, categoryId, period, _planning.getAvailableDaysBefore(roomId, period.begin()),
+                            _planning.getAvailableDaysFrom(roomId, period.end()));
+  }
+
+  void AvailabilitySearch::rank(std::vector<RoomAvailability>& results)
+  {
+    std::sort(results.begin(), results.end(), [](const RoomAvailability& a, const RoomAvailability& b) {
+      return std::make_tuple(a.leftoverGap(), a.hotelId(), a.roomId()) <
+             std::make_tuple(b.leftoverGap(), b.hotelId(), b.roomId());
+    });
+  }
+
+} // namespace hotel
@@ -0,0 +1,108 @@
+#ifndef HOTEL_AVAILABILITYSEARCH_H
+#define HOTEL_AVAILABILITYSEARCH_H
+
+#include "hotel/hotelcollection.h"
+#include "hotel/persistentobject.h"
+#include "hotel/planning.h"
+
+#include <boost/date_time.hpp>
+
+#include <optional>
+#include <vector>
+
+namespace hotel
+{
+  /**
+   * @brief The RoomAvailability class is one result of an availability search: a room which is free for a given period
+   *
+   * The id of a RoomAvailability is the id of the room.
+   *
+   * @see AvailabilitySearch
+   */
+  class RoomAvailability : public PersistentObject
+  {
+  public:
+    RoomAvailability(int roomId, int hotelId, int categoryId, boost::gregorian::date_period dateRange, int gapBefore,
+                     int gapAfter);
+
+    int roomId() const { return id(); }
+    int hotelId() const { return _hotelId; }
+    int categoryId() const { return _categoryId; }
+    boost::gregorian::date_period dateRange() const { return _dateRange; }
+
+    //! Returns the number of free days between the previous reservation and the period (max if there is none)
+    int gapBefore() const { return _gapBefore; }
+    //! Returns the number of free days between the period and the next reservation (max if there is none)
+    int gapAfter() const { return _gapAfter; }
+    //! Returns the number of free days left around the period if the room is booked for it (max if unbounded)
+    int leftoverGap() const;
+
+  private:
+    int _hotelId;
+    int _categoryId;
+    boost::gregorian::date_period _dateRange;
+    int _gapBefore;
+    int _gapAfter;
+  };
+
+  bool operator==(const RoomAvailability& a, const RoomAvailability& b);
+  bool operator!=(const RoomAvailability& a, const RoomAvailability& b);
+
+  /**
+   * @brief The AvailabilitySearch class answers availability questions over all rooms of a hotel collection
+   *
+   * The results are ranked by their leftover gap, smallest first (i.e. a best fit strategy): booking a room whose free
+   * gap is just large enough for the requested period leaves the least fragmented, hard to sell days behind. Ties are
+   * broken by hotel and room id.
+   *
+   * The hotels are searched in parallel, on at most one thread per hardware thread; a search within a single hotel runs
+   * on the calling thread. The search only reads from the hotel collection and the planning board, which must not be
+   * modified while a search is running.
+   */
+  class AvailabilitySearch
+  {
+  public:
+    AvailabilitySearch(const HotelCollection& hotels, const PlanningBoard& planning);
+
+    /**
+     * @brief findFreeRooms returns all rooms which are free during the given period
+     * @param hotelId Only consider rooms of this hotel, all hotels if not set
+     * @param categoryId Only consider rooms of this category, all categories if not set
+     * @param period The period for which the room must be free
+     * @return The free rooms, ranked
+     */
+    std::vector<RoomAvailability> findFreeRooms(std::optional<int> hotelId, std::optional<int> categoryId,
+                                                boost::gregorian::date_period period) const;
+
+    /**
+     * @brief findEarliestFreeRooms searches for the earliest arrival date in [earliest, latest] at which a room is free
+     *        for the given number of nights
+     * @param hotelId Only consider rooms of this hotel, all hotels if not set
+     * @param categoryId Only consider rooms of this category, all categories if not set
+     * @return All rooms which are free from the earliest possible arrival date on, ranked. If there is no such date,
+     *         an empty list is returned.
+     */
+    std::vector<RoomAvailability> findEarliestFreeRooms(std::optional<int> hotelId, std::optional<int> categoryId,
+                                                        boost::gregorian::date earliest, boost::gregorian::date latest,
+                                                        int nights) const;
+
+  private:
+    struct HotelRooms
+    {
+      int hotelId;
+      std::vector<int> roomIds;
+      std::vector<int> categoryIds;
+    };
+
+    // Collects the rooms matching the filter, grouped by hotel
+    std::vector<HotelRooms> collectRooms(std::optional<int> hotelId, std::optional<int> categoryId) const;
+    RoomAvailability makeResult(int hotelId, int roomId, int categoryId, boost::gregorian::date_period period) const;
+    static void rank(std::vector<RoomAvailability>& results);
+
+    const HotelCollection& _hotels;
+    const PlanningBoard& _planning;
+  };
+
+} // namespace hotel
+
+#endif // HOTEL_AVAILABILITYSEARCH_H
@@ -0,0 +1,202 @@
+#include "hotel/batchvalidator.h"
+
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <map>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+
+namespace hotel
+{
+  namespace
+  {
+    // Below this number of atoms, starting threads costs more than sweeping the rooms
+    constexpr size_t parallelThreshold = 4096;
+
+    boost::gregorian::date_period overlap(DayNumber aFrom, DayNumber aTo, DayNumber bFrom, DayNumber bTo)
+    {
+      return boost::gregorian::date_period(fromDayNumber(std::max(aFrom, bFrom)), fromDayNumber(std::min(aTo, bTo)));
+    }
+  } // namespace
+
+  bool operator==(const ReservationConflict& a, const ReservationConflict& b)
+  {
+    return a.kind == b.kind && a.candidate == b.candidate && a.otherCandidate == b.otherCandidate &&
+           a.existing == b.existing && a.roomId == b.roomId && a.period == b.period;
+  }
+
+  bool operator!=(const ReservationConflict& a, const ReservationConflict& b) { return !(a == b); }
+
+  BatchValidator::BatchValidator(const PlanningBoard& planning) : _planning(planning) {}
+
+  std::vector<ReservationConflict> BatchValidator::validate(const std::vector<const Reservation*>& reservations) const
+  {
+    return validate(reservations, {});
+  }
+
+  std::vector<ReservationConflict> BatchValidator::validate(const std::vector<const Reservation*>& reservations,
+                                                            const std::vector<const Reservation*>& ignored) const
+  {
+    std::vector<ReservationConflict> conflicts;
+    AtomSet ignoredAtoms;
+    for (auto reservation : ignored)
+      for (auto& atom : reservation->atoms())
+        ignoredAtoms.insert(&atom);
+
+    // Group the atoms of the batch by room
+    std::map<int, std::vector<CandidateAtom>> atomsByRoom;
+    size_t numberOfAtoms = 0;
+    for (size_t i = 0; i < reservations.size(); ++i)
+    {
+      auto& reservation = *reservations[i];
+      if (!reservation.isValid())
+      {
+        conflicts.push_back({ReservationConflict::Kind::InvalidReservation, i});
+        continue;
+      }
+
+      for (auto& atom : reservation.atoms())
+        atomsByRoom[atom.roomId()].push_back({atom.fromDay(), atom.toDay(), i});
+      numberOfAtoms += reservation.atoms().size();
+    }
+
+    std::vector<RoomAtoms> rooms;
+    rooms.reserve(atomsByRoom.size());
+    for (auto& roomAtoms : atomsByRoom)
+      rooms.push_back({roomAtoms.first, std::move(roomAtoms.second)});
+
+    // Sweep the rooms, in parallel for large batches. The chunks are consecutive, so that the order of the results
+    // does not depend on the number of threads.
+    std::vector<PendingConflict> pending;
+    auto numberOfThreads = static_cast<size_t>(std::max(1u, std::thread::hardware_concurrency()));
+    if (numberOfAtoms < parallelThreshold || numberOfThreads < 2 || rooms.size() < 2)
+    {
+      pending = sweepRooms(rooms.begin(), rooms.end(), ignoredAtoms);
+    }
+    else
+    {
+      std::vector<std::future<std::vector<PendingConflict>>> sweeps;
+      auto atomsPerChunk = numberOfAtoms / numberOfThreads + 1;
+      auto chunkBegin = rooms.begin();
+      size_t chunkAtoms = 0;
+      for (auto it = rooms.begin(); it != rooms.end(); ++it)
+      {
+        chunkAtoms += it->atoms.size();
+        if (chunkAtoms >= atomsPerChunk || it + 1 == rooms.end())
+        {
+          sweeps.push_back(std::async(std::launch::async, &BatchValidator::sweepRooms, this, chunkBegin, it + 1,
+                                      std::cref(ignoredAtoms)));
+          chunkBegin = it + 1;
+          chunkAtoms = 0;
+        }
+      }
+      for (auto& sweep : sweeps)
+      {
+        auto chunkConflicts = sweep.get();
+        std::move(chunkConflicts.begin(), chunkConflicts.end(), std::back_inserter(pending));
+      }
+    }
+
+    // The room index only holds the atoms, their reservations are looked up in the atom columns of the board. The
+    // atoms of a room on the board do not overlap, thus only the owner of the conflicting atom itself is found.
+    std::unordered_map<const ReservationAtom*, const Reservation*> reservationOfAtom;
+    conflicts.reserve(conflicts.size() + pending.size());
+    for (auto& item : pending)
+    {
+      if (auto atom = item.existingAtom)
+      {
+        auto it = reservationOfAtom.find(atom);
+        if (it == reservationOfAtom.end())
+        {
+          const Reservation* owner = nullptr;
+          for (auto reservation : _planning.getReservationsInRooms(atom->roomId(), atom->roomId(), atom->dateRange()))
+            if (std::any_of(reservation->atoms().begin(), reservation->atoms().end(),
+                            [atom](auto& ownAtom) { return &ownAtom == atom; }))
+              owner = reservation;
+          it = reservationOfAtom.emplace(atom, owner).first;
+        }
+        item.conflict.existing = it->second;
+      }
+      conflicts.push_back(item.conflict);
+    }
+
+    std::sort(conflicts.begin(), conflicts.end(), [](auto& x, auto& y) {
+      auto key = [](auto& conflict) {
+        return std::make_tuple(conflict.candidate, conflict.roomId, conflict.period.begin(), conflict.period.end(),
+                               conflict.kind, conflict.otherCandidate.value_or(0));
+      };
+      return key(x) < key(y);
+    });
+    return conflicts;
+  }
+
+  std::vector<ReservationConflict> BatchValidator::validate(const std::vector<Reservation>& reservations) const
+  {
+    std::vector<const Reservation*> pointers;
+    pointers.reserve(reservations.size());
+    for (auto& reservation : reservations)
+      pointers.push_back(&reservation);
+    return validate(pointers);
+  }
+
+  std::vector<BatchValidator::PendingConflict> BatchValidator::sweepRooms(std::vector<RoomAtoms>::iterator begin,
+                                                                          std::vector<RoomAtoms>::iterator end,
+                                                                          const AtomSet& ignoredAtoms) const
+  {
+    std::vector<PendingConflict> conflicts;
+    for (auto it = begin; it != end; ++it)
+      sweepRoom(*it, ignoredAtoms, conflicts);
+    return conflicts;
+  }
+
+  void BatchValidator::sweepRoom(RoomAtoms& room, const AtomSet& ignoredAtoms,
+                                 std::vector<PendingConflict>& conflicts) const
+  {
+    auto& atoms = room.atoms;
+    std::sort(atoms.begin(), atoms.end(), [](auto& x, auto& y) {
+      return x.fromDay < y.fromDay || (x.fromDay == y.fromDay && x.candidate < y.candidate);
+    });
+
+    static const std::vector<RoomAtomIndex::Entry> noEntries;
+    auto roomIndex = _planning.roomIndex(room.roomId);
+    auto& entries = roomIndex ? roomIndex->entries() : noEntries;
+
+    // The atoms of the batch which have begun, but not yet ended at the current day
+    std::vector<CandidateAtom> active;
+    // The first atom of the board ending after the current day, the atoms of the board are sorted and do not overlap
+    size_t firstEntry = 0;
+    for (auto& atom : atoms)
+    {
+      active.erase(std::remove_if(active.begin(), active.end(), [&](auto& x) { return x.toDay <= atom.fromDay; }),
+                   active.end());
+      for (auto& other : active)
+      {
+        // Atoms of the same reservation never overlap if the reservation is valid, but may share a room
+        if (other.candidate == atom.candidate)
+          continue;
+        ReservationConflict conflict{ReservationConflict::Kind::ConflictInBatch,
+                                     std::min(other.candidate, atom.candidate),
+                                     std::max(other.candidate, atom.candidate)};
+        conflict.roomId = room.roomId;
+        conflict.period = overlap(other.fromDay, other.toDay, atom.fromDay, atom.toDay);
+        conflicts.push_back({conflict, nullptr});
+      }
+      active.push_back(atom);
+
+      while (firstEntry < entries.size() && entries[firstEntry].toDay <= atom.fromDay)
+        ++firstEntry;
+      for (auto i = firstEntry; i < entries.size() && entries[i].fromDay < atom.toDay; ++i)
+      {
+        if (!ignoredAtoms.empty() && ignoredAtoms.count(entries[i].atom) != 0)
+          continue;
+        ReservationConflict conflict{ReservationConflict::Kind::ConflictWithBoard, atom.candidate};
+        conflict.roomId = room.roomId;
+        conflict.period = overlap(entries[i].fromDay, entries[i].toDay, atom.fromDay, atom.toDay);
+        conflicts.push_back({conflict, entries[i].atom});
+      }
+    }
+  }
+
+} // namespace hotel
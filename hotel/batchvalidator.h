@@ -0,0 +1,111 @@
+#ifndef HOTEL_BATCHVALIDATOR_H
+#define HOTEL_BATCHVALIDATOR_H
+
+#include "hotel/planning.h"
+#include "hotel/reservation.h"
+
+#include <boost/date_time.hpp>
+
+#include <optional>
+#include <unordered_set>
+#include <vector>
+
+namespace hotel
+{
+  /**
+   * @brief The ReservationConflict struct describes why a reservation of a batch cannot be added to the planning board
+   * @see BatchValidator
+   */
+  struct ReservationConflict
+  {
+    enum class Kind
+    {
+      //! The reservation itself is not valid (see Reservation::isValid), roomId and period are not set
+      InvalidReservation,
+      //! The reservation overlaps with another reservation of the batch, see otherCandidate
+      ConflictInBatch,
+      //! The reservation overlaps with a reservation already on the planning board, see existing
+      ConflictWithBoard
+    };
+
+    Kind kind;
+    //! The index of the reservation within the batch
+    size_t candidate;
+    //! The index of the other reservation of the batch (ConflictInBatch only), always greater than candidate
+    std::optional<size_t> otherCandidate = std::nullopt;
+    //! The reservation on the board (ConflictWithBoard only)
+    const Reservation* existing = nullptr;
+    int roomId = 0;
+    //! The days on which both reservations occupy the room
+    boost::gregorian::date_period period{boost::gregorian::date(), boost::gregorian::date()};
+  };
+
+  bool operator==(const ReservationConflict& a, const ReservationConflict& b);
+  bool operator!=(const ReservationConflict& a, const ReservationConflict& b);
+
+  /**
+   * @brief The BatchValidator class checks a whole batch of reservations against a planning board at once
+   *
+   * Unlike PlanningBoard::canAddReservation(), which checks one reservation at a time and stops at the first problem,
+   * the validator reports every conflicting pair: among the reservations of the batch as well as between the batch and
+   * the board. The atoms of the batch are grouped by room and sorted once, then a single sweep per room finds the
+   * overlaps within the batch and merges the atoms with the (already sorted) room index of the board. This is
+   * O(k log k + n + c) for k new atoms, n atoms on the board in the affected rooms and c conflicts.
+   *
+   * Large batches are validated in parallel, each thread sweeping a share of the rooms. The validator only reads from
+   * the planning board, which must not be modified during a validation.
+   *
+   * @see PlanningBoard::addReservations
+   */
+  class BatchValidator
+  {
+  public:
+    explicit BatchValidator(const PlanningBoard& planning);
+
+    /**
+     * @brief validate checks if all of the given reservations can be added to the planning board together
+     * @return All conflicts, ordered by the index of the reservation within the batch, the room and the conflicting
+     *         period. An empty list means that the batch can be added.
+     */
+    std::vector<ReservationConflict> validate(const std::vector<const Reservation*>& reservations) const;
+    std::vector<ReservationConflict> validate(const std::vector<Reservation>& reservations) const;
+    /**
+     * @brief validate checks the given reservations as if the ignored reservations had been removed from the board
+     *
+     * This validates a batch which replaces reservations of the board (e.g. updates of them), without modifying it.
+     * The cost of the validation grows by O(i) for i ignored atoms.
+     */
+    std::vector<ReservationConflict> validate(const std::vector<const Reservation*>& reservations,
+                                              const std::vector<const Reservation*>& ignored) const;
+
+  private:
+    struct CandidateAtom
+    {
+      DayNumber fromDay;
+      DayNumber toDay;
+      size_t candidate;
+    };
+    struct RoomAtoms
+    {
+      int roomId;
+      std::vector<CandidateAtom> atoms;
+    };
+    // Conflict with the board, the reservation of the atom is looked up once all rooms have been swept
+    struct PendingConflict
+    {
+      ReservationConflict conflict;
+      const ReservationAtom* existingAtom;
+    };
+
+    typedef std::unordered_set<const ReservationAtom*> AtomSet;
+
+    std::vector<PendingConflict> sweepRooms(std::vector<RoomAtoms>::iterator begin,
+                                            std::vector<RoomAtoms>::iterator end, const AtomSet& ignoredAtoms) const;
+    void sweepRoom(RoomAtoms& room, const AtomSet& ignoredAtoms, std::vector<PendingConflict>& conflicts) const;
+
+    const PlanningBoard& _planning;
+  };
+
+} // namespace hotel
+
+#endif // HOTEL_BATCHVALIDATOR_H
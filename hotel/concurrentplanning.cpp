@@ -0,0 +1,194 @@
+#include "hotel/concurrentplanning.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace hotel
+{
+  ConcurrentPlanningBoard::ConcurrentPlanningBoard(size_t numberOfStripes)
+      : _stripes(std::max<size_t>(numberOfStripes, 1)), _idShards(std::max<size_t>(numberOfStripes, 1))
+  {
+  }
+
+  std::shared_ptr<const Reservation> ConcurrentPlanningBoard::tryAddReservation(const Reservation& reservation)
+  {
+    if (!reservation.isValid())
+      throw std::invalid_argument(std::string("cannot add invalid reservation ").append(reservation.description()));
+    if (reservation.id() == 0)
+      throw std::invalid_argument(std::string("cannot add reservation ").append(reservation.description()) +
+                                  " without id to a concurrent planning board");
+
+    auto stored = std::make_shared<const Reservation>(reservation);
+    auto stripes = stripesOf(*stored);
+
+    // Validate optimistically under shared locks, without blocking the readers of the stripes
+    std::vector<uint64_t> versions;
+    versions.reserve(stripes.size());
+    for (auto index : stripes)
+    {
+      auto& stripe = _stripes[index];
+      std::shared_lock<std::shared_mutex> lock(stripe.mutex);
+      if (!isFreeInStripe(*stored, index))
+        return nullptr;
+      versions.push_back(stripe.version);
+    }
+
+    // Lock the stripes in ascending order, thus threads locking overlapping sets of stripes cannot deadlock
+    std::vector<std::unique_lock<std::shared_mutex>> locks;
+    locks.reserve(stripes.size());
+    for (auto index : stripes)
+      locks.emplace_back(_stripes[index].mutex);
+
+    for (size_t i = 0; i < stripes.size(); ++i)
+    {
+      if (_stripes[stripes[i]].version == versions[i])
+        continue;
+
+      // Another thread modified the stripe in between, the validation has to be repeated
+      _numberOfRetries.fetch_add(1, std::memory_order_relaxed);
+      if (!isFreeInStripe(*stored, stripes[i]))
+        return nullptr;
+    }
+
+    auto& shard = idShard(stored->id());
+    {
+      std::lock_guard<std::mutex> idLock(shard.mutex);
+      if (!shard.reservations.emplace(stored->id(), stored).second)
+        throw std::logic_error(std::string("cannot add reservation ").append(stored->description()) + ", its id " +
+                               std::to_string(stored->id()) + " is already on the planning board");
+    }
+
+    for (auto& atom : stored->atoms())
+      _stripes[stripeIndex(atom.roomId())].rooms[atom.roomId()].insert(&atom);
+    for (auto index : stripes)
+      ++_stripes[index].version;
+    _numberOfReservations.fetch_add(1, std::memory_order_relaxed);
+    return stored;
+  }
+
+  std::shared_ptr<const Reservation> ConcurrentPlanningBoard::removeReservation(int reservationId)
+  {
+    // The stripes have to be locked before the id shard, thus look up the reservation first. The shared pointer keeps
+    // the reservation alive, even if another thread removes it in the meantime.
+    auto reservation = getReservationById(reservationId);
+    if (reservation == nullptr)
+      return nullptr;
+
+    auto stripes = stripesOf(*reservation);
+    std::vector<std::unique_lock<std::shared_mutex>> locks;
+    locks.reserve(stripes.size());
+    for (auto index : stripes)
+      locks.emplace_back(_stripes[index].mutex);
+
+    auto& shard = idShard(reservationId);
+    {
+      std::lock_guard<std::mutex> idLock(shard.mutex);
+      auto it = shard.reservations.find(reservationId);
+      if (it == shard.reservations.end() || it->second != reservation)
+        return nullptr;
+      shard.reservations.erase(it);
+    }
+
+    for (auto& atom : reservation->atoms())
+    {
+      auto& stripe = _stripes[stripeIndex(atom.roomId())];
+      auto roomIt = stripe.rooms.find(atom.roomId());
+      roomIt->second.remove(&atom);
+      if (roomIt->second.empty())
+        stripe.rooms.erase(roomIt);
+    }
+    for (auto index : stripes)
+      ++_stripes[index].version;
+    _numberOfReservations.fetch_sub(1, std::memory_order_relaxed);
+    return reservation;
+  }
+
+  void ConcurrentPlanningBoard::clear()
+  {
+    std::vector<std::unique_lock<std::shared_mutex>> locks;
+    locks.reserve(_stripes.size());
+    for (auto& stripe : _stripes)
+      locks.emplace_back(stripe.mutex);
+
+    for (auto& stripe : _stripes)
+    {
+      stripe.rooms.clear();
+      ++stripe.version;
+    }
+    for (auto& shard : _idShards)
+    {
+      std::lock_guard<std::mutex> idLock(shard.mutex);
+      shard.reservations.clear();
+    }
+    _numberOfReservations.store(0, std::memory_order_relaxed);
+  }
+
+  bool ConcurrentPlanningBoard::canAddReservation(const Reservation& reservation) const
+  {
+    if (!reservation.isValid())
+      return false;
+
+    // Take all shared locks at once, so that the result is consistent for reservations spanning multiple stripes
+    std::vector<std::shared_lock<std::shared_mutex>> locks;
+    auto stripes = stripesOf(reservation);
+    for (auto index : stripes)
+      locks.emplace_back(_stripes[index].mutex);
+    return std::all_of(stripes.begin(), stripes.end(),
+                       [&](size_t index) { return isFreeInStripe(reservation, index); });
+  }
+
+  bool ConcurrentPlanningBoard::isFree(int roomId, boost::gregorian::date_period period) const
+  {
+    auto& stripe = _stripes[stripeIndex(roomId)];
+    std::shared_lock<std::shared_mutex> lock(stripe.mutex);
+    auto roomIt = stripe.rooms.find(roomId);
+    return roomIt == stripe.rooms.end() || roomIt->second.isFree(period);
+  }
+
+  std::shared_ptr<const Reservation> ConcurrentPlanningBoard::getReservationById(int id) const
+  {
+    auto& shard = idShard(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.reservations.find(id);
+    return it == shard.reservations.end() ? nullptr : it->second;
+  }
+
+  std::vector<std::shared_ptr<const Reservation>> ConcurrentPlanningBoard::reservations() const
+  {
+    std::vector<std::shared_ptr<const Reservation>> result;
+    result.reserve(numberOfReservations());
+    for (auto& shard : _idShards)
+    {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      for (auto& entry : shard.reservations)
+        result.push_back(entry.second);
+    }
+    return result;
+  }
+
+  std::vector<size_t> ConcurrentPlanningBoard::stripesOf(const Reservation& reservation) const
+  {
+    std::vector<size_t> stripes;
+    for (auto& atom : reservation.atoms())
+      stripes.push_back(stripeIndex(atom.roomId()));
+    std::sort(stripes.begin(), stripes.end());
+    stripes.erase(std::unique(stripes.begin(), stripes.end()), stripes.end());
+    return stripes;
+  }
+
+  bool ConcurrentPlanningBoard::isFreeInStripe(const Reservation& reservation, size_t stripe) const
+  {
+    auto& rooms = _stripes[stripe].rooms;
+    for (auto& atom : reservation.atoms())
+    {
+      if (stripeIndex(atom.roomId()) != stripe)
+        continue;
+      auto roomIt = rooms.find(atom.roomId());
+      if (roomIt != rooms.end() && !roomIt->second.isFree(atom.dateRange()))
+        return false;
+    }
+    return true;
+  }
+
+} // namespace hotel
@@ -0,0 +1,106 @@
+#ifndef HOTEL_CONCURRENTPLANNING_H
+#define HOTEL_CONCURRENTPLANNING_H
+
+#include "hotel/reservation.h"
+#include "hotel/roomatomindex.h"
+
+#include <boost/date_time.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace hotel
+{
+  /**
+   * @brief The ConcurrentPlanningBoard class is a planning board which can be used by many threads at once
+   *
+   * The rooms are distributed over a fixed number of stripes, each of them guarded by its own reader/writer lock and
+   * tagged with a version which is increased by every modification. Threads working on different stripes never block
+   * each other.
+   *
+   * Adding a reservation is optimistic: the reservation is validated under shared locks, one stripe at a time, and the
+   * versions of the stripes are remembered. Then the exclusive locks of all affected stripes are taken, always in the
+   * order of the stripes, which rules out deadlocks. If none of the versions has changed in between, the reservation is
+   * inserted right away, otherwise it is validated again under the exclusive locks. Thus the check and the insertion
+   * of a reservation are atomic, also for reservations whose atoms span multiple rooms and stripes.
+   *
+   * Unlike PlanningBoard, every reservation needs a unique id, which is used to find it again. The reservations are
+   * immutable once they have been added and are handed out as shared pointers, which remain valid after the
+   * reservation has been removed from the board.
+   *
+   * @see PlanningBoard
+   */
+  class ConcurrentPlanningBoard
+  {
+  public:
+    static constexpr size_t defaultNumberOfStripes = 64;
+
+    explicit ConcurrentPlanningBoard(size_t numberOfStripes = defaultNumberOfStripes);
+    ConcurrentPlanningBoard(const ConcurrentPlanningBoard& that) = delete;
+    ConcurrentPlanningBoard& operator=(const ConcurrentPlanningBoard& that) = delete;
+
+    /**
+     * @brief tryAddReservation adds a copy of the given reservation, if there is availability for all of its atoms
+     *
+     * The availability check and the insertion are atomic. If the reservation is not valid or its id is 0,
+     * std::invalid_argument is thrown. If a reservation with the same id is already on the board, std::logic_error is
+     * thrown.
+     *
+     * @return the added reservation, or nullptr if it overlaps with other reservations
+     */
+    std::shared_ptr<const Reservation> tryAddReservation(const Reservation& reservation);
+    /**
+     * @brief removeReservation removes the reservation with the given id
+     * @return the removed reservation, or nullptr if there is no such reservation
+     */
+    std::shared_ptr<const Reservation> removeReservation(int reservationId);
+    void clear();
+
+    //! @brief canAddReservation returns true if there is availability for the whole reservation at the time of the call
+    bool canAddReservation(const Reservation& reservation) const;
+    //! @brief isFree returns true if the given room is not occupied during the given period
+    bool isFree(int roomId, boost::gregorian::date_period period) const;
+
+    std::shared_ptr<const Reservation> getReservationById(int id) const;
+    //! @brief reservations returns all reservations, the result is not a consistent snapshot if other threads write
+    std::vector<std::shared_ptr<const Reservation>> reservations() const;
+    size_t numberOfReservations() const { return _numberOfReservations.load(std::memory_order_relaxed); }
+
+    //! @brief numberOfRetries returns how often an optimistic validation had to be repeated, for statistics
+    uint64_t numberOfRetries() const { return _numberOfRetries.load(std::memory_order_relaxed); }
+
+  private:
+    struct Stripe
+    {
+      mutable std::shared_mutex mutex;
+      uint64_t version = 0;
+      std::unordered_map<int, RoomAtomIndex> rooms;
+    };
+
+    struct IdShard
+    {
+      mutable std::mutex mutex;
+      std::unordered_map<int, std::shared_ptr<const Reservation>> reservations;
+    };
+
+    size_t stripeIndex(int roomId) const { return static_cast<uint32_t>(roomId) % _stripes.size(); }
+    IdShard& idShard(int id) const { return _idShards[static_cast<uint32_t>(id) % _idShards.size()]; }
+    //! Returns the sorted indexes of the stripes of all rooms of the given reservation
+    std::vector<size_t> stripesOf(const Reservation& reservation) const;
+    //! Returns true if all atoms of the reservation located in the given stripe are free, the stripe must be locked
+    bool isFreeInStripe(const Reservation& reservation, size_t stripe) const;
+
+    std::vector<Stripe> _stripes;
+    mutable std::vector<IdShard> _idShards;
+    std::atomic<size_t> _numberOfReservations{0};
+    std::atomic<uint64_t> _numberOfRetries{0};
+  };
+
+} // namespace hotel
+
+#endif // HOTEL_CONCURRENTPLANNING_H
@@ -0,0 +1,41 @@
+#ifndef HOTEL_DAYNUMBER_H
+#define HOTEL_DAYNUMBER_H
+
+#include <boost/date_time.hpp>
+
+#include <cstdint>
+
+namespace hotel
+{
+  /**
+   * @brief A DayNumber is the compact integer encoding of a date used internally by the planning data structures
+   *
+   * The encoding is the day number of boost's gregorian calendar, thus the conversion to and from
+   * boost::gregorian::date is lossless and consecutive days have consecutive day numbers. Day numbers can be compared
+   * and subtracted like plain integers.
+   *
+   * @note Only regular dates are supported, special values (infinities, not_a_date_time) do not keep their ordering.
+   */
+  using DayNumber = int32_t;
+
+  inline DayNumber toDayNumber(boost::gregorian::date date) { return static_cast<DayNumber>(date.day_number()); }
+
+  inline boost::gregorian::date fromDayNumber(DayNumber day)
+  {
+    return boost::gregorian::date(static_cast<boost::gregorian::date::date_int_type>(day));
+  }
+
+  /**
+   * @brief periodsIntersect returns true if the periods [aFrom, aTo) and [bFrom, bTo) intersect
+   * @note This has exactly the same semantics as boost::gregorian::date_period::intersects()
+   */
+  inline bool periodsIntersect(DayNumber aFrom, DayNumber aTo, DayNumber bFrom, DayNumber bTo)
+  {
+    auto aLast = aTo - 1;
+    auto bLast = bTo - 1;
+    return (bFrom >= aFrom && bFrom <= aLast) || (aFrom >= bFrom && aFrom <= bLast) || (bFrom < aFrom && bLast >= aFrom);
+  }
+
+} // namespace hotel
+
+#endif // HOTEL_DAYNUMBER_H
@@ -0,0 +1,79 @@
+#include "hotel/frontdeskindex.h"
+
+#include <cassert>
+
+namespace hotel
+{
+  void FrontDeskIndex::add(const Reservation& reservation)
+  {
+    assert(reservation.isValid());
+    auto [stayIt, inserted] = _stays.emplace(&reservation, Stay());
+    if (!inserted)
+      return;
+
+    auto& stay = stayIt->second;
+    stay.arrival = reservation.firstAtom()->fromDay();
+    stay.departure = reservation.lastAtom()->toDay();
+    stay.arrivalSlot = append(_arrivals, stay.arrival, &reservation);
+    stay.departureSlot = append(_departures, stay.departure, &reservation);
+    stay.inHouseSlots.reserve(static_cast<size_t>(stay.departure - stay.arrival));
+    for (auto day = stay.arrival; day < stay.departure; ++day)
+      stay.inHouseSlots.push_back(append(_inHouse, day, &reservation));
+  }
+
+  void FrontDeskIndex::remove(const Reservation& reservation)
+  {
+    auto stayIt = _stays.find(&reservation);
+    if (stayIt == _stays.end())
+      return;
+
+    auto stay = std::move(stayIt->second);
+    _stays.erase(stayIt);
+    erase(_arrivals, stay.arrival, stay.arrivalSlot, [](Stay& moved) -> uint32_t& { return moved.arrivalSlot; });
+    erase(_departures, stay.departure, stay.departureSlot,
+          [](Stay& moved) -> uint32_t& { return moved.departureSlot; });
+    for (auto day = stay.arrival; day < stay.departure; ++day)
+      erase(_inHouse, day, stay.inHouseSlots[static_cast<size_t>(day - stay.arrival)],
+            [day](Stay& moved) -> uint32_t& { return moved.inHouseSlots[static_cast<size_t>(day - moved.arrival)]; });
+  }
+
+  void FrontDeskIndex::clear()
+  {
+    _stays.clear();
+    _arrivals.clear();
+    _departures.clear();
+    _inHouse.clear();
+  }
+
+  const std::vector<const Reservation*>& FrontDeskIndex::find(const DayLists& lists, DayNumber day)
+  {
+    static const std::vector<const Reservation*> empty;
+    auto it = lists.find(day);
+    return it == lists.end() ? empty : it->second;
+  }
+
+  uint32_t FrontDeskIndex::append(DayLists& lists, DayNumber day, const Reservation* reservation)
+  {
+    auto& list = lists[day];
+    list.push_back(reservation);
+    return static_cast<uint32_t>(list.size() - 1);
+  }
+
+  template <class SlotOf> void FrontDeskIndex::erase(DayLists& lists, DayNumber day, uint32_t slot, SlotOf slotOf)
+  {
+    auto listIt = lists.find(day);
+    assert(listIt != lists.end() && slot < listIt->second.size());
+
+    // The order is unspecified, thus the last reservation of the day can fill the gap
+    auto& list = listIt->second;
+    if (slot + 1 != list.size())
+    {
+      list[slot] = list.back();
+      slotOf(_stays.at(list[slot])) = slot;
+    }
+    list.pop_back();
+    if (list.empty())
+      lists.erase(listIt);
+  }
+
+} // namespace hotel
@@ -0,0 +1,65 @@
+#ifndef HOTEL_FRONTDESKINDEX_H
+#define HOTEL_FRONTDESKINDEX_H
+
+#include "hotel/daynumber.h"
+#include "hotel/reservation.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace hotel
+{
+  /**
+   * @brief The FrontDeskIndex class indexes reservations by the days relevant for the front desk
+   *
+   * For every day the index holds the reservations arriving on that day (the begin of their first atom), departing on
+   * that day (the end of their last atom) and staying in-house during the night of that day (arrival <= day <
+   * departure). All three lists are maintained incrementally, thus the queries are O(1) and the result can be read in
+   * O(k). Adding or removing a reservation costs O(n) in the number of nights of the reservation.
+   *
+   * The order of the reservations within a list is unspecified.
+   *
+   * @see PlanningBoard::setFrontDeskIndexEnabled
+   */
+  class FrontDeskIndex
+  {
+  public:
+    //! @brief add adds the given reservation, which must be valid and not yet in the index
+    void add(const Reservation& reservation);
+    //! @brief remove removes the given reservation, using the days it had when it was added
+    void remove(const Reservation& reservation);
+    void clear();
+
+    const std::vector<const Reservation*>& arrivals(DayNumber day) const { return find(_arrivals, day); }
+    const std::vector<const Reservation*>& departures(DayNumber day) const { return find(_departures, day); }
+    const std::vector<const Reservation*>& inHouse(DayNumber day) const { return find(_inHouse, day); }
+
+  private:
+    using DayLists = std::unordered_map<DayNumber, std::vector<const Reservation*>>;
+
+    // The days of a reservation and its position within each of the lists it is part of
+    struct Stay
+    {
+      DayNumber arrival;
+      DayNumber departure;
+      uint32_t arrivalSlot;
+      uint32_t departureSlot;
+      //! The positions in the in-house lists, by night (starting with the arrival day)
+      std::vector<uint32_t> inHouseSlots;
+    };
+
+    static const std::vector<const Reservation*>& find(const DayLists& lists, DayNumber day);
+    static uint32_t append(DayLists& lists, DayNumber day, const Reservation* reservation);
+    //! Removes the entry at the given slot in O(1), slotOf returns the slot of the entry moved into the gap
+    template <class SlotOf> void erase(DayLists& lists, DayNumber day, uint32_t slot, SlotOf slotOf);
+
+    std::unordered_map<const Reservation*, Stay> _stays;
+    DayLists _arrivals;
+    DayLists _departures;
+    DayLists _inHouse;
+  };
+
+} // namespace hotel
+
+#endif // HOTEL_FRONTDESKINDEX_H
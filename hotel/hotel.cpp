@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <iostream>
 #include <cassert>
+#include <unordered_map>
 
 namespace hotel
 {
@@ -36,17 +37,34 @@ namespace hotel
 
   Hotel &Hotel::operator=(const Hotel &that)
   {
+    if (this == &that) return *this;
+
     PersistentObject::operator=(that);
 
     _name = that._name;
-
-    // Clone categories
+    _categories.clear();
+    _rooms.clear();
+    _categories.reserve(that._categories.size());
+    _rooms.reserve(that._rooms.size());
+
+    // Clone categories, remembering which clone belongs to which original
+    std::unordered_map<const RoomCategory*, const RoomCategory*> clonedCategories;
+    clonedCategories.reserve(that._categories.size());
     for (auto& category : that._categories)
+    {
       _categories.push_back(std::make_unique<hotel::RoomCategory>(*category));
+      clonedCategories[category.get()] = _categories.back().get();
+    }
 
-    // Clone rooms
+    // Clone rooms. The categories are remapped directly, the clones are valid by construction and do not need to be
+    // looked up by their short code.
     for (auto& room : that._rooms)
-      addRoom(std::make_unique<hotel::HotelRoom>(*room), room->category()->shortCode());
+    {
+      auto clonedRoom = std::make_unique<hotel::HotelRoom>(*room);
+      auto categoryIt = clonedCategories.find(room->category());
+      clonedRoom->setCategory(categoryIt != clonedCategories.end() ? categoryIt->second : nullptr);
+      _rooms.push_back(std::move(clonedRoom));
+    }
 
     return *this;
   }
@@ -102,6 +120,19 @@ namespace hotel
     _rooms.push_back(std::move(room));
   }
 
+  void Hotel::addRoom(std::unique_ptr<HotelRoom> room, RoomCategory* category)
+  {
+    if (room == nullptr)
+      throw std::logic_error("Trying to add a nullptr room to the hotel");
+
+    auto isCategory = [category](const std::unique_ptr<RoomCategory>& existing) { return existing.get() == category; };
+    if (category == nullptr || std::none_of(_categories.begin(), _categories.end(), isCategory))
+      throw std::logic_error("Trying to add a room with a category of another hotel");
+
+    room->setCategory(category);
+    _rooms.push_back(std::move(room));
+  }
+
   RoomCategory* Hotel::getCategoryById(int id)
   {
     auto it = std::find_if(_categories.begin(), _categories.end(),
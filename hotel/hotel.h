@@ -53,7 +53,7 @@ namespace hotel
   {
   public:
     Hotel(const std::string& name);
-    //! The copy constructor performs a deep copy of the object
+    //! The copy constructor performs a deep copy of the object, in O(rooms + categories)
     Hotel(const Hotel& that);
     Hotel(Hotel&& that) = default;
     Hotel& operator=(const Hotel& that);
@@ -70,6 +70,8 @@ namespace hotel
 
     void addRoomCategory(std::unique_ptr<RoomCategory> category);
     void addRoom(std::unique_ptr<HotelRoom> room, const std::string& categoryShortCode);
+    //! @brief addRoom adds a room of the given category, which has to be one of the categories of this hotel
+    void addRoom(std::unique_ptr<HotelRoom> room, RoomCategory* category);
 
     RoomCategory* getCategoryById(int id);
     RoomCategory* getCategoryByShortCode(const std::string& shortCode);
@@ -6,7 +6,11 @@ namespace hotel
 {
   HotelCollection::HotelCollection() : _hotels() {}
 
-  HotelCollection::HotelCollection(std::vector<std::unique_ptr<Hotel>> hotel) : _hotels(std::move(hotel)) {}
+  HotelCollection::HotelCollection(std::vector<std::unique_ptr<Hotel>> hotel) : _hotels(std::move(hotel))
+  {
+    for (auto& hotel : _hotels)
+      indexHotel(hotel.get());
+  }
 
   HotelCollection::HotelCollection(const HotelCollection &that)
   {
@@ -18,11 +22,11 @@ namespace hotel
     assert(this != &that);
     if (this == &that) return *this;
 
-    _hotels.clear();
+    clear();
 
     // Deep copy all hotels
     for (auto& hotel : that._hotels)
-      _hotels.push_back(std::make_unique<Hotel>(*hotel));
+      addHotel(std::make_unique<Hotel>(*hotel));
 
     return *this;
   }
@@ -30,17 +34,23 @@ namespace hotel
   HotelCollection& HotelCollection::operator=(HotelCollection&& that)
   {
     _hotels = std::move(that._hotels);
+    _rooms = std::move(that._rooms);
+    _roomsById = std::move(that._roomsById);
+    _roomsByCategory = std::move(that._roomsByCategory);
+    that.clear();
     return *this;
   }
 
   void HotelCollection::addHotel(std::unique_ptr<Hotel> hotel)
   {
+    indexHotel(hotel.get());
     _hotels.push_back(std::move(hotel));
   }
 
   void HotelCollection::clear()
   {
     _hotels.clear();
+    clearIndexes();
   }
 
   const std::vector<std::unique_ptr<Hotel>>& HotelCollection::hotels() const { return _hotels; }
@@ -48,9 +58,9 @@ namespace hotel
   std::vector<int> HotelCollection::allRoomIDs() const
   {
     std::vector<int> roomIds;
-    for (auto& hotel : _hotels)
-      for (auto& room : hotel->rooms())
-        roomIds.push_back(room->id());
+    roomIds.reserve(_rooms.size());
+    for (auto room : _rooms)
+      roomIds.push_back(room->id());
     return roomIds;
   }
 
@@ -65,30 +75,55 @@ namespace hotel
 
   HotelRoom *HotelCollection::findRoomById(int id)
   {
-    for (auto& hotel : _hotels)
-      for (auto& room : hotel->rooms())
-        if (room->id() == id)
-          return room.get();
-    return nullptr;
+    auto it = _roomsById.find(id);
+    return it != _roomsById.end() ? it->second.room : nullptr;
   }
 
-  std::vector<HotelRoom*> HotelCollection::allRooms()
+  const HotelRoom* HotelCollection::findRoomById(int id) const
   {
-    std::vector<hotel::HotelRoom*> rooms;
-    for (auto& hotel : _hotels)
-      for (auto& room : hotel->rooms())
-        rooms.push_back(room.get());
-    return rooms;
+    auto it = _roomsById.find(id);
+    return it != _roomsById.end() ? it->second.room : nullptr;
   }
 
+  const Hotel* HotelCollection::findHotelByRoomId(int roomId) const
+  {
+    auto it = _roomsById.find(roomId);
+    return it != _roomsById.end() ? it->second.hotel : nullptr;
+  }
+
+  std::vector<HotelRoom*> HotelCollection::allRooms() { return _rooms; }
+
   std::vector<HotelRoom*> HotelCollection::allRoomsByCategory(int categoryId)
   {
-    std::vector<hotel::HotelRoom*> rooms;
-    for (auto& hotel : _hotels)
-      for (auto& room : hotel->rooms())
-        if (room->category()->id() == categoryId)
-          rooms.push_back(room.get());
-    return rooms;
+    auto it = _roomsByCategory.find(categoryId);
+    return it != _roomsByCategory.end() ? it->second : std::vector<HotelRoom*>();
+  }
+
+  std::vector<const HotelRoom*> HotelCollection::allRoomsByCategory(int categoryId) const
+  {
+    auto it = _roomsByCategory.find(categoryId);
+    if (it == _roomsByCategory.end())
+      return {};
+    return std::vector<const HotelRoom*>(it->second.begin(), it->second.end());
+  }
+
+  void HotelCollection::indexHotel(Hotel* hotel)
+  {
+    for (auto& room : hotel->rooms())
+    {
+      _rooms.push_back(room.get());
+      // Keep the first room if several rooms share an id, just like the linear search did
+      _roomsById.emplace(room->id(), RoomEntry{room.get(), hotel});
+      if (room->category())
+        _roomsByCategory[room->category()->id()].push_back(room.get());
+    }
+  }
+
+  void HotelCollection::clearIndexes()
+  {
+    _rooms.clear();
+    _roomsById.clear();
+    _roomsByCategory.clear();
   }
 
 } // namespace hotel
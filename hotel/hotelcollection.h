@@ -3,6 +3,7 @@
 
 #include "hotel/hotel.h"
 
+#include <unordered_map>
 #include <vector>
 
 namespace hotel
@@ -10,7 +11,10 @@ namespace hotel
   /**
    * @brief The HotelCollection class holds a list of hotels.
    *
-   * The class also provides utility functions to iterate over the whole collection.
+   * The class also provides utility functions to iterate over the whole collection. The rooms are indexed by id and
+   * by category, thus the lookups do not have to scan all of the hotels.
+   *
+   * @note The indexes are built when a hotel is added. Hotels must not be modified (e.g. get new rooms) afterwards.
    */
   class HotelCollection
   {
@@ -29,13 +33,31 @@ namespace hotel
     std::vector<int> allRoomIDs() const;
     std::vector<int> allCategoryIDs() const;
 
+    //! @brief findRoomById returns the room with the given id in O(1), or nullptr if there is no such room
     hotel::HotelRoom* findRoomById(int id);
+    const hotel::HotelRoom* findRoomById(int id) const;
+    //! @brief findHotelByRoomId returns the hotel of the room with the given id in O(1), or nullptr if there is none
+    const hotel::Hotel* findHotelByRoomId(int roomId) const;
 
     std::vector<hotel::HotelRoom*> allRooms();
     std::vector<hotel::HotelRoom*> allRoomsByCategory(int categoryId);
+    std::vector<const hotel::HotelRoom*> allRoomsByCategory(int categoryId) const;
 
   private:
+    struct RoomEntry
+    {
+      HotelRoom* room;
+      Hotel* hotel;
+    };
+
+    void indexHotel(Hotel* hotel);
+    void clearIndexes();
+
     std::vector<std::unique_ptr<hotel::Hotel>> _hotels;
+    // All rooms in the order of the hotels
+    std::vector<HotelRoom*> _rooms;
+    std::unordered_map<int, RoomEntry> _roomsById;
+    std::unordered_map<int, std::vector<HotelRoom*>> _roomsByCategory;
   };
 
 } // namespace hotel
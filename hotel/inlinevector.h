@@ -0,0 +1,228 @@
+#ifndef HOTEL_INLINEVECTOR_H
+#define HOTEL_INLINEVECTOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+
+namespace hotel
+{
+  /**
+   * @brief The InlineVector class is a vector which stores up to N elements inline, without any allocation
+   *
+   * Only when more than N elements are stored, the elements are moved to a buffer allocated from the memory resource
+   * of the vector. The interface is the subset of std::pmr::vector used by this project, including the allocator
+   * semantics: copies use the default memory resource unless a resource is given, assignments and swaps keep the
+   * resource of the target.
+   *
+   * Since inline elements live within the vector itself, moving a vector holding inline elements copies them, which
+   * changes their addresses. Only elements in an allocated buffer keep their addresses when the vector is moved. A
+   * moved-from vector is always empty.
+   *
+   * @note Only trivially copyable types are supported, which keeps the implementation simple and fast.
+   */
+  template <class T, size_t N> class InlineVector
+  {
+    static_assert(std::is_trivially_copyable_v<T>, "InlineVector only supports trivially copyable types");
+    static_assert(N > 0, "InlineVector needs an inline capacity");
+
+  public:
+    using value_type = T;
+    using allocator_type = std::pmr::polymorphic_allocator<T>;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T&;
+    using const_reference = const T&;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using iterator = T*;
+    using const_iterator = const T*;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    InlineVector() noexcept : _data(inlineData()) {}
+    explicit InlineVector(const allocator_type& allocator) noexcept : _allocator(allocator), _data(inlineData()) {}
+    InlineVector(const InlineVector& that) : InlineVector() { assign(that.begin(), that.end()); }
+    InlineVector(const InlineVector& that, const allocator_type& allocator) : InlineVector(allocator)
+    {
+      assign(that.begin(), that.end());
+    }
+    InlineVector(InlineVector&& that) noexcept : InlineVector(that._allocator) { take(that); }
+    InlineVector(InlineVector&& that, const allocator_type& allocator) : InlineVector(allocator)
+    {
+      if (_allocator == that._allocator)
+        take(that);
+      else
+      {
+        assign(that.begin(), that.end());
+        that.clear();
+      }
+    }
+    ~InlineVector() { release(); }
+
+    InlineVector& operator=(const InlineVector& that)
+    {
+      if (this != &that)
+        assign(that.begin(), that.end());
+      return *this;
+    }
+    InlineVector& operator=(InlineVector&& that)
+    {
+      if (this == &that)
+        return *this;
+      if (_allocator == that._allocator)
+      {
+        release();
+        take(that);
+      }
+      else
+      {
+        assign(that.begin(), that.end());
+        that.clear();
+      }
+      return *this;
+    }
+
+    allocator_type get_allocator() const noexcept { return _allocator; }
+
+    iterator begin() noexcept { return _data; }
+    const_iterator begin() const noexcept { return _data; }
+    const_iterator cbegin() const noexcept { return _data; }
+    iterator end() noexcept { return _data + _size; }
+    const_iterator end() const noexcept { return _data + _size; }
+    const_iterator cend() const noexcept { return _data + _size; }
+    reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+    const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+    reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+    const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+
+    bool empty() const noexcept { return _size == 0; }
+    size_type size() const noexcept { return _size; }
+    size_type capacity() const noexcept { return _capacity; }
+    //! Returns true if the elements are stored inline, i.e. no buffer has been allocated
+    bool isInline() const noexcept { return _data == inlineData(); }
+
+    T* data() noexcept { return _data; }
+    const T* data() const noexcept { return _data; }
+    T& operator[](size_type i) { return _data[i]; }
+    const T& operator[](size_type i) const { return _data[i]; }
+    T& front() { return _data[0]; }
+    const T& front() const { return _data[0]; }
+    T& back() { return _data[_size - 1]; }
+    const T& back() const { return _data[_size - 1]; }
+
+    void reserve(size_type capacity)
+    {
+      if (capacity <= _capacity)
+        return;
+
+      auto data = _allocator.allocate(capacity);
+      std::uninitialized_copy(begin(), end(), data);
+      release();
+      _data = data;
+      _capacity = capacity;
+    }
+
+    void push_back(const T& value)
+    {
+      if (_size == _capacity)
+      {
+        // The value may be an element of this vector, copy it before the storage is reallocated
+        T copy = value;
+        reserve(2 * _capacity);
+        new (_data + _size) T(copy);
+      }
+      else
+        new (_data + _size) T(value);
+      ++_size;
+    }
+
+    void pop_back() { --_size; }
+    void clear() noexcept { _size = 0; }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+      auto position = const_cast<iterator>(first);
+      auto newEnd = std::copy(const_cast<iterator>(last), end(), position);
+      _size = static_cast<size_type>(newEnd - _data);
+      return position;
+    }
+    iterator erase(const_iterator position) { return erase(position, position + 1); }
+
+    //! Swaps the contents of the vectors, which must use the same memory resource
+    void swap(InlineVector& that)
+    {
+      InlineVector tmp(std::move(*this));
+      *this = std::move(that);
+      that = std::move(tmp);
+    }
+
+  private:
+    T* inlineData() noexcept { return std::launder(reinterpret_cast<T*>(_inline)); }
+    const T* inlineData() const noexcept { return std::launder(reinterpret_cast<const T*>(_inline)); }
+
+    template <class Iterator> void assign(Iterator first, Iterator last)
+    {
+      auto size = static_cast<size_type>(std::distance(first, last));
+      if (size > _capacity)
+      {
+        release();
+        _data = _allocator.allocate(size);
+        _capacity = size;
+      }
+      std::uninitialized_copy(first, last, _data);
+      _size = size;
+    }
+
+    // Takes the elements of that, which must use the same memory resource, leaving that empty
+    void take(InlineVector& that) noexcept
+    {
+      if (that.isInline())
+      {
+        std::uninitialized_copy(that.begin(), that.end(), inlineData());
+        _data = inlineData();
+        _capacity = N;
+      }
+      else
+      {
+        _data = that._data;
+        _capacity = that._capacity;
+        that._data = that.inlineData();
+        that._capacity = N;
+      }
+      _size = that._size;
+      that._size = 0;
+    }
+
+    // Frees the allocated buffer, if any, and switches back to the inline storage. The size is left to the caller.
+    void release() noexcept
+    {
+      if (!isInline())
+        _allocator.deallocate(_data, _capacity);
+      _data = inlineData();
+      _capacity = N;
+    }
+
+    allocator_type _allocator;
+    T* _data;
+    size_type _size = 0;
+    size_type _capacity = N;
+    alignas(T) unsigned char _inline[N * sizeof(T)];
+  };
+
+  template <class T, size_t N> bool operator==(const InlineVector<T, N>& a, const InlineVector<T, N>& b)
+  {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end());
+  }
+
+  template <class T, size_t N> bool operator!=(const InlineVector<T, N>& a, const InlineVector<T, N>& b)
+  {
+    return !(a == b);
+  }
+
+} // namespace hotel
+
+#endif // HOTEL_INLINEVECTOR_H
@@ -0,0 +1,216 @@
+#include "hotel/occupancycounters.h"
+
+#include <algorithm>
+
+namespace hotel
+{
+  void DailyCounter::add(DayNumber fromDay, DayNumber toDay, int64_t delta)
+  {
+    if (toDay <= fromDay || delta == 0)
+      return;
+
+    // The end day has to be covered as well, it holds the negative difference
+    reserveDays(fromDay, toDay + 1);
+    addDifference(static_cast<size_t>(fromDay - _firstDay), delta);
+    addDifference(static_cast<size_t>(toDay - _firstDay), -delta);
+  }
+
+  void DailyCounter::clear()
+  {
+    _firstDay = 0;
+    _differences.clear();
+    _tree.clear();
+    _weightedTree.clear();
+  }
+
+  int64_t DailyCounter::at(DayNumber day) const
+  {
+    if (day < _firstDay || day >= _firstDay + static_cast<DayNumber>(_differences.size()))
+      return 0;
+
+    // The value of a day is the prefix sum of the differences
+    int64_t result = 0;
+    for (auto p = static_cast<size_t>(day - _firstDay) + 1; p > 0; p -= p & (~p + 1))
+      result += _tree[p];
+    return result;
+  }
+
+  int64_t DailyCounter::sum(DayNumber fromDay, DayNumber toDay) const
+  {
+    auto size = static_cast<DayNumber>(_differences.size());
+    auto from = std::clamp(fromDay - _firstDay, 0, size);
+    auto to = std::clamp(toDay - _firstDay, 0, size);
+    if (to <= from)
+      return 0;
+    return prefixSum(to) - prefixSum(from);
+  }
+
+  std::vector<int64_t> DailyCounter::calendar(DayNumber fromDay, DayNumber toDay) const
+  {
+    std::vector<int64_t> result;
+    if (toDay <= fromDay)
+      return result;
+
+    result.reserve(static_cast<size_t>(toDay - fromDay));
+    auto endDay = _firstDay + static_cast<DayNumber>(_differences.size());
+    auto value = at(fromDay);
+    result.push_back(value);
+    for (auto day = fromDay + 1; day < toDay; ++day)
+    {
+      if (day >= _firstDay && day < endDay)
+        value += _differences[static_cast<size_t>(day - _firstDay)];
+      result.push_back(value);
+    }
+    return result;
+  }
+
+  int64_t DailyCounter::prefixSum(int64_t n) const
+  {
+    // sum_{p <= n} value(p) = n * sum_{q <= n} d[q] - sum_{q <= n} d[q] * (q - 1)
+    int64_t sum = 0;
+    int64_t weightedSum = 0;
+    for (auto p = static_cast<size_t>(n); p > 0; p -= p & (~p + 1))
+    {
+      sum += _tree[p];
+      weightedSum += _weightedTree[p];
+    }
+    return n * sum - weightedSum;
+  }
+
+  void DailyCounter::reserveDays(DayNumber fromDay, DayNumber toDay)
+  {
+    auto size = static_cast<DayNumber>(_differences.size());
+    if (size == 0)
+    {
+      _firstDay = fromDay;
+      _differences.assign(static_cast<size_t>(toDay - fromDay), 0);
+      rebuildTrees();
+      return;
+    }
+
+    auto endDay = _firstDay + size;
+    if (fromDay >= _firstDay && toDay <= endDay)
+      return;
+
+    // Grow by at least half of the current size, so that a counter growing day by day is not rebuilt over and over
+    auto newFirstDay = fromDay < _firstDay ? std::min(fromDay, _firstDay - size / 2) : _firstDay;
+    auto newEndDay = toDay > endDay ? std::max(toDay, endDay + size / 2) : endDay;
+    std::vector<int64_t> differences(static_cast<size_t>(newEndDay - newFirstDay), 0);
+    std::copy(_differences.begin(), _differences.end(), differences.begin() + (_firstDay - newFirstDay));
+
+    _differences = std::move(differences);
+    _firstDay = newFirstDay;
+    rebuildTrees();
+  }
+
+  void DailyCounter::addDifference(size_t position, int64_t delta)
+  {
+    _differences[position] += delta;
+    auto weightedDelta = delta * static_cast<int64_t>(position);
+    for (auto p = position + 1; p < _tree.size(); p += p & (~p + 1))
+    {
+      _tree[p] += delta;
+      _weightedTree[p] += weightedDelta;
+    }
+  }
+
+  void DailyCounter::rebuildTrees()
+  {
+    // Linear construction: every node passes its sum on to its parent
+    auto n = _differences.size();
+    _tree.assign(n + 1, 0);
+    _weightedTree.assign(n + 1, 0);
+    for (size_t p = 1; p <= n; ++p)
+    {
+      _tree[p] += _differences[p - 1];
+      _weightedTree[p] += _differences[p - 1] * static_cast<int64_t>(p - 1);
+      auto parent = p + (p & (~p + 1));
+      if (parent <= n)
+      {
+        _tree[parent] += _tree[p];
+        _weightedTree[parent] += _weightedTree[p];
+      }
+    }
+  }
+
+  OccupancyCounters::OccupancyCounters(const HotelCollection& hotels)
+  {
+    for (auto& hotel : hotels.hotels())
+      for (auto& room : hotel->rooms())
+        _rooms.emplace(room->id(), RoomAssignment{hotel->id(), room->category() ? room->category()->id() : 0});
+  }
+
+  void OccupancyCounters::occupy(int roomId, DayNumber fromDay, DayNumber toDay) { add(roomId, fromDay, toDay, 1); }
+
+  void OccupancyCounters::release(int roomId, DayNumber fromDay, DayNumber toDay) { add(roomId, fromDay, toDay, -1); }
+
+  void OccupancyCounters::clear()
+  {
+    _hotels.clear();
+    _categories.clear();
+  }
+
+  int OccupancyCounters::occupiedRoomsInHotel(int hotelId, boost::gregorian::date date) const
+  {
+    auto counter = find(_hotels, hotelId);
+    return counter ? static_cast<int>(counter->at(toDayNumber(date))) : 0;
+  }
+
+  int OccupancyCounters::occupiedRoomsInCategory(int categoryId, boost::gregorian::date date) const
+  {
+    auto counter = find(_categories, categoryId);
+    return counter ? static_cast<int>(counter->at(toDayNumber(date))) : 0;
+  }
+
+  std::vector<int> OccupancyCounters::hotelCalendar(int hotelId, boost::gregorian::date_period period) const
+  {
+    return calendar(find(_hotels, hotelId), period);
+  }
+
+  std::vector<int> OccupancyCounters::categoryCalendar(int categoryId, boost::gregorian::date_period period) const
+  {
+    return calendar(find(_categories, categoryId), period);
+  }
+
+  int64_t OccupancyCounters::roomNightsInHotel(int hotelId, boost::gregorian::date_period period) const
+  {
+    auto counter = find(_hotels, hotelId);
+    return counter ? counter->sum(toDayNumber(period.begin()), toDayNumber(period.end())) : 0;
+  }
+
+  int64_t OccupancyCounters::roomNightsInCategory(int categoryId, boost::gregorian::date_period period) const
+  {
+    auto counter = find(_categories, categoryId);
+    return counter ? counter->sum(toDayNumber(period.begin()), toDayNumber(period.end())) : 0;
+  }
+
+  void OccupancyCounters::add(int roomId, DayNumber fromDay, DayNumber toDay, int delta)
+  {
+    auto roomIt = _rooms.find(roomId);
+    if (roomIt == _rooms.end())
+      return;
+
+    _hotels[roomIt->second.hotelId].add(fromDay, toDay, delta);
+    _categories[roomIt->second.categoryId].add(fromDay, toDay, delta);
+  }
+
+  const DailyCounter* OccupancyCounters::find(const std::unordered_map<int, DailyCounter>& counters, int id)
+  {
+    auto it = counters.find(id);
+    return it != counters.end() ? &it->second : nullptr;
+  }
+
+  std::vector<int> OccupancyCounters::calendar(const DailyCounter* counter, boost::gregorian::date_period period)
+  {
+    auto fromDay = toDayNumber(period.begin());
+    auto toDay = toDayNumber(period.end());
+    std::vector<int> result(static_cast<size_t>(std::max(toDay - fromDay, 0)), 0);
+    if (counter)
+    {
+      auto values = counter->calendar(fromDay, toDay);
+      std::transform(values.begin(), values.end(), result.begin(), [](auto x) { return static_cast<int>(x); });
+    }
+    return result;
+  }
+
+} // namespace hotel
@@ -0,0 +1,104 @@
+#ifndef HOTEL_OCCUPANCYCOUNTERS_H
+#define HOTEL_OCCUPANCYCOUNTERS_H
+
+#include "hotel/daynumber.h"
+#include "hotel/hotelcollection.h"
+
+#include <boost/date_time.hpp>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace hotel
+{
+  /**
+   * @brief The DailyCounter class counts a value per day, supporting range updates and range queries
+   *
+   * The counter is a pair of Fenwick trees over the daily differences, which makes adding a value to a whole period as
+   * well as the value of a single day and the sum over a period O(log n). A plain difference array is kept next to the
+   * trees, so that a calendar of consecutive days can be produced with a single tree query. The covered range of days
+   * grows on demand, days outside of it count zero.
+   */
+  class DailyCounter
+  {
+  public:
+    //! @brief add adds delta to every day of [fromDay, toDay)
+    void add(DayNumber fromDay, DayNumber toDay, int64_t delta);
+    void clear();
+
+    //! @brief at returns the value of the given day
+    int64_t at(DayNumber day) const;
+    //! @brief sum returns the sum of the values of all days in [fromDay, toDay)
+    int64_t sum(DayNumber fromDay, DayNumber toDay) const;
+    //! @brief calendar returns the value of every day in [fromDay, toDay)
+    std::vector<int64_t> calendar(DayNumber fromDay, DayNumber toDay) const;
+
+  private:
+    // Sum of the values of the first n days of the covered range
+    int64_t prefixSum(int64_t n) const;
+    void reserveDays(DayNumber fromDay, DayNumber toDay);
+    void addDifference(size_t position, int64_t delta);
+    void rebuildTrees();
+
+    DayNumber _firstDay = 0;
+    // Difference array, _differences[i] is the change from day i - 1 to day i
+    std::vector<int64_t> _differences;
+    // Fenwick trees (1-based) over the differences d[p] and over d[p] * (p - 1)
+    std::vector<int64_t> _tree;
+    std::vector<int64_t> _weightedTree;
+  };
+
+  /**
+   * @brief The OccupancyCounters class counts the number of occupied rooms per day, for every hotel and category
+   *
+   * The counters are maintained incrementally when atoms are added to or removed from the planning board. Each hotel
+   * and each category has a DailyCounter, thus the number of occupied rooms on a day or the number of room nights in a
+   * period are O(log n) and a calendar over a period is O(log n + length of the period).
+   *
+   * The rooms are assigned to their hotels and categories when the counters are created, rooms which are unknown at
+   * this point are not counted.
+   *
+   * @see PlanningBoard::enableOccupancyCounters
+   */
+  class OccupancyCounters
+  {
+  public:
+    explicit OccupancyCounters(const HotelCollection& hotels);
+
+    //! @brief occupy marks the days [fromDay, toDay) of the given room as occupied
+    void occupy(int roomId, DayNumber fromDay, DayNumber toDay);
+    //! @brief release marks the days [fromDay, toDay) of the given room as free
+    void release(int roomId, DayNumber fromDay, DayNumber toDay);
+    void clear();
+
+    int occupiedRoomsInHotel(int hotelId, boost::gregorian::date date) const;
+    int occupiedRoomsInCategory(int categoryId, boost::gregorian::date date) const;
+    //! @brief hotelCalendar returns the number of occupied rooms of the hotel for every day of the period
+    std::vector<int> hotelCalendar(int hotelId, boost::gregorian::date_period period) const;
+    //! @brief categoryCalendar returns the number of occupied rooms of the category for every day of the period
+    std::vector<int> categoryCalendar(int categoryId, boost::gregorian::date_period period) const;
+    //! @brief roomNightsInHotel returns the total number of occupied room nights of the hotel within the period
+    int64_t roomNightsInHotel(int hotelId, boost::gregorian::date_period period) const;
+    //! @brief roomNightsInCategory returns the total number of occupied room nights of the category within the period
+    int64_t roomNightsInCategory(int categoryId, boost::gregorian::date_period period) const;
+
+  private:
+    struct RoomAssignment
+    {
+      int hotelId;
+      int categoryId;
+    };
+
+    void add(int roomId, DayNumber fromDay, DayNumber toDay, int delta);
+    static const DailyCounter* find(const std::unordered_map<int, DailyCounter>& counters, int id);
+    static std::vector<int> calendar(const DailyCounter* counter, boost::gregorian::date_period period);
+
+    std::unordered_map<int, RoomAssignment> _rooms;
+    std::unordered_map<int, DailyCounter> _hotels;
+    std::unordered_map<int, DailyCounter> _categories;
+  };
+
+} // namespace hotel
+
+#endif // HOTEL_OCCUPANCYCOUNTERS_H
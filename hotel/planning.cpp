@@ -21,8 +21,21 @@ namespace hotel
     assert(this != &that);
 
     clear();
+    // The indexes may be in the old arena
+    _indexes.reset();
+    _arena = std::move(that._arena);
     _rooms = std::move(that._rooms);
     _reservations = std::move(that._reservations);
+    _indexes = std::move(that._indexes);
+    that._indexes = that.makeReservationIndexes();
+    _atomColumns = std::move(that._atomColumns);
+    _availability = std::move(that._availability);
+    _occupancy = std::move(that._occupancy);
+    _snapshots = std::move(that._snapshots);
+    _frontDesk = std::move(that._frontDesk);
+    _extentFromDay = that._extentFromDay;
+    _extentToDay = that._extentToDay;
+    _isExtentDirty = that._isExtentDirty;
     that.clear();
 
     return *this;
@@ -33,16 +46,42 @@ namespace hotel
     if (reservation == nullptr)
       throw std::invalid_argument("cannot add nullptr reservation to planning board");
 
-    if (!canAddReservation(*reservation))
-      throw std::logic_error("cannot add reservation " + reservation->description());
+    validateReservations({reservation.get()});
+    return insertReservation(adoptReservation(std::move(reservation)));
+  }
 
-    // Insert reservation and atoms
-    for (auto& atom : reservation->atoms())
-      insertAtom(&atom);
-    auto reservationPtr = reservation.get();
-    _reservations.push_back(std::move(reservation));
+  std::vector<Reservation*> PlanningBoard::addReservations(std::vector<std::unique_ptr<Reservation>> reservations)
+  {
+    std::vector<const Reservation*> batch;
+    batch.reserve(reservations.size());
+    for (auto& reservation : reservations)
+    {
+      if (reservation == nullptr)
+        throw std::invalid_argument("cannot add nullptr reservation to planning board");
+      batch.push_back(reservation.get());
+    }
+    validateReservations(batch);
 
-    return reservationPtr;
+    std::vector<ReservationPtr> newReservations;
+    newReservations.reserve(reservations.size());
+    for (auto& reservation : reservations)
+      newReservations.push_back(adoptReservation(std::move(reservation)));
+    return insertReservations(std::move(newReservations));
+  }
+
+  std::vector<Reservation*> PlanningBoard::addReservations(const std::vector<Reservation>& reservations)
+  {
+    std::vector<const Reservation*> batch;
+    batch.reserve(reservations.size());
+    for (auto& reservation : reservations)
+      batch.push_back(&reservation);
+    validateReservations(batch);
+
+    std::vector<ReservationPtr> newReservations;
+    newReservations.reserve(reservations.size());
+    for (auto& reservation : reservations)
+      newReservations.push_back(makeReservation(reservation));
+    return insertReservations(std::move(newReservations));
   }
 
   void PlanningBoard::removeReservation(const Reservation* reservation)
@@ -50,46 +89,153 @@ namespace hotel
     if (reservation == nullptr)
       throw std::invalid_argument("cannot remove nullptr reservation from planning board");
 
-    // Remove the atoms
-    for (auto& atom : reservation->atoms())
-    {
-      auto& roomAtoms = _rooms[atom.roomId()];
-      auto atomIt = std::find(roomAtoms.begin(), roomAtoms.end(), &atom);
-      if (atomIt != roomAtoms.end())
-        roomAtoms.erase(atomIt);
-    }
-
-    // Find and remove the reservation, then notify the observers
-    auto reservationIt =
-        std::find_if(_reservations.begin(), _reservations.end(), [=](auto& x) { return x.get() == reservation; });
-    if (reservationIt != _reservations.end())
-      _reservations.erase(reservationIt);
+    auto slotIt = _indexes->slots.find(reservation);
+    if (slotIt != _indexes->slots.end())
+      eraseReservationAt(slotIt->second);
   }
 
   void PlanningBoard::removeReservation(int reservationId)
   {
-    // Find the reservation
-    auto reservationIt = std::find_if(_reservations.begin(), _reservations.end(), [=](auto& x) { return x->id() == reservationId; });
-    if (reservationIt != _reservations.end())
+    auto reservationIt = _indexes->byId.find(reservationId);
+    if (reservationIt != _indexes->byId.end())
+      eraseReservationAt(_indexes->slots.at(reservationIt->second));
+  }
+
+  Reservation* PlanningBoard::replaceReservation(const Reservation* reservation, const Reservation& replacement)
+  {
+    if (reservation == nullptr)
+      throw std::invalid_argument("cannot replace nullptr reservation on planning board");
+    auto slotIt = _indexes->slots.find(reservation);
+    if (slotIt == _indexes->slots.end())
+      throw std::invalid_argument(std::string("cannot replace reservation ").append(reservation->description()) +
+                                  ", it is not on the planning board");
+
+    // Validate the replacement against the board without the reservation itself
+    if (!replacement.isValid())
+      throw std::logic_error(
+          std::string("cannot replace reservation with invalid reservation ").append(replacement.description()));
+    for (auto& atom : replacement.atoms())
+    {
+      auto roomIt = _rooms->find(atom.roomId());
+      if (roomIt != _rooms->end() && !roomIt->second->isFree(atom.fromDay(), atom.toDay(), *reservation))
+        throw std::logic_error(std::string("cannot replace reservation ").append(reservation->description()) +
+                               ", the replacement overlaps with other reservations");
+    }
+    auto oldId = reservation->id();
+    auto newId = replacement.id();
+    if (newId != 0 && newId != oldId && _indexes->byId.count(newId) != 0)
+      throw std::logic_error(std::string("cannot replace reservation ").append(reservation->description()) +
+                             ", the id " + std::to_string(newId) + " is already on the planning board");
+
+    auto slot = slotIt->second;
+    auto updated = _reservations[slot].get();
+    if (_snapshots)
     {
-      // First, remove the atoms
-      for (auto& atom : (*reservationIt)->atoms())
+      _snapshots->removeReservation(*updated);
+      // A snapshot still refers to the reservation, thus it is left untouched and replaced by a copy (copy on write)
+      if (isSharedWithSnapshot(_reservations[slot]))
       {
-        auto& roomAtoms = _rooms[atom.roomId()];
-        auto atomIt = std::find(roomAtoms.begin(), roomAtoms.end(), &atom);
-        if (atomIt != roomAtoms.end())
-          roomAtoms.erase(atomIt);
+        eraseReservationAt(slot);
+        return insertReservation(makeReservation(replacement));
+      }
+    }
+    if (_frontDesk)
+      _frontDesk->remove(*updated);
+    auto idIt = _indexes->byId.find(oldId);
+    if (idIt != _indexes->byId.end() && idIt->second == updated)
+      _indexes->byId.erase(idIt);
+
+    // Copy everything but the atoms, those are updated one by one to keep their addresses and index entries
+    auto& atoms = updated->atoms();
+    auto newAtoms = std::move(atoms);
+    *updated = replacement;
+    atoms.swap(newAtoms);
+
+    if (newAtoms.size() > atoms.capacity())
+    {
+      for (auto& atom : atoms)
+        removeAtom(&atom);
+      atoms = newAtoms;
+      for (auto& atom : atoms)
+        insertAtom(&atom);
+    }
+    else
+    {
+      auto oldSize = atoms.size();
+      for (size_t i = 0; i < oldSize; ++i)
+        if (i >= newAtoms.size() || atoms[i].roomId() != newAtoms[i].roomId())
+          removeAtom(&atoms[i]);
+      if (newAtoms.size() < oldSize)
+        atoms.erase(atoms.begin() + static_cast<std::ptrdiff_t>(newAtoms.size()), atoms.end());
+
+      for (size_t i = 0; i < newAtoms.size(); ++i)
+      {
+        if (i >= oldSize)
+        {
+          atoms.push_back(newAtoms[i]);
+          insertAtom(&atoms.back());
+        }
+        else if (atoms[i].roomId() != newAtoms[i].roomId())
+        {
+          atoms[i] = newAtoms[i];
+          insertAtom(&atoms[i]);
+        }
+        else if (atoms[i] != newAtoms[i])
+        {
+          auto oldFromDay = atoms[i].fromDay();
+          atoms[i] = newAtoms[i];
+          moveAtom(&atoms[i], oldFromDay);
+        }
       }
-
-      // Then, remove the reservation
-      _reservations.erase(reservationIt);
     }
+
+    if (newId != 0)
+      _indexes->byId[newId] = updated;
+    _atomColumns.replace(slot, *updated);
+    if (_snapshots)
+      _snapshots->addReservation(_reservations[slot]);
+    if (_frontDesk)
+      _frontDesk->add(*updated);
+    return updated;
+  }
+
+  Reservation* PlanningBoard::replaceReservation(int reservationId, const Reservation& replacement)
+  {
+    auto reservationIt = _indexes->byId.find(reservationId);
+    if (reservationIt == _indexes->byId.end())
+      throw std::invalid_argument("cannot replace reservation " + std::to_string(reservationId) +
+                                  ", it is not on the planning board");
+    return replaceReservation(reservationIt->second, replacement);
   }
 
   void PlanningBoard::clear()
   {
     _reservations.clear();
-    _rooms.clear();
+    if (_arena)
+    {
+      // The reservations and the indexes in the arena do not have to be destroyed one by one, since all of the memory
+      // they own is in the arena. Releasing the arena frees everything at once.
+      _indexes.release();
+      _arena->release();
+      _indexes = makeReservationIndexes();
+    }
+    else
+    {
+      _indexes->slots.clear();
+      _indexes->byId.clear();
+    }
+    _atomColumns.clear();
+    // Existing snapshots keep the old room indexes
+    _rooms = std::make_shared<RoomIndexes>();
+    if (_availability)
+      _availability->clear();
+    if (_occupancy)
+      _occupancy->clear();
+    if (_snapshots)
+      _snapshots->clear();
+    if (_frontDesk)
+      _frontDesk->clear();
+    resetPlanningExtent();
   }
 
   bool PlanningBoard::canAddReservation(const Reservation& reservation) const
@@ -104,32 +250,197 @@ namespace hotel
 
   bool PlanningBoard::isFree(int roomId, boost::gregorian::date_period period) const
   {
-    auto roomIt = _rooms.find(roomId);
-    if (roomIt == _rooms.end())
+    auto roomIt = _rooms->find(roomId);
+    if (roomIt == _rooms->end())
       return true;
 
-    // TODO: This can be made more efficient! log(n) instead of linear
-    auto& roomAtoms = roomIt->second;
-    return std::none_of(roomAtoms.begin(), roomAtoms.end(),
-                        [&period](auto x) { return x->dateRange().intersects(period); });
+    return roomIt->second->isFree(period);
   }
 
   int PlanningBoard::getAvailableDaysFrom(int roomId, boost::gregorian::date date) const
   {
-    auto roomIt = _rooms.find(roomId);
-    if (roomIt == _rooms.end())
+    auto roomIt = _rooms->find(roomId);
+    if (roomIt == _rooms->end())
       return std::numeric_limits<int>::max();
 
-    // Find the first element which would influence the number of available days: i.e.
-    // atom.period.end > date
-    auto& roomAtoms = roomIt->second;
-    auto it = std::upper_bound(roomAtoms.begin(), roomAtoms.end(), date,
-                               [](auto date, auto& x) { return date < x->dateRange().end(); });
+    return roomIt->second->getAvailableDaysFrom(date);
+  }
 
-    if (it == roomAtoms.end())
+  int PlanningBoard::getAvailableDaysBefore(int roomId, boost::gregorian::date date) const
+  {
+    auto roomIt = _rooms->find(roomId);
+    if (roomIt == _rooms->end())
       return std::numeric_limits<int>::max();
+
+    return roomIt->second->getAvailableDaysBefore(date);
+  }
+
+  const RoomAtomIndex* PlanningBoard::roomIndex(int roomId) const
+  {
+    auto roomIt = _rooms->find(roomId);
+    if (roomIt == _rooms->end() || roomIt->second->empty())
+      return nullptr;
+
+    return roomIt->second.get();
+  }
+
+  void PlanningBoard::setArenaAllocationEnabled(bool enabled)
+  {
+    if (enabled == isArenaAllocationEnabled())
+      return;
+    if (!_reservations.empty())
+      throw std::logic_error("cannot change the allocation mode of a planning board which holds reservations");
+    if (enabled && _snapshots)
+      throw std::logic_error("cannot enable arena allocation for a planning board with snapshots enabled");
+
+    // The indexes are moved into the arena or out of it as well
+    _indexes.reset();
+    if (enabled)
+      _arena = std::make_unique<std::pmr::unsynchronized_pool_resource>();
     else
-      return std::max<int>(0, ((*it)->dateRange().begin() - date).days());
+      _arena.reset();
+    _indexes = makeReservationIndexes();
+  }
+
+  void PlanningBoard::setAvailabilityBitmapEnabled(bool enabled)
+  {
+    if (!enabled)
+    {
+      _availability.reset();
+      return;
+    }
+
+    if (_availability)
+      return;
+
+    _availability = std::make_unique<AvailabilityBitmap>();
+    for (auto& room : *_rooms)
+      for (auto& entry : room.second->entries())
+        _availability->occupy(room.first, entry.fromDay, entry.toDay);
+  }
+
+  void PlanningBoard::enableOccupancyCounters(const HotelCollection& hotels)
+  {
+    _occupancy = std::make_unique<OccupancyCounters>(hotels);
+    for (auto& room : *_rooms)
+      for (auto& entry : room.second->entries())
+        _occupancy->occupy(room.first, entry.fromDay, entry.toDay);
+  }
+
+  void PlanningBoard::disableOccupancyCounters() { _occupancy.reset(); }
+
+  void PlanningBoard::setSnapshotsEnabled(bool enabled)
+  {
+    if (!enabled)
+    {
+      _snapshots.reset();
+      return;
+    }
+
+    if (_snapshots)
+      return;
+    if (_arena)
+      throw std::logic_error("cannot enable snapshots for a planning board with arena allocation enabled");
+
+    _snapshots = std::make_unique<SnapshotBuilder>();
+    for (auto& reservation : _reservations)
+      _snapshots->addReservation(reservation);
+  }
+
+  void PlanningBoard::setFrontDeskIndexEnabled(bool enabled)
+  {
+    if (!enabled)
+    {
+      _frontDesk.reset();
+      return;
+    }
+
+    if (_frontDesk)
+      return;
+
+    _frontDesk = std::make_unique<FrontDeskIndex>();
+    for (auto& reservation : _reservations)
+      _frontDesk->add(*reservation);
+  }
+
+  std::vector<const Reservation*> PlanningBoard::getArrivals(boost::gregorian::date date) const
+  {
+    auto day = toDayNumber(date);
+    if (_frontDesk)
+      return _frontDesk->arrivals(day);
+
+    std::vector<const Reservation*> result;
+    for (auto slot : _atomColumns.findOwners(day, day + 1))
+      if (_reservations[slot]->firstAtom()->fromDay() == day)
+        result.push_back(_reservations[slot].get());
+    return result;
+  }
+
+  std::vector<const Reservation*> PlanningBoard::getDepartures(boost::gregorian::date date) const
+  {
+    auto day = toDayNumber(date);
+    if (_frontDesk)
+      return _frontDesk->departures(day);
+
+    // The last night of a departing reservation is the day before
+    std::vector<const Reservation*> result;
+    for (auto slot : _atomColumns.findOwners(day - 1, day))
+      if (_reservations[slot]->lastAtom()->toDay() == day)
+        result.push_back(_reservations[slot].get());
+    return result;
+  }
+
+  std::vector<const Reservation*> PlanningBoard::getInHouse(boost::gregorian::date date) const
+  {
+    auto day = toDayNumber(date);
+    if (_frontDesk)
+      return _frontDesk->inHouse(day);
+    return reservationsAt<const Reservation*>(_atomColumns.findOwners(day, day + 1));
+  }
+
+  PlanningSnapshot PlanningBoard::snapshot() const
+  {
+    if (!_snapshots)
+      throw std::logic_error("cannot take a snapshot of a planning board without snapshots enabled");
+    return _snapshots->snapshot(_rooms, getPlanningExtent());
+  }
+
+  std::vector<int> PlanningBoard::getFreeRooms(const std::vector<int>& roomIds,
+                                               boost::gregorian::date_period period) const
+  {
+    if (_availability)
+    {
+      auto fromDay = toDayNumber(period.begin());
+      return _availability->freeRooms(roomIds, fromDay, toDayNumber(period.end()) - fromDay);
+    }
+
+    std::vector<int> result;
+    for (auto roomId : roomIds)
+      if (isFree(roomId, period))
+        result.push_back(roomId);
+    return result;
+  }
+
+  std::optional<std::pair<boost::gregorian::date, std::vector<int>>>
+  PlanningBoard::findFirstFreeRun(const std::vector<int>& roomIds, boost::gregorian::date earliest,
+                                  boost::gregorian::date latest, int nights) const
+  {
+    if (_availability)
+    {
+      auto run = _availability->findFreeRun(roomIds, toDayNumber(earliest), toDayNumber(latest), nights);
+      if (!run)
+        return std::nullopt;
+      return std::make_pair(fromDayNumber(run->fromDay), std::move(run->roomIds));
+    }
+
+    using namespace boost::gregorian;
+    for (auto day = earliest; day <= latest; day += days(1))
+    {
+      auto rooms = getFreeRooms(roomIds, date_period(day, day + days(nights)));
+      if (!rooms.empty())
+        return std::make_pair(day, std::move(rooms));
+    }
+    return std::nullopt;
   }
 
   std::vector<Reservation*> PlanningBoard::reservations()
@@ -152,29 +463,36 @@ namespace hotel
 
   std::vector<Reservation*> PlanningBoard::getReservationsInPeriod(boost::gregorian::date_period period)
   {
-    std::vector<Reservation*> result;
-    for (auto& reservation : _reservations)
-      if (reservation->dateRange().intersects(period))
-        result.push_back(reservation.get());
-    return result;
+    auto slots = _atomColumns.findOwners(toDayNumber(period.begin()), toDayNumber(period.end()));
+    return reservationsAt<Reservation*>(slots);
   }
 
   std::vector<const Reservation*> PlanningBoard::getReservationsInPeriod(boost::gregorian::date_period period) const
   {
-    std::vector<const Reservation*> result;
-    for (auto& reservation : _reservations)
-      if (reservation->dateRange().intersects(period))
-        result.push_back(reservation.get());
-    return result;
+    auto slots = _atomColumns.findOwners(toDayNumber(period.begin()), toDayNumber(period.end()));
+    return reservationsAt<const Reservation*>(slots);
+  }
+
+  std::vector<Reservation*> PlanningBoard::getReservationsInRooms(int firstRoomId, int lastRoomId,
+                                                                  boost::gregorian::date_period period)
+  {
+    auto slots =
+        _atomColumns.findOwners(firstRoomId, lastRoomId, toDayNumber(period.begin()), toDayNumber(period.end()));
+    return reservationsAt<Reservation*>(slots);
+  }
+
+  std::vector<const Reservation*> PlanningBoard::getReservationsInRooms(int firstRoomId, int lastRoomId,
+                                                                        boost::gregorian::date_period period) const
+  {
+    auto slots =
+        _atomColumns.findOwners(firstRoomId, lastRoomId, toDayNumber(period.begin()), toDayNumber(period.end()));
+    return reservationsAt<const Reservation*>(slots);
   }
 
   const Reservation *PlanningBoard::getReservationById(int id) const
   {
-    auto it = std::find_if(_reservations.begin(), _reservations.end(), [id](auto& x) { return x->id() == id; });
-    if (it != _reservations.end())
-      return it->get();
-    else
-      return nullptr;
+    auto it = _indexes->byId.find(id);
+    return it != _indexes->byId.end() ? it->second : nullptr;
   }
 
   boost::gregorian::date_period PlanningBoard::getPlanningExtent() const
@@ -187,29 +505,294 @@ namespace hotel
     }
     else
     {
-      date from(pos_infin);
-      date to(neg_infin);
-      for (auto& roomRow : _rooms)
+      if (_isExtentDirty)
       {
-        if (!roomRow.second.empty())
+        resetPlanningExtent();
+        for (auto& roomRow : *_rooms)
         {
-          auto& atoms = roomRow.second;
-          from = std::min(from, atoms.front()->dateRange().begin());
-          to = std::max(to, atoms.back()->dateRange().end());
+          if (!roomRow.second->empty())
+          {
+            _extentFromDay = std::min(_extentFromDay, roomRow.second->firstDay());
+            _extentToDay = std::max(_extentToDay, roomRow.second->endDay());
+          }
         }
       }
-      assert(!from.is_special() && !to.is_special() && from < to);
-      return date_period(from, to);
+      assert(_extentFromDay < _extentToDay);
+      return date_period(fromDayNumber(_extentFromDay), fromDayNumber(_extentToDay));
+    }
+  }
+
+  template <class T> PlanningBoard::ReservationPtr PlanningBoard::makeReservation(T&& reservation)
+  {
+    if (!_arena)
+      return std::make_shared<Reservation>(std::forward<T>(reservation));
+
+    auto memory = _arena->allocate(sizeof(Reservation), alignof(Reservation));
+    try
+    {
+      // The pointer does not own the reservation, thus it does not need a control block
+      auto newReservation = new (memory) Reservation(std::forward<T>(reservation), _arena.get());
+      return ReservationPtr(ReservationPtr(), newReservation);
+    }
+    catch (...)
+    {
+      _arena->deallocate(memory, sizeof(Reservation), alignof(Reservation));
+      throw;
+    }
+  }
+
+  void PlanningBoard::ReservationIndexesDeleter::operator()(ReservationIndexes* indexes) const
+  {
+    if (resource == nullptr)
+    {
+      delete indexes;
+    }
+    else
+    {
+      indexes->~ReservationIndexes();
+      resource->deallocate(indexes, sizeof(ReservationIndexes), alignof(ReservationIndexes));
+    }
+  }
+
+  PlanningBoard::ReservationIndexesPtr PlanningBoard::makeReservationIndexes()
+  {
+    if (!_arena)
+    {
+      auto indexes = new ReservationIndexes(std::pmr::get_default_resource());
+      return ReservationIndexesPtr(indexes, ReservationIndexesDeleter());
+    }
+
+    auto memory = _arena->allocate(sizeof(ReservationIndexes), alignof(ReservationIndexes));
+    auto indexes = new (memory) ReservationIndexes(_arena.get());
+    return ReservationIndexesPtr(indexes, ReservationIndexesDeleter{_arena.get()});
+  }
+
+  PlanningBoard::ReservationPtr PlanningBoard::adoptReservation(std::unique_ptr<Reservation> reservation)
+  {
+    if (!_arena)
+      return ReservationPtr(std::move(reservation));
+    return makeReservation(std::move(*reservation));
+  }
+
+  void PlanningBoard::destroyInArena(Reservation* reservation)
+  {
+    reservation->~Reservation();
+    _arena->deallocate(reservation, sizeof(Reservation), alignof(Reservation));
+  }
+
+  void PlanningBoard::validateReservations(const std::vector<const Reservation*>& reservations) const
+  {
+    // Validate each reservation against the board and collect the new atoms per room
+    std::map<int, std::vector<const ReservationAtom*>> newAtoms;
+    std::vector<int> newIds;
+    for (auto reservation : reservations)
+    {
+      if (!canAddReservation(*reservation))
+        throw std::logic_error(std::string("cannot add reservation ").append(reservation->description()));
+
+      if (reservation->id() != 0)
+      {
+        if (_indexes->byId.count(reservation->id()) != 0)
+          throw std::logic_error(std::string("cannot add reservation ").append(reservation->description()) +
+                                 ", its id " + std::to_string(reservation->id()) + " is already on the planning board");
+        newIds.push_back(reservation->id());
+      }
+
+      if (reservations.size() > 1)
+        for (auto& atom : reservation->atoms())
+          newAtoms[atom.roomId()].push_back(&atom);
     }
+
+    // Validate the batch against itself: the ids have to be unique and the new atoms of one room may not overlap
+    std::sort(newIds.begin(), newIds.end());
+    auto duplicateId = std::adjacent_find(newIds.begin(), newIds.end());
+    if (duplicateId != newIds.end())
+      throw std::logic_error("cannot add reservations, duplicate reservation id " + std::to_string(*duplicateId) +
+                             " in the batch");
+
+    for (auto& roomAtoms : newAtoms)
+    {
+      auto& atoms = roomAtoms.second;
+      std::sort(atoms.begin(), atoms.end(), [](auto x, auto y) { return x->fromDay() < y->fromDay(); });
+      auto overlap = std::adjacent_find(atoms.begin(), atoms.end(), [](auto x, auto y) {
+        return periodsIntersect(x->fromDay(), x->toDay(), y->fromDay(), y->toDay());
+      });
+      if (overlap != atoms.end())
+        throw std::logic_error("cannot add reservations, the batch contains overlapping reservations in room " +
+                               std::to_string(roomAtoms.first));
+    }
+  }
+
+  Reservation* PlanningBoard::insertReservation(ReservationPtr reservation)
+  {
+    for (auto& atom : reservation->atoms())
+      insertAtom(&atom);
+
+    auto reservationPtr = reservation.get();
+    _indexes->slots[reservationPtr] = _reservations.size();
+    if (reservationPtr->id() != 0)
+      _indexes->byId[reservationPtr->id()] = reservationPtr;
+    _atomColumns.append(*reservationPtr);
+    if (_snapshots)
+      _snapshots->addReservation(reservation);
+    if (_frontDesk)
+      _frontDesk->add(*reservationPtr);
+    _reservations.push_back(std::move(reservation));
+    return reservationPtr;
+  }
+
+  std::vector<Reservation*> PlanningBoard::insertReservations(std::vector<ReservationPtr> reservations)
+  {
+    // Insert the atoms, one merge per room
+    std::map<int, std::vector<const ReservationAtom*>> newAtoms;
+    for (auto& reservation : reservations)
+      for (auto& atom : reservation->atoms())
+        newAtoms[atom.roomId()].push_back(&atom);
+
+    for (auto& roomAtoms : newAtoms)
+    {
+      for (auto atom : roomAtoms.second)
+      {
+        _extentFromDay = std::min(_extentFromDay, atom->fromDay());
+        _extentToDay = std::max(_extentToDay, atom->toDay());
+        if (_availability)
+          _availability->occupy(atom->roomId(), atom->fromDay(), atom->toDay());
+        if (_occupancy)
+          _occupancy->occupy(atom->roomId(), atom->fromDay(), atom->toDay());
+      }
+      mutableRoom(roomAtoms.first).insert(std::move(roomAtoms.second));
+    }
+
+    // Insert the reservations
+    std::vector<Reservation*> result;
+    result.reserve(reservations.size());
+    _reservations.reserve(_reservations.size() + reservations.size());
+    _indexes->slots.reserve(_indexes->slots.size() + reservations.size());
+    for (auto& reservation : reservations)
+    {
+      auto reservationPtr = reservation.get();
+      _indexes->slots[reservationPtr] = _reservations.size();
+      if (reservationPtr->id() != 0)
+        _indexes->byId[reservationPtr->id()] = reservationPtr;
+      _atomColumns.append(*reservationPtr);
+      if (_snapshots)
+        _snapshots->addReservation(reservation);
+      if (_frontDesk)
+        _frontDesk->add(*reservationPtr);
+      _reservations.push_back(std::move(reservation));
+      result.push_back(reservationPtr);
+    }
+
+    return result;
+  }
+
+  template <class T> std::vector<T> PlanningBoard::reservationsAt(const std::vector<size_t>& slots) const
+  {
+    std::vector<T> result;
+    result.reserve(slots.size());
+    for (auto slot : slots)
+      result.push_back(_reservations[slot].get());
+    return result;
   }
 
   void PlanningBoard::insertAtom(const ReservationAtom* atom)
   {
-    // TODO: This can be made more efficient! Linear instead of n*log(n)
-    auto& roomAtoms = _rooms[atom->roomId()];
-    roomAtoms.push_back(atom);
-    std::sort(roomAtoms.begin(), roomAtoms.end(),
-              [](auto x, auto y) { return x->dateRange().begin() < y->dateRange().begin(); });
+    mutableRoom(atom->roomId()).insert(atom);
+    _extentFromDay = std::min(_extentFromDay, atom->fromDay());
+    _extentToDay = std::max(_extentToDay, atom->toDay());
+    if (_availability)
+      _availability->occupy(atom->roomId(), atom->fromDay(), atom->toDay());
+    if (_occupancy)
+      _occupancy->occupy(atom->roomId(), atom->fromDay(), atom->toDay());
+  }
+
+  void PlanningBoard::eraseReservationAt(size_t slot)
+  {
+    assert(slot < _reservations.size());
+    auto reservation = _reservations[slot].get();
+
+    // First, remove the atoms and the index entries
+    for (auto& atom : reservation->atoms())
+      removeAtom(&atom);
+    _indexes->slots.erase(reservation);
+    auto idIt = _indexes->byId.find(reservation->id());
+    if (idIt != _indexes->byId.end() && idIt->second == reservation)
+      _indexes->byId.erase(idIt);
+    _atomColumns.erase(slot);
+    if (_snapshots)
+      _snapshots->removeReservation(*reservation);
+    if (_frontDesk)
+      _frontDesk->remove(*reservation);
+
+    // Then, fill the slot with the last reservation, so that no other element has to be shifted
+    auto removed = std::move(_reservations[slot]);
+    if (slot + 1 != _reservations.size())
+    {
+      _reservations[slot] = std::move(_reservations.back());
+      _indexes->slots[_reservations[slot].get()] = slot;
+    }
+    _reservations.pop_back();
+    if (_arena)
+      destroyInArena(removed.get());
+  }
+
+  void PlanningBoard::removeAtom(const ReservationAtom* atom)
+  {
+    if (_rooms->count(atom->roomId()) == 0)
+      return;
+
+    auto entry = mutableRoom(atom->roomId()).remove(atom);
+    if (!entry)
+      return;
+
+    if (_availability)
+      _availability->release(atom->roomId(), entry->fromDay, entry->toDay);
+    if (_occupancy)
+      _occupancy->release(atom->roomId(), entry->fromDay, entry->toDay);
+    // Only the removal of an atom at the border of the extent can shrink it
+    if (entry->fromDay <= _extentFromDay || entry->toDay >= _extentToDay)
+      _isExtentDirty = true;
+  }
+
+  void PlanningBoard::moveAtom(const ReservationAtom* atom, DayNumber oldFromDay)
+  {
+    auto entry = mutableRoom(atom->roomId()).update(atom, oldFromDay);
+    if (entry)
+    {
+      if (_availability)
+        _availability->release(atom->roomId(), entry->fromDay, entry->toDay);
+      if (_occupancy)
+        _occupancy->release(atom->roomId(), entry->fromDay, entry->toDay);
+      if (entry->fromDay <= _extentFromDay || entry->toDay >= _extentToDay)
+        _isExtentDirty = true;
+    }
+
+    _extentFromDay = std::min(_extentFromDay, atom->fromDay());
+    _extentToDay = std::max(_extentToDay, atom->toDay());
+    if (_availability)
+      _availability->occupy(atom->roomId(), atom->fromDay(), atom->toDay());
+    if (_occupancy)
+      _occupancy->occupy(atom->roomId(), atom->fromDay(), atom->toDay());
+  }
+
+  RoomAtomIndex& PlanningBoard::mutableRoom(int roomId)
+  {
+    if (isSharedWithSnapshot(_rooms))
+      _rooms = std::make_shared<RoomIndexes>(*_rooms);
+
+    auto& room = (*_rooms)[roomId];
+    if (!room)
+      room = std::make_shared<RoomAtomIndex>();
+    else if (isSharedWithSnapshot(room))
+      room = std::make_shared<RoomAtomIndex>(*room);
+    return *room;
+  }
+
+  void PlanningBoard::resetPlanningExtent() const
+  {
+    _extentFromDay = std::numeric_limits<DayNumber>::max();
+    _extentToDay = std::numeric_limits<DayNumber>::min();
+    _isExtentDirty = false;
   }
 
 } // namespace hotel
@@ -1,14 +1,24 @@
 #ifndef HOTEL_PLANNING_H
 #define HOTEL_PLANNING_H
 
+#include "hotel/atomcolumns.h"
+#include "hotel/availabilitybitmap.h"
+#include "hotel/frontdeskindex.h"
+#include "hotel/occupancycounters.h"
+#include "hotel/planningsnapshot.h"
 #include "hotel/reservation.h"
+#include "hotel/roomatomindex.h"
 
 #include <boost/date_time.hpp>
 
+#include <limits>
 #include <map>
 #include <memory>
+#include <memory_resource>
+#include <optional>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace hotel
@@ -35,6 +45,24 @@ namespace hotel
      * @return a pointer to the added reservation on success, otherwise nullptr.
      */
     Reservation* addReservation(std::unique_ptr<Reservation> reservation);
+    /**
+     * @brief addReservations adds a whole batch of reservations to the planning board at once
+     *
+     * The batch is validated as a whole, both against the reservations already on the board and against itself. If
+     * any reservation cannot be added, an exception is thrown and the board is left unchanged. Each affected room is
+     * sorted only once, which makes this much faster than calling addReservation() for each reservation.
+     *
+     * @param reservations the reservations to add
+     * @return pointers to the added reservations, in the same order as the input
+     */
+    std::vector<Reservation*> addReservations(std::vector<std::unique_ptr<Reservation>> reservations);
+    /**
+     * @brief addReservations adds copies of the given reservations to the planning board at once
+     *
+     * Same as above, but the copies are created directly in the storage of the board. This avoids an intermediate heap
+     * allocation per reservation when arena allocation is enabled.
+     */
+    std::vector<Reservation*> addReservations(const std::vector<Reservation>& reservations);
     /**
      * @brief removeReservation deletes the given reservation from the planning board
      * @param reservation the reservation to delete
@@ -43,8 +71,29 @@ namespace hotel
     /**
      * @brief removeReservation deletes the given reservation from the planning board
      * @param reservationId the id of the reservation to delete
+     * @note The reservation is found in O(1) using the id index. Reservations without id (i.e. id 0) are not indexed.
      */
     void removeReservation(int reservationId);
+    /**
+     * @brief replaceReservation changes the given reservation on the board into a copy of the replacement
+     *
+     * This is the way to move or resize a reservation. The replacement is validated against the board without the old
+     * atoms of the reservation. If it does not fit, an exception is thrown and the board is left unchanged. Otherwise
+     * the reservation and its atoms are updated in place: the pointer to the reservation stays valid and only the
+     * entries of the modified atoms are moved within their room indexes. The atoms keep their addresses, unless the
+     * reservation grows beyond the capacity of its atom storage. A reservation still referenced by a snapshot is
+     * replaced by a new one instead (copy on write), thus the returned pointer has to be used afterwards.
+     *
+     * @param reservation the reservation on the board to change
+     * @param replacement the new state of the reservation
+     * @return the changed reservation, i.e. reservation
+     */
+    Reservation* replaceReservation(const Reservation* reservation, const Reservation& replacement);
+    /**
+     * @brief replaceReservation changes the reservation with the given id into a copy of the replacement
+     * @note If there is no reservation with the given id on the board, std::invalid_argument is thrown.
+     */
+    Reservation* replaceReservation(int reservationId, const Reservation& replacement);
 
     /**
      * @brief clear deletes all reservations and rooms from the current planning board.
@@ -57,6 +106,10 @@ namespace hotel
      */
     bool canAddReservation(const Reservation& reservation) const;
 
+    /**
+     * @brief isFree returns true if the given room is not occupied during the given period
+     * @note The query is O(log n) in the number of atoms in the room.
+     */
     bool isFree(int roomId, boost::gregorian::date_period period) const;
 
     /**
@@ -67,28 +120,224 @@ namespace hotel
      */
     int getAvailableDaysFrom(int roomId, boost::gregorian::date date) const;
 
+    /**
+     * @brief getAvailableDaysBefore computes the number of days in which the given room is available before the given
+     *        date, i.e. the number of free days between the previous reservation and the date.
+     * @return the number of days for which the room is free. If the room is occupied on the day before the date 0 is
+     *         returned. If the room is always available before the date max is returned.
+     */
+    int getAvailableDaysBefore(int roomId, boost::gregorian::date date) const;
+
+    //! @brief roomIndex returns the index of all atoms in the given room, or nullptr if the room has no atoms
+    const RoomAtomIndex* roomIndex(int roomId) const;
+
+    /**
+     * @brief setArenaAllocationEnabled enables or disables arena allocation for the reservations on the board
+     *
+     * In arena mode the reservations, their descriptions and atoms are allocated from a memory pool owned by the board,
+     * instead of a few individual heap allocations per reservation. The indexes of the reservations by address and id
+     * are kept in the arena as well. This makes loading large boards considerably faster and clear() releases all of
+     * the memory at once. Reservations passed to the board as unique_ptr are moved into the
+     * arena, thus the returned pointers should be used after adding them. It is disabled by default.
+     *
+     * @note The mode can only be changed while the board is empty, otherwise std::logic_error is thrown. Arena
+     *       allocation cannot be combined with snapshots, which share the reservations with other threads.
+     */
+    void setArenaAllocationEnabled(bool enabled);
+    bool isArenaAllocationEnabled() const { return _arena != nullptr; }
+
+    /**
+     * @brief setAvailabilityBitmapEnabled enables or disables the availability bitmap of the planning board
+     *
+     * The availability bitmap stores one bit per room and day and is kept in sync with the reservations on the board.
+     * It speeds up getFreeRooms() and findFirstFreeRun() considerably for large sets of rooms, at the cost of some
+     * memory and slightly slower insertions and removals. It is disabled by default.
+     *
+     * @see AvailabilityBitmap
+     */
+    void setAvailabilityBitmapEnabled(bool enabled);
+    bool isAvailabilityBitmapEnabled() const { return _availability != nullptr; }
+
+    /**
+     * @brief getFreeRooms returns all of the given rooms which are free during the given period
+     * @return The free rooms, in the same order as roomIds
+     */
+    std::vector<int> getFreeRooms(const std::vector<int>& roomIds, boost::gregorian::date_period period) const;
+
+    /**
+     * @brief findFirstFreeRun searches for the first arrival date in [earliest, latest] at which at least one of the
+     *        given rooms is free for the given number of nights
+     * @return The arrival date together with all of the rooms free from that date on, or nothing if there is no such
+     *         date.
+     */
+    std::optional<std::pair<boost::gregorian::date, std::vector<int>>>
+    findFirstFreeRun(const std::vector<int>& roomIds, boost::gregorian::date earliest, boost::gregorian::date latest,
+                     int nights) const;
+
+    /**
+     * @brief enableOccupancyCounters enables the occupancy counters per hotel and category of the planning board
+     *
+     * The counters are kept in sync with the reservations on the board and answer the number of occupied rooms per day
+     * in O(log n). The rooms are assigned to their hotels and categories using the given collection, calling this again
+     * rebuilds the counters with the new assignment. They are disabled by default.
+     *
+     * @see OccupancyCounters
+     */
+    void enableOccupancyCounters(const HotelCollection& hotels);
+    void disableOccupancyCounters();
+    //! @brief occupancyCounters returns the occupancy counters or nullptr if they are disabled
+    const OccupancyCounters* occupancyCounters() const { return _occupancy.get(); }
+
+    /**
+     * @brief setSnapshotsEnabled enables or disables snapshots of the planning board
+     *
+     * With snapshots enabled the board additionally maintains copy on write shards of its reservations, which makes
+     * snapshot() O(1). The snapshots share the reservations and room indexes of the board, the first modification of a
+     * room or a reservation after a snapshot copies it. It is disabled by default.
+     *
+     * @note Reservations referenced by a snapshot must only be changed through replaceReservation(). Snapshots cannot
+     *       be combined with arena allocation, std::logic_error is thrown when enabling both.
+     *
+     * @see PlanningSnapshot
+     */
+    void setSnapshotsEnabled(bool enabled);
+    bool isSnapshotsEnabled() const { return _snapshots != nullptr; }
+    /**
+     * @brief snapshot returns an immutable view of the current state of the board
+     *
+     * The snapshot can be handed to other threads, which can read it while the board is being modified.
+     *
+     * @note Snapshots have to be enabled, otherwise std::logic_error is thrown.
+     */
+    PlanningSnapshot snapshot() const;
+
+    /**
+     * @brief setFrontDeskIndexEnabled enables or disables the front desk index of the planning board
+     *
+     * The index keeps the arriving, departing and in-house reservations of every day in sync with the board, which
+     * makes getArrivals(), getDepartures() and getInHouse() O(k) in the size of the result instead of a scan over all
+     * atoms. It is disabled by default.
+     *
+     * @see FrontDeskIndex
+     */
+    void setFrontDeskIndexEnabled(bool enabled);
+    bool isFrontDeskIndexEnabled() const { return _frontDesk != nullptr; }
+
+    //! @brief getArrivals returns all reservations arriving on the given date, i.e. beginning on it
+    std::vector<const Reservation*> getArrivals(boost::gregorian::date date) const;
+    //! @brief getDepartures returns all reservations departing on the given date, i.e. ending on it
+    std::vector<const Reservation*> getDepartures(boost::gregorian::date date) const;
+    //! @brief getInHouse returns all reservations staying during the night of the given date
+    std::vector<const Reservation*> getInHouse(boost::gregorian::date date) const;
+
+    /**
+     * @brief reservations returns all reservations on the board
+     * @note The order is unspecified. Removing a reservation moves the last reservation into its place, thus the order
+     *       changes with every removal.
+     */
     std::vector<Reservation*> reservations();
     std::vector<const Reservation*> reservations() const;
+    /**
+     * @brief getReservationsInPeriod returns all reservations intersecting the given period
+     * @note The query is a linear scan over the columnar atom mirror (see AtomColumns), the reservations themselves
+     *       are only touched for the result.
+     */
     std::vector<Reservation*> getReservationsInPeriod(boost::gregorian::date_period period);
     std::vector<const Reservation*> getReservationsInPeriod(boost::gregorian::date_period period) const;
+    /**
+     * @brief getReservationsInRooms returns all reservations with an atom in one of the rooms [firstRoomId,
+     *        lastRoomId] intersecting the given period
+     */
+    std::vector<Reservation*> getReservationsInRooms(int firstRoomId, int lastRoomId,
+                                                     boost::gregorian::date_period period);
+    std::vector<const Reservation*> getReservationsInRooms(int firstRoomId, int lastRoomId,
+                                                           boost::gregorian::date_period period) const;
 
+    /**
+     * @brief getReservationById returns the reservation with the given id in O(1)
+     * @return The reservation or nullptr if there is no reservation with the given id on the board.
+     */
     const Reservation* getReservationById(int id) const;
 
     /**
      * @brief getPlanningExtent Returns the date period encompassing all of the reservations
      * @return If there are no reservation, an empty period is returned, encompassing the current day.
+     * @note The extent is maintained incrementally. It only has to be recomputed after the reservation defining one of
+     *       its bounds has been removed, which makes this O(1) amortized.
      */
     boost::gregorian::date_period getPlanningExtent() const;
 
   private:
+    // Reservations on the heap are owned by their pointer, which they share with the snapshots. Reservations in the
+    // arena are not owned by their pointer, the board destroys them itself (see destroyInArena).
+    typedef std::shared_ptr<Reservation> ReservationPtr;
+
+    // The indexes of the reservations by address (their slot in _reservations) and by id. In arena mode they are
+    // allocated in the arena together with all of their nodes, thus clear() drops them with the arena.
+    struct ReservationIndexes
+    {
+      explicit ReservationIndexes(std::pmr::memory_resource* resource) : slots(resource), byId(resource) {}
+      std::pmr::unordered_map<const Reservation*, size_t> slots;
+      std::pmr::unordered_map<int, Reservation*> byId;
+    };
+    // Deletes indexes either allocated on the heap (no resource) or in the arena
+    struct ReservationIndexesDeleter
+    {
+      std::pmr::memory_resource* resource = nullptr;
+      void operator()(ReservationIndexes* indexes) const;
+    };
+    typedef std::unique_ptr<ReservationIndexes, ReservationIndexesDeleter> ReservationIndexesPtr;
+
+    //! @brief makeReservation creates a new reservation in the storage of the board, copying or moving the given one
+    template <class T> ReservationPtr makeReservation(T&& reservation);
+    //! @brief makeReservationIndexes creates empty reservation indexes in the storage of the board
+    ReservationIndexesPtr makeReservationIndexes();
+    //! @brief adoptReservation takes ownership of the given reservation, moving it into the arena if enabled
+    ReservationPtr adoptReservation(std::unique_ptr<Reservation> reservation);
+    //! @brief destroyInArena destroys the given reservation allocated in the arena
+    void destroyInArena(Reservation* reservation);
+    //! @brief validateReservations throws if the given reservations cannot be added to the board all together
+    void validateReservations(const std::vector<const Reservation*>& reservations) const;
+    Reservation* insertReservation(ReservationPtr reservation);
+    // Returns the reservations in the given slots
+    template <class T> std::vector<T> reservationsAt(const std::vector<size_t>& slots) const;
+    std::vector<Reservation*> insertReservations(std::vector<ReservationPtr> reservations);
+
     /**
      * @brief insertAtom Inserts a given reservation atom to the PlanningBoard.
      * @note This function does not verify constraints to avoid overlapping atoms.
      */
-    void insertAtom(const ReservationAtom* atom); // TODO: Make this more efficient
+    void insertAtom(const ReservationAtom* atom);
+    //! @brief removeAtom Removes the given reservation atom from its room index
+    void removeAtom(const ReservationAtom* atom);
+    //! @brief moveAtom Updates the indexes after the period of the given atom has been changed within its room
+    void moveAtom(const ReservationAtom* atom, DayNumber oldFromDay);
+    //! @brief eraseReservationAt Removes the reservation in the given slot, moving the last reservation into its place
+    void eraseReservationAt(size_t slot);
+    //! @brief mutableRoom returns the index of the given room for modification, copying it if shared with a snapshot
+    RoomAtomIndex& mutableRoom(int roomId);
+    //! @brief resetPlanningExtent Sets the cached planning extent to an empty extent
+    void resetPlanningExtent() const;
+
+    // The arena has to outlive the reservations allocated from it
+    std::unique_ptr<std::pmr::unsynchronized_pool_resource> _arena;
+    // The reservations are owned by _reservations. Since they are heap (or arena) allocated, the pointers handed out
+    // remain valid until the reservation is removed, even though removals move the last reservation into the freed
+    // slot.
+    std::vector<ReservationPtr> _reservations;
+    ReservationIndexesPtr _indexes = makeReservationIndexes();
+    // Columnar mirror of all atoms, the owner indexes are the reservation slots
+    AtomColumns _atomColumns;
+    std::shared_ptr<RoomIndexes> _rooms = std::make_shared<RoomIndexes>();
+    std::unique_ptr<AvailabilityBitmap> _availability;
+    std::unique_ptr<OccupancyCounters> _occupancy;
+    std::unique_ptr<SnapshotBuilder> _snapshots;
+    std::unique_ptr<FrontDeskIndex> _frontDesk;
 
-    std::vector<std::unique_ptr<Reservation>> _reservations;
-    std::map<int, std::vector<const ReservationAtom*>> _rooms;
+    // Cached planning extent, [_extentFromDay, _extentToDay). If dirty, it has to be recomputed from the room indexes.
+    mutable DayNumber _extentFromDay = std::numeric_limits<DayNumber>::max();
+    mutable DayNumber _extentToDay = std::numeric_limits<DayNumber>::min();
+    mutable bool _isExtentDirty = false;
   };
 
 } // namespace hotel
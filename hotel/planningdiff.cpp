@@ -0,0 +1,70 @@
+#include "hotel/planningdiff.h"
+
+#include <unordered_map>
+
+namespace hotel
+{
+  namespace
+  {
+    std::vector<const Reservation*> pointersTo(const std::vector<Reservation>& reservations)
+    {
+      std::vector<const Reservation*> result;
+      result.reserve(reservations.size());
+      for (auto& reservation : reservations)
+        result.push_back(&reservation);
+      return result;
+    }
+  } // namespace
+
+  PlanningDiff diffReservations(const std::vector<const Reservation*>& from, const std::vector<const Reservation*>& to,
+                                ReservationComparison comparison)
+  {
+    // The matched reservations are erased from the map, whatever remains has been removed
+    std::unordered_map<int, const Reservation*> source;
+    source.reserve(from.size());
+    for (auto reservation : from)
+      if (reservation->id() != 0)
+        source.emplace(reservation->id(), reservation);
+
+    PlanningDiff diff;
+    for (auto reservation : to)
+    {
+      if (reservation->id() == 0)
+        continue;
+
+      auto it = source.find(reservation->id());
+      if (it == source.end())
+      {
+        diff.added.push_back(reservation);
+        continue;
+      }
+
+      auto previous = it->second;
+      source.erase(it);
+      if (previous->revision() != reservation->revision() ||
+          (comparison == ReservationComparison::Contents && *previous != *reservation))
+        diff.updated.push_back(reservation);
+    }
+
+    if (!source.empty())
+    {
+      diff.removed.reserve(source.size());
+      for (auto reservation : from)
+        if (reservation->id() != 0 && source.count(reservation->id()) != 0)
+          diff.removed.push_back(reservation->id());
+    }
+    return diff;
+  }
+
+  PlanningDiff diffReservations(const std::vector<Reservation>& from, const std::vector<Reservation>& to,
+                                ReservationComparison comparison)
+  {
+    return diffReservations(pointersTo(from), pointersTo(to), comparison);
+  }
+
+  PlanningDiff diffReservations(const PlanningBoard& from, const PlanningBoard& to, ReservationComparison comparison)
+  {
+    return diffReservations(from.reservations(), to.reservations(), comparison);
+  }
+
+} // namespace hotel
@@ -0,0 +1,60 @@
+#ifndef HOTEL_PLANNINGDIFF_H
+#define HOTEL_PLANNINGDIFF_H
+
+#include "hotel/planning.h"
+#include "hotel/reservation.h"
+
+#include <vector>
+
+namespace hotel
+{
+  /**
+   * @brief The PlanningDiff struct holds the changes needed to turn one planning state into another
+   *
+   * The added and updated reservations point into the target state, which has to outlive the diff.
+   *
+   * @see diffReservations
+   */
+  struct PlanningDiff
+  {
+    //! Reservations of the target state whose id does not exist in the source state, in the order of the target
+    std::vector<const Reservation*> added;
+    //! Reservations of the target state which differ from the reservation with the same id in the source state
+    std::vector<const Reservation*> updated;
+    //! Ids of the reservations of the source state which do not exist in the target state, in the order of the source
+    std::vector<int> removed;
+
+    bool empty() const { return added.empty() && updated.empty() && removed.empty(); }
+  };
+
+  /**
+   * @brief The ReservationComparison enum defines when two reservations with the same id are considered different
+   */
+  enum class ReservationComparison
+  {
+    //! Only the revisions are compared, which is enough for reservations coming from the backend
+    Revision,
+    //! The revisions and all of the data are compared, which also detects local changes without a new revision
+    Contents
+  };
+
+  /**
+   * @brief diffReservations computes the minimal set of changes between two planning states
+   *
+   * The reservations are matched by their id using a hash map, thus the diff is computed in O(n + m). Reservations
+   * without id (e.g. temporary reservations) cannot be matched and are ignored. The ids within each state have to be
+   * unique.
+   *
+   * @param from the source state
+   * @param to the target state
+   */
+  PlanningDiff diffReservations(const std::vector<const Reservation*>& from, const std::vector<const Reservation*>& to,
+                                ReservationComparison comparison = ReservationComparison::Revision);
+  PlanningDiff diffReservations(const std::vector<Reservation>& from, const std::vector<Reservation>& to,
+                                ReservationComparison comparison = ReservationComparison::Revision);
+  PlanningDiff diffReservations(const PlanningBoard& from, const PlanningBoard& to,
+                                ReservationComparison comparison = ReservationComparison::Revision);
+
+} // namespace hotel
+
+#endif // HOTEL_PLANNINGDIFF_H
@@ -0,0 +1,162 @@
+#include "hotel/planningsnapshot.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+namespace hotel
+{
+  PlanningSnapshot::PlanningSnapshot()
+      : _rooms(std::make_shared<RoomIndexes>()), _shards(std::make_shared<Shards>())
+  {
+  }
+
+  bool PlanningSnapshot::isFree(int roomId, boost::gregorian::date_period period) const
+  {
+    auto roomIndex = room(roomId);
+    return roomIndex == nullptr || roomIndex->isFree(period);
+  }
+
+  bool PlanningSnapshot::canAddReservation(const Reservation& reservation) const
+  {
+    if (!reservation.isValid())
+      return false;
+
+    auto& atoms = reservation.atoms();
+    return std::all_of(atoms.begin(), atoms.end(),
+                       [this](auto& atom) { return this->isFree(atom.roomId(), atom.dateRange()); });
+  }
+
+  int PlanningSnapshot::getAvailableDaysFrom(int roomId, boost::gregorian::date date) const
+  {
+    auto roomIndex = room(roomId);
+    return roomIndex == nullptr ? std::numeric_limits<int>::max() : roomIndex->getAvailableDaysFrom(date);
+  }
+
+  int PlanningSnapshot::getAvailableDaysBefore(int roomId, boost::gregorian::date date) const
+  {
+    auto roomIndex = room(roomId);
+    return roomIndex == nullptr ? std::numeric_limits<int>::max() : roomIndex->getAvailableDaysBefore(date);
+  }
+
+  std::vector<const Reservation*> PlanningSnapshot::reservations() const
+  {
+    std::vector<const Reservation*> result;
+    result.reserve(_numberOfReservations);
+    for (auto& shard : *_shards)
+      if (shard)
+        for (auto& item : shard->reservations)
+          result.push_back(item.second.get());
+    return result;
+  }
+
+  std::vector<const Reservation*> PlanningSnapshot::getReservationsInPeriod(boost::gregorian::date_period period) const
+  {
+    auto fromDay = toDayNumber(period.begin());
+    auto toDay = toDayNumber(period.end());
+    std::vector<const Reservation*> result;
+    for (auto& shard : *_shards)
+      if (shard)
+        for (auto& item : shard->reservations)
+        {
+          auto& reservation = *item.second;
+          if (periodsIntersect(reservation.firstAtom()->fromDay(), reservation.lastAtom()->toDay(), fromDay, toDay))
+            result.push_back(&reservation);
+        }
+    return result;
+  }
+
+  const Reservation* PlanningSnapshot::getReservationById(int id) const
+  {
+    if (id == 0)
+      return nullptr;
+    auto& shard = (*_shards)[shardIndex(id)];
+    if (!shard)
+      return nullptr;
+    auto it = shard->reservationsById.find(id);
+    return it != shard->reservationsById.end() ? it->second : nullptr;
+  }
+
+  boost::gregorian::date_period PlanningSnapshot::getPlanningExtent() const
+  {
+    return boost::gregorian::date_period(fromDayNumber(_extentFromDay), fromDayNumber(_extentToDay));
+  }
+
+  const RoomAtomIndex* PlanningSnapshot::room(int roomId) const
+  {
+    auto roomIt = _rooms->find(roomId);
+    return roomIt == _rooms->end() ? nullptr : roomIt->second.get();
+  }
+
+  size_t PlanningSnapshot::shardIndex(const Reservation& reservation)
+  {
+    if (reservation.id() != 0)
+      return shardIndex(reservation.id());
+    return std::hash<const Reservation*>()(&reservation) / alignof(Reservation) % numberOfShards;
+  }
+
+  size_t PlanningSnapshot::shardIndex(int reservationId)
+  {
+    return std::hash<int>()(reservationId) % numberOfShards;
+  }
+
+  SnapshotBuilder::SnapshotBuilder() : _shards(std::make_shared<PlanningSnapshot::Shards>()) {}
+
+  void SnapshotBuilder::addReservation(std::shared_ptr<const Reservation> reservation)
+  {
+    auto& shard = mutableShard(*reservation);
+    if (reservation->id() != 0)
+      shard.reservationsById[reservation->id()] = reservation.get();
+    auto key = reservation.get();
+    shard.reservations[key] = std::move(reservation);
+    ++_numberOfReservations;
+  }
+
+  void SnapshotBuilder::removeReservation(const Reservation& reservation)
+  {
+    auto& shard = mutableShard(reservation);
+    auto it = shard.reservations.find(&reservation);
+    if (it == shard.reservations.end())
+      return;
+
+    auto idIt = shard.reservationsById.find(reservation.id());
+    if (idIt != shard.reservationsById.end() && idIt->second == &reservation)
+      shard.reservationsById.erase(idIt);
+    shard.reservations.erase(it);
+    --_numberOfReservations;
+  }
+
+  void SnapshotBuilder::clear()
+  {
+    // Existing snapshots keep the old shards
+    _shards = std::make_shared<PlanningSnapshot::Shards>();
+    _numberOfReservations = 0;
+  }
+
+  PlanningSnapshot SnapshotBuilder::snapshot(std::shared_ptr<const RoomIndexes> rooms,
+                                             boost::gregorian::date_period extent) const
+  {
+    // From now on, all of the current data is shared with the snapshot
+    PlanningSnapshot result;
+    result._rooms = std::move(rooms);
+    result._shards = _shards;
+    result._numberOfReservations = _numberOfReservations;
+    result._extentFromDay = toDayNumber(extent.begin());
+    result._extentToDay = toDayNumber(extent.end());
+    return result;
+  }
+
+  PlanningSnapshot::Shard& SnapshotBuilder::mutableShard(const Reservation& reservation)
+  {
+    if (isSharedWithSnapshot(_shards))
+      _shards = std::make_shared<PlanningSnapshot::Shards>(*_shards);
+
+    auto& shard = (*_shards)[PlanningSnapshot::shardIndex(reservation)];
+    if (!shard)
+      shard = std::make_shared<PlanningSnapshot::Shard>();
+    else if (isSharedWithSnapshot(shard))
+      shard = std::make_shared<PlanningSnapshot::Shard>(*shard);
+    return *shard;
+  }
+
+} // namespace hotel
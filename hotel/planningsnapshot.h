@@ -0,0 +1,121 @@
+#ifndef HOTEL_PLANNINGSNAPSHOT_H
+#define HOTEL_PLANNINGSNAPSHOT_H
+
+#include "hotel/daynumber.h"
+#include "hotel/reservation.h"
+#include "hotel/roomatomindex.h"
+
+#include <boost/date_time.hpp>
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace hotel
+{
+  class SnapshotBuilder;
+
+  /**
+   * @brief isSharedWithSnapshot returns true if the given data is referenced by a snapshot as well, i.e. it has to be
+   *        copied before it can be modified
+   * @note Only the writer creates new references, thus data which is not shared cannot become shared concurrently.
+   */
+  template <class T> bool isSharedWithSnapshot(const std::shared_ptr<T>& data)
+  {
+    if (data.use_count() > 1)
+      return true;
+    // Pairs with the release of the last reference by a reader, whose reads have to happen before our writes
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return false;
+  }
+
+  /**
+   * @brief The PlanningSnapshot class is an immutable view of a PlanningBoard at a given point in time
+   *
+   * Snapshots are cheap to create and to copy. They share all of their data structurally with the planning board and
+   * with other snapshots, only the parts modified after a snapshot has been taken are copied by the board (copy on
+   * write). A snapshot never changes after it has been created, thus it can be read from any number of threads while
+   * the board keeps being modified by the writer thread.
+   *
+   * The reservations and the room indexes are the ones of the board. The board copies a reservation before modifying
+   * it while a snapshot still refers to it, thus the pointers handed out by the snapshot remain valid and unchanged as
+   * long as any copy of the snapshot exists.
+   *
+   * @see PlanningBoard::setSnapshotsEnabled
+   * @see PlanningBoard::snapshot
+   */
+  class PlanningSnapshot
+  {
+  public:
+    PlanningSnapshot();
+
+    bool isFree(int roomId, boost::gregorian::date_period period) const;
+    bool canAddReservation(const Reservation& reservation) const;
+    int getAvailableDaysFrom(int roomId, boost::gregorian::date date) const;
+    int getAvailableDaysBefore(int roomId, boost::gregorian::date date) const;
+
+    size_t numberOfReservations() const { return _numberOfReservations; }
+    std::vector<const Reservation*> reservations() const;
+    std::vector<const Reservation*> getReservationsInPeriod(boost::gregorian::date_period period) const;
+    //! @brief getReservationById returns the reservation with the given id in O(1), or nullptr if there is none
+    const Reservation* getReservationById(int id) const;
+    //! @see PlanningBoard::getPlanningExtent
+    boost::gregorian::date_period getPlanningExtent() const;
+
+  private:
+    friend class SnapshotBuilder;
+
+    // The reservations are distributed over a fixed number of shards, so that a modification after a snapshot only has
+    // to copy a single shard. Reservations with an id are assigned to the shard of their id, which makes the id lookup
+    // O(1), the others to the shard of their address.
+    static constexpr size_t numberOfShards = 64;
+    struct Shard
+    {
+      std::unordered_map<const Reservation*, std::shared_ptr<const Reservation>> reservations;
+      std::unordered_map<int, const Reservation*> reservationsById;
+    };
+    using Shards = std::array<std::shared_ptr<Shard>, numberOfShards>;
+
+    static size_t shardIndex(const Reservation& reservation);
+    static size_t shardIndex(int reservationId);
+    const RoomAtomIndex* room(int roomId) const;
+
+    std::shared_ptr<const RoomIndexes> _rooms;
+    std::shared_ptr<const Shards> _shards;
+    size_t _numberOfReservations = 0;
+    DayNumber _extentFromDay = 0;
+    DayNumber _extentToDay = 0;
+  };
+
+  /**
+   * @brief The SnapshotBuilder class maintains the copy on write reservation shards behind PlanningSnapshot
+   *
+   * The shards hold the reservations of the board itself. Taking a snapshot shares the current shards with it, the
+   * first modification of a shard while a snapshot still refers to it copies the shard, subsequent modifications
+   * happen in place. The room indexes are maintained by the board in the same way.
+   *
+   * @see PlanningBoard
+   */
+  class SnapshotBuilder
+  {
+  public:
+    SnapshotBuilder();
+
+    void addReservation(std::shared_ptr<const Reservation> reservation);
+    void removeReservation(const Reservation& reservation);
+    void clear();
+
+    PlanningSnapshot snapshot(std::shared_ptr<const RoomIndexes> rooms, boost::gregorian::date_period extent) const;
+
+  private:
+    PlanningSnapshot::Shard& mutableShard(const Reservation& reservation);
+
+    std::shared_ptr<PlanningSnapshot::Shards> _shards;
+    size_t _numberOfReservations = 0;
+  };
+
+} // namespace hotel
+
+#endif // HOTEL_PLANNINGSNAPSHOT_H
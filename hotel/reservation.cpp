@@ -3,20 +3,38 @@
 namespace hotel
 {
 
-  Reservation::Reservation(const std::string& description)
-      : PersistentObject(), _status(Unknown), _description(description), _reservationOwnerPersonId(), _adults(0),
-        _children(0), _atoms()
+  Reservation::Reservation(std::string_view description)
+      : PersistentObject(), _status(Unknown), _description(description.data(), description.size()),
+        _reservationOwnerPersonId(), _adults(0), _children(0), _atoms()
   {
   }
 
-  hotel::Reservation::Reservation(const std::string& description, int roomId, boost::gregorian::date_period dateRange)
-      : _status(Unknown), _description(description), _reservationOwnerPersonId(), _adults(0), _children(0), _atoms()
+  hotel::Reservation::Reservation(std::string_view description, int roomId, boost::gregorian::date_period dateRange)
+      : _status(Unknown), _description(description.data(), description.size()), _reservationOwnerPersonId(),
+        _adults(0), _children(0), _atoms()
   {
     _atoms.push_back(ReservationAtom(roomId, dateRange));
   }
 
+  Reservation::Reservation(const Reservation& that, std::pmr::memory_resource* resource)
+      : PersistentObject(that), _status(that._status), _description(that._description, resource),
+        _reservationOwnerPersonId(that._reservationOwnerPersonId), _adults(that._adults), _children(that._children),
+        _atoms(that._atoms, resource)
+  {
+  }
+
+  Reservation::Reservation(Reservation&& that, std::pmr::memory_resource* resource)
+      : PersistentObject(that), _status(that._status), _description(std::move(that._description), resource),
+        _reservationOwnerPersonId(that._reservationOwnerPersonId), _adults(that._adults), _children(that._children),
+        _atoms(std::move(that._atoms), resource)
+  {
+  }
+
   void Reservation::setStatus(Reservation::ReservationStatus status) { _status = status; }
-  void Reservation::setDescription(const std::string& newDescription) { _description = newDescription; }
+  void Reservation::setDescription(std::string_view newDescription)
+  {
+    _description.assign(newDescription.data(), newDescription.size());
+  }
   void Reservation::setNumberOfAdults(int adults) { _adults = adults; }
   void Reservation::setNumberOfChildren(int children) { _children = children; }
   void Reservation::setReservationOwnerPerson(std::optional<int> personId) { _reservationOwnerPersonId = personId; }
@@ -63,13 +81,13 @@ namespace hotel
   }
 
   Reservation::ReservationStatus Reservation::status() const { return _status; }
-  const std::string& Reservation::description() const { return _description; }
+  std::string_view Reservation::description() const { return _description; }
   int Reservation::numberOfAdults() const { return _adults; }
   int Reservation::numberOfChildren() const { return _children; }
   std::optional<int> Reservation::reservationOwnerPersonId() const { return _reservationOwnerPersonId; }
 
-  const std::vector<ReservationAtom>& Reservation::atoms() const { return _atoms; }
-  std::vector<ReservationAtom>& Reservation::atoms() { return _atoms; }
+  const Reservation::AtomList& Reservation::atoms() const { return _atoms; }
+  Reservation::AtomList& Reservation::atoms() { return _atoms; }
 
   const ReservationAtom *Reservation::atomAtIndex(int i) const
   {
@@ -136,18 +154,25 @@ namespace hotel
   bool operator!=(const Reservation& a, const Reservation& b) { return !(a == b); }
 
   ReservationAtom::ReservationAtom(const int room, boost::gregorian::date_period dateRange)
-      : _roomId(room), _dateRange(dateRange)
+      : _roomId(room)
+  {
+    setDateRange(dateRange);
+  }
+
+  void ReservationAtom::setDateRange(boost::gregorian::date_period dateRange)
   {
+    _fromDay = toDayNumber(dateRange.begin());
+    _toDay = toDayNumber(dateRange.end());
   }
 
   bool ReservationAtom::intersectsWith(const ReservationAtom &other) const
   {
-    return roomId() == other.roomId() && dateRange().intersects(other.dateRange());
+    return roomId() == other.roomId() && periodsIntersect(_fromDay, _toDay, other._fromDay, other._toDay);
   }
 
   bool operator==(const ReservationAtom& a, const ReservationAtom& b)
   {
-    return a.roomId() == b.roomId() && a.dateRange() == b.dateRange();
+    return a.roomId() == b.roomId() && a.fromDay() == b.fromDay() && a.toDay() == b.toDay();
   }
 
   bool operator!=(const ReservationAtom& a, const ReservationAtom& b) { return !(a == b); }
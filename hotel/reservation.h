@@ -1,20 +1,57 @@
 #ifndef HOTEL_RESERVATION_H
 #define HOTEL_RESERVATION_H
 
+#include "hotel/daynumber.h"
+#include "hotel/inlinevector.h"
 #include "hotel/persistentobject.h"
-#include "hotel/reservation.h"
 
 #include <boost/date_time.hpp>
 
 #include <memory>
+#include <memory_resource>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace hotel
 {
 
-  class ReservationAtom;
+  /**
+   * @brief The ReservationAtom class represents one single reserved room over a given date period.
+   *
+   * The period is stored as a pair of day numbers, which keeps the atom small and allows the planning queries to work
+   * with plain integer comparisons. dateRange() converts it back to a boost period.
+   */
+  class ReservationAtom : public PersistentObject
+  {
+  public:
+    ReservationAtom(const int room, boost::gregorian::date_period dateRange);
+    ReservationAtom(const ReservationAtom& that) = default;
+
+    int roomId() const { return _roomId; }
+    boost::gregorian::date_period dateRange() const
+    {
+      return boost::gregorian::date_period(fromDayNumber(_fromDay), fromDayNumber(_toDay));
+    }
+    //! Returns the first day of the period, as day number
+    DayNumber fromDay() const { return _fromDay; }
+    //! Returns the day after the last day of the period (i.e. the checkout day), as day number
+    DayNumber toDay() const { return _toDay; }
+
+    void setDateRange(boost::gregorian::date_period dateRange);
+    void setRoomId(int id) { _roomId = id; }
+
+    //! Returns true if two items overlap
+    bool intersectsWith(const ReservationAtom& other) const;
+  private:
+    int _roomId;
+    DayNumber _fromDay;
+    DayNumber _toDay;
+  };
+
+  bool operator==(const ReservationAtom& a, const ReservationAtom& b);
+  bool operator!=(const ReservationAtom& a, const ReservationAtom& b);
 
   /**
    * @brief The Reservation class represents a single reservation over a given date period
@@ -27,12 +64,22 @@ namespace hotel
    *
    * More detailed information is stored in the DetailedReservation class.
    *
+   * The description and the atoms are allocator aware (std::pmr). By default they use the default memory resource, the
+   * allocator-extended constructors allow containers like the PlanningBoard to place them into an arena. The allocator
+   * stays an implementation detail: the description is passed and returned as a std::string_view.
+   *
+   * Up to two atoms are stored inline (see AtomList), which covers nearly all reservations. Together with the small
+   * string optimization of the description, creating and copying a typical reservation does not allocate at all.
+   *
    * @see ReservationAtom
    * @see DetailedReservation
    */
   class Reservation : public PersistentObject
   {
   public:
+    //! The atoms of a reservation, the first two of them are stored inline
+    typedef InlineVector<ReservationAtom, 2> AtomList;
+
     enum ReservationStatus
     {
       Unknown,
@@ -44,15 +91,19 @@ namespace hotel
       Archived
     };
 
-    Reservation(const std::string& description);
-    Reservation(const std::string& description, int roomId, boost::gregorian::date_period dateRange);
+    Reservation(std::string_view description);
+    Reservation(std::string_view description, int roomId, boost::gregorian::date_period dateRange);
     Reservation(const Reservation& that) = default;
     Reservation(Reservation&& that) = default;
+    //! Copies the given reservation, allocating the description and the atoms from the given memory resource
+    Reservation(const Reservation& that, std::pmr::memory_resource* resource);
+    //! Moves the given reservation, allocating the description and the atoms from the given memory resource
+    Reservation(Reservation&& that, std::pmr::memory_resource* resource);
     Reservation& operator=(const Reservation& that) = default;
     Reservation& operator=(Reservation&& that) = default;
 
     void setStatus(ReservationStatus status);
-    void setDescription(const std::string& newDescription);
+    void setDescription(std::string_view newDescription);
     void setNumberOfAdults(int adults);
     void setNumberOfChildren(int adults);
     void setReservationOwnerPerson(std::optional<int> personId);
@@ -64,13 +115,13 @@ namespace hotel
     void removeAllAtoms();
 
     ReservationStatus status() const;
-    const std::string& description() const;
+    std::string_view description() const;
     int numberOfAdults() const;
     int numberOfChildren() const;
     std::optional<int> reservationOwnerPersonId() const;
 
-    const std::vector<ReservationAtom>& atoms() const;
-    std::vector<ReservationAtom>& atoms();
+    const AtomList& atoms() const;
+    AtomList& atoms();
     const ReservationAtom* atomAtIndex(int i) const;
     const ReservationAtom* firstAtom() const;
     const ReservationAtom* lastAtom() const;
@@ -84,42 +135,18 @@ namespace hotel
 
   private:
     ReservationStatus _status;
-    std::string _description;
+    std::pmr::string _description;
 
     std::optional<int> _reservationOwnerPersonId;
 
     int _adults;
     int _children;
-    std::vector<ReservationAtom> _atoms;
+    AtomList _atoms;
   };
 
   bool operator==(const Reservation& a, const Reservation& b);
   bool operator!=(const Reservation& a, const Reservation& b);
 
-  /**
-   * @brief The ReservationAtom class represents one single reserved room over a given date period.
-   */
-  class ReservationAtom : public PersistentObject
-  {
-  public:
-    ReservationAtom(const int room, boost::gregorian::date_period dateRange);
-    ReservationAtom(const ReservationAtom& that) = default;
-
-    int roomId() const { return _roomId; }
-    boost::gregorian::date_period dateRange() const { return _dateRange; }
-
-    void setDateRange(boost::gregorian::date_period dateRange) { _dateRange = dateRange; }
-    void setRoomId(int id) { _roomId = id; }
-
-    //! Returns true if two items overlap
-    bool intersectsWith(const ReservationAtom& other) const;
-  private:
-    int _roomId;
-    boost::gregorian::date_period _dateRange;
-  };
-
-  bool operator==(const ReservationAtom& a, const ReservationAtom& b);
-  bool operator!=(const ReservationAtom& a, const ReservationAtom& b);
 
 } // namespace hotel
 
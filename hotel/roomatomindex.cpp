@@ -0,0 +1,139 @@
+#include "hotel/roomatomindex.h"
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <limits>
+
+namespace hotel
+{
+  void RoomAtomIndex::insert(const ReservationAtom* atom)
+  {
+    auto fromDay = atom->fromDay();
+    auto it = std::upper_bound(_entries.begin(), _entries.end(), fromDay,
+                               [](auto day, auto& x) { return day < x.fromDay; });
+    _entries.insert(it, makeEntry(atom));
+  }
+
+  void RoomAtomIndex::insert(std::vector<const ReservationAtom*> atoms)
+  {
+    auto oldSize = _entries.size();
+    _entries.reserve(oldSize + atoms.size());
+    for (auto atom : atoms)
+      _entries.push_back(makeEntry(atom));
+
+    auto byFromDay = [](auto& x, auto& y) { return x.fromDay < y.fromDay; };
+    std::sort(_entries.begin() + oldSize, _entries.end(), byFromDay);
+    std::inplace_merge(_entries.begin(), _entries.begin() + oldSize, _entries.end(), byFromDay);
+  }
+
+  std::optional<RoomAtomIndex::Entry> RoomAtomIndex::remove(const ReservationAtom* atom)
+  {
+    auto it = find(atom, atom->fromDay());
+    if (it == _entries.end())
+      return std::nullopt;
+
+    auto entry = *it;
+    _entries.erase(it);
+    return entry;
+  }
+
+  std::optional<RoomAtomIndex::Entry> RoomAtomIndex::update(const ReservationAtom* atom, DayNumber oldFromDay)
+  {
+    auto it = find(atom, oldFromDay);
+    if (it == _entries.end())
+    {
+      insert(atom);
+      return std::nullopt;
+    }
+
+    // Rotate the entry to its new position, the entries in between move by one
+    auto entry = *it;
+    auto newEntry = makeEntry(atom);
+    if (newEntry.fromDay < entry.fromDay)
+    {
+      auto position = std::upper_bound(_entries.begin(), it, newEntry.fromDay,
+                                       [](auto day, auto& x) { return day < x.fromDay; });
+      std::rotate(position, it, std::next(it));
+      *position = newEntry;
+    }
+    else
+    {
+      auto position = std::upper_bound(std::next(it), _entries.end(), newEntry.fromDay,
+                                       [](auto day, auto& x) { return day < x.fromDay; });
+      std::rotate(it, std::next(it), position);
+      *std::prev(position) = newEntry;
+    }
+    return entry;
+  }
+
+  void RoomAtomIndex::clear() { _entries.clear(); }
+
+  bool RoomAtomIndex::isFree(boost::gregorian::date_period period) const
+  {
+    // An empty period still occupies its begin date (see date_period::intersects)
+    auto fromDay = toDayNumber(period.begin());
+    auto toDay = std::max(toDayNumber(period.end()), fromDay + 1);
+
+    // Only the first atom ending after the begin of the period can intersect it, all following atoms begin later
+    auto it = firstEndingAfter(fromDay);
+    return it == _entries.end() || it->fromDay >= toDay;
+  }
+
+  bool RoomAtomIndex::isFree(DayNumber fromDay, DayNumber toDay, const Reservation& ignored) const
+  {
+    auto& ignoredAtoms = ignored.atoms();
+    auto isIgnored = [&ignoredAtoms](const ReservationAtom* atom) {
+      return std::less_equal<const ReservationAtom*>()(ignoredAtoms.data(), atom) &&
+             std::less<const ReservationAtom*>()(atom, ignoredAtoms.data() + ignoredAtoms.size());
+    };
+
+    for (auto it = firstEndingAfter(fromDay); it != _entries.end() && it->fromDay < toDay; ++it)
+      if (!isIgnored(it->atom))
+        return false;
+    return true;
+  }
+
+  int RoomAtomIndex::getAvailableDaysFrom(boost::gregorian::date date) const
+  {
+    // Find the first element which would influence the number of available days: i.e. atom.period.end > date
+    auto day = toDayNumber(date);
+    auto it = firstEndingAfter(day);
+    if (it == _entries.end())
+      return std::numeric_limits<int>::max();
+    else
+      return std::max<int>(0, it->fromDay - day);
+  }
+
+  int RoomAtomIndex::getAvailableDaysBefore(boost::gregorian::date date) const
+  {
+    // Only the last atom beginning before the date can end before or on the date, all previous atoms end earlier
+    auto day = toDayNumber(date);
+    auto it = std::lower_bound(_entries.begin(), _entries.end(), day, [](auto& x, auto day) { return x.fromDay < day; });
+    if (it == _entries.begin())
+      return std::numeric_limits<int>::max();
+    else
+      return std::max<int>(0, day - std::prev(it)->toDay);
+  }
+
+  std::vector<RoomAtomIndex::Entry>::const_iterator RoomAtomIndex::firstEndingAfter(DayNumber day) const
+  {
+    return std::upper_bound(_entries.begin(), _entries.end(), day, [](auto day, auto& x) { return day < x.toDay; });
+  }
+
+  std::vector<RoomAtomIndex::Entry>::iterator RoomAtomIndex::find(const ReservationAtom* atom, DayNumber fromDay)
+  {
+    // Atoms in one room do not overlap, thus only very few atoms (if any at all) can share the same begin date
+    auto it = std::lower_bound(_entries.begin(), _entries.end(), fromDay,
+                               [](auto& x, auto day) { return x.fromDay < day; });
+    for (; it != _entries.end() && it->fromDay == fromDay; ++it)
+    {
+      if (it->atom == atom)
+        return it;
+    }
+
+    // Fall back to a linear search, in case the atom has been modified after its insertion
+    return std::find_if(_entries.begin(), _entries.end(), [atom](auto& x) { return x.atom == atom; });
+  }
+
+} // namespace hotel
@@ -0,0 +1,121 @@
+#ifndef HOTEL_ROOMATOMINDEX_H
+#define HOTEL_ROOMATOMINDEX_H
+
+#include "hotel/daynumber.h"
+#include "hotel/reservation.h"
+
+#include <boost/date_time.hpp>
+
+#include <map>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace hotel
+{
+  /**
+   * @brief The RoomAtomIndex class is an interval index over all of the reservation atoms of a single room
+   *
+   * The atoms are kept sorted by their start date. Since the atoms of one room never overlap, they are implicitly also
+   * sorted by their end date, which allows all of the availability queries to be answered with a binary search.
+   *
+   * Every entry caches the period of its atom as day numbers next to the atom pointer, so the searches run over one
+   * dense array with integer comparisons and never have to dereference the atoms.
+   *
+   * @note The index does not verify that the inserted atoms do not overlap. This is the responsibility of the caller.
+   *
+   * @see PlanningBoard
+   */
+  class RoomAtomIndex
+  {
+  public:
+    /**
+     * @brief insert adds the given atom to the index, keeping the atoms sorted
+     * @note The insertion point is found in O(log n)
+     */
+    void insert(const ReservationAtom* atom);
+    /**
+     * @brief insert adds all of the given atoms to the index at once
+     *
+     * The new atoms are sorted and then merged into the existing ones, which is O(n + k log k) instead of the
+     * O(k * n) needed when inserting the atoms one by one.
+     */
+    void insert(std::vector<const ReservationAtom*> atoms);
+    struct Entry
+    {
+      DayNumber fromDay;
+      DayNumber toDay;
+      const ReservationAtom* atom;
+    };
+
+    /**
+     * @brief remove removes the given atom from the index
+     * @return the removed entry, holding the period the atom had when it was inserted, or nothing if the atom was not
+     *         found.
+     */
+    std::optional<Entry> remove(const ReservationAtom* atom);
+    /**
+     * @brief update moves the entry of the given atom to the position matching its current period
+     *
+     * This is used after the period of an atom has been changed in place. Only the entries between the old and the new
+     * position are shifted, instead of removing and inserting the entry.
+     *
+     * @param atom the modified atom, which must belong to this room
+     * @param oldFromDay the first day of the atom before it was modified
+     * @return the entry as it was before the update, or nothing if the atom was not found, in which case it is inserted
+     */
+    std::optional<Entry> update(const ReservationAtom* atom, DayNumber oldFromDay);
+    void clear();
+
+    bool empty() const { return _entries.empty(); }
+    size_t size() const { return _entries.size(); }
+
+    //! Returns all entries of the room, sorted by date
+    const std::vector<Entry>& entries() const { return _entries; }
+    const ReservationAtom* front() const { return _entries.empty() ? nullptr : _entries.front().atom; }
+    const ReservationAtom* back() const { return _entries.empty() ? nullptr : _entries.back().atom; }
+    //! Returns the first day occupied in this room, the index must not be empty
+    DayNumber firstDay() const { return _entries.front().fromDay; }
+    //! Returns the day after the last day occupied in this room, the index must not be empty
+    DayNumber endDay() const { return _entries.back().toDay; }
+
+    /**
+     * @brief isFree returns true if no atom intersects the given period
+     * @note This has the same semantics as boost::gregorian::date_period::intersects(), i.e. an empty period is only
+     *       considered to be free if its begin date is not occupied. The query is O(log n).
+     */
+    bool isFree(boost::gregorian::date_period period) const;
+    /**
+     * @brief isFree returns true if no atom, except for the atoms of the ignored reservation, intersects the
+     *        non-empty period [fromDay, toDay)
+     */
+    bool isFree(DayNumber fromDay, DayNumber toDay, const Reservation& ignored) const;
+
+    /**
+     * @brief getAvailableDaysFrom computes the number of days the room is available from the given date onwards
+     * @see PlanningBoard::getAvailableDaysFrom
+     */
+    int getAvailableDaysFrom(boost::gregorian::date date) const;
+    /**
+     * @brief getAvailableDaysBefore computes the number of days the room is available before the given date
+     * @see PlanningBoard::getAvailableDaysBefore
+     */
+    int getAvailableDaysBefore(boost::gregorian::date date) const;
+
+  private:
+    static Entry makeEntry(const ReservationAtom* atom) { return {atom->fromDay(), atom->toDay(), atom}; }
+
+    // Returns the first entry whose period ends after the given day
+    std::vector<Entry>::const_iterator firstEndingAfter(DayNumber day) const;
+    // Returns the entry of the given atom, which began at the given day when it was inserted
+    std::vector<Entry>::iterator find(const ReservationAtom* atom, DayNumber fromDay);
+
+    std::vector<Entry> _entries;
+  };
+
+  //! The room indexes of a planning board by room id, which are shared with its snapshots (see PlanningSnapshot)
+  using RoomIndexes = std::map<int, std::shared_ptr<RoomAtomIndex>>;
+
+} // namespace hotel
+
+#endif // HOTEL_ROOMATOMINDEX_H
@@ -0,0 +1,471 @@
+#include "persistence/binary/snapshot.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <tuple>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace persistence
+{
+  namespace binary
+  {
+    namespace
+    {
+      constexpr size_t sectionAlignment = 8;
+
+      class SnapshotWriter
+      {
+      public:
+        StringRef addString(std::string_view str)
+        {
+          StringRef ref{static_cast<uint32_t>(_strings.size()), static_cast<uint32_t>(str.size())};
+          _strings.append(str.data(), str.size());
+          return ref;
+        }
+
+        template <class T> SectionRef appendSection(const std::vector<T>& records)
+        {
+          align();
+          SectionRef section{_data.size(), records.size()};
+          auto bytes = reinterpret_cast<const char*>(records.data());
+          _data.insert(_data.end(), bytes, bytes + records.size() * sizeof(T));
+          return section;
+        }
+
+        SectionRef appendStrings()
+        {
+          align();
+          SectionRef section{_data.size(), _strings.size()};
+          _data.insert(_data.end(), _strings.begin(), _strings.end());
+          return section;
+        }
+
+        void reserveHeader() { _data.resize(sizeof(SnapshotHeader)); }
+        void writeHeader(SnapshotHeader header)
+        {
+          header.fileSize = _data.size();
+          std::memcpy(_data.data(), &header, sizeof(header));
+        }
+
+        const std::vector<char>& data() const { return _data; }
+        bool stringsFit() const { return _strings.size() <= std::numeric_limits<uint32_t>::max(); }
+
+      private:
+        void align() { _data.resize((_data.size() + sectionAlignment - 1) / sectionAlignment * sectionAlignment); }
+
+        std::vector<char> _data;
+        std::string _strings;
+      };
+
+      bool isValidSection(const SectionRef& section, size_t recordSize, size_t fileSize)
+      {
+        return section.offset % sectionAlignment == 0 && section.offset <= fileSize &&
+               section.count <= (fileSize - section.offset) / recordSize;
+      }
+
+      bool isValidRange(uint32_t first, uint32_t count, uint64_t size)
+      {
+        return static_cast<uint64_t>(first) + count <= size;
+      }
+
+      // Writes the given data to the given file and flushes it to the disk
+      bool writeFile(const std::string& fileName, const std::vector<char>& data)
+      {
+#ifndef _WIN32
+        int fd = ::open(fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0)
+          return false;
+        size_t written = 0;
+        while (written < data.size())
+        {
+          auto result = ::write(fd, data.data() + written, data.size() - written);
+          if (result < 0 && errno == EINTR)
+            continue;
+          if (result <= 0)
+          {
+            ::close(fd);
+            return false;
+          }
+          written += static_cast<size_t>(result);
+        }
+        bool isSynced = ::fsync(fd) == 0;
+        return ::close(fd) == 0 && isSynced;
+#else
+        std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        file.close();
+        return !file.fail();
+#endif
+      }
+
+      // Flushes the directory of the given file to the disk, which makes a rename of the file durable
+      bool syncDirectoryOf(const std::string& fileName)
+      {
+#ifndef _WIN32
+        auto separator = fileName.find_last_of('/');
+        auto directory =
+            separator == std::string::npos ? std::string(".") : fileName.substr(0, std::max<size_t>(separator, 1));
+        int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+        if (fd < 0)
+          return false;
+        bool isSynced = ::fsync(fd) == 0;
+        ::close(fd);
+        return isSynced;
+#else
+        return true;
+#endif
+      }
+    } // namespace
+
+    bool writeSnapshot(const std::string& fileName, const hotel::HotelCollection& hotels,
+                       const hotel::PlanningBoard& planning)
+    {
+      SnapshotWriter writer;
+      std::vector<HotelRecord> hotelRecords;
+      std::vector<CategoryRecord> categoryRecords;
+      std::vector<RoomRecord> roomRecords;
+      std::vector<ReservationRecord> reservationRecords;
+      std::vector<AtomRecord> atomRecords;
+
+      for (auto& hotel : hotels.hotels())
+      {
+        HotelRecord record{hotel->id(), hotel->revision(), writer.addString(hotel->name()),
+                           static_cast<uint32_t>(categoryRecords.size()),
+                           static_cast<uint32_t>(hotel->categories().size()),
+                           static_cast<uint32_t>(roomRecords.size()),
+                           static_cast<uint32_t>(hotel->rooms().size())};
+        hotelRecords.push_back(record);
+
+        for (auto& category : hotel->categories())
+          categoryRecords.push_back({category->id(), category->revision(), writer.addString(category->shortCode()),
+                                     writer.addString(category->name())});
+        for (auto& room : hotel->rooms())
+        {
+          auto& categories = hotel->categories();
+          auto categoryIt = std::find_if(categories.begin(), categories.end(),
+                                         [&room](const auto& category) { return category.get() == room->category(); });
+          if (categoryIt == categories.end())
+          {
+            std::cerr << "Cannot write snapshot, room " << room->name() << " has no category of its hotel" << std::endl;
+            return false;
+          }
+          roomRecords.push_back({room->id(), room->revision(), writer.addString(room->name()),
+                                 static_cast<uint32_t>(categoryIt - categories.begin())});
+        }
+      }
+
+      auto reservations = planning.reservations();
+      reservationRecords.reserve(reservations.size());
+      atomRecords.reserve(reservations.size());
+      for (auto reservation : reservations)
+      {
+        if (reservation->status() == hotel::Reservation::Temporary)
+          continue;
+
+        auto owner = reservation->reservationOwnerPersonId();
+        ReservationRecord record{reservation->id(),
+                                 reservation->revision(),
+                                 static_cast<int32_t>(reservation->status()),
+                                 reservation->numberOfAdults(),
+                                 reservation->numberOfChildren(),
+                                 owner.value_or(0),
+                                 owner.has_value(),
+                                 writer.addString(reservation->description()),
+                                 static_cast<uint32_t>(atomRecords.size()),
+                                 static_cast<uint32_t>(reservation->atoms().size())};
+        reservationRecords.push_back(record);
+        for (auto& atom : reservation->atoms())
+          atomRecords.push_back({atom.id(), atom.revision(), atom.roomId(), atom.fromDay(), atom.toDay()});
+      }
+
+      if (!writer.stringsFit() || atomRecords.size() > std::numeric_limits<uint32_t>::max())
+      {
+        std::cerr << "Cannot write snapshot, the planning state is too large" << std::endl;
+        return false;
+      }
+
+      SnapshotHeader header{};
+      std::memcpy(header.magic, snapshotMagic, sizeof(header.magic));
+      header.version = snapshotVersion;
+      header.byteOrderMark = snapshotByteOrderMark;
+      writer.reserveHeader();
+      header.hotels = writer.appendSection(hotelRecords);
+      header.categories = writer.appendSection(categoryRecords);
+      header.rooms = writer.appendSection(roomRecords);
+      header.reservations = writer.appendSection(reservationRecords);
+      header.atoms = writer.appendSection(atomRecords);
+      header.strings = writer.appendStrings();
+      writer.writeHeader(header);
+
+      // The new snapshot has to be on the disk before the rename makes it visible under the final name
+      auto temporaryFileName = fileName + ".tmp";
+      if (!writeFile(temporaryFileName, writer.data()))
+      {
+        std::cerr << "Cannot write snapshot " << temporaryFileName << std::endl;
+        std::remove(temporaryFileName.c_str());
+        return false;
+      }
+#ifdef _WIN32
+      // std::rename does not replace existing files on Windows
+      std::remove(fileName.c_str());
+#endif
+      if (std::rename(temporaryFileName.c_str(), fileName.c_str()) != 0)
+      {
+        std::cerr << "Cannot replace snapshot " << fileName << std::endl;
+        std::remove(temporaryFileName.c_str());
+        return false;
+      }
+      if (!syncDirectoryOf(fileName))
+      {
+        std::cerr << "Cannot flush the directory of snapshot " << fileName << std::endl;
+        return false;
+      }
+      return true;
+    }
+
+    SnapshotFile::~SnapshotFile() { close(); }
+
+    bool SnapshotFile::open(const std::string& fileName)
+    {
+      close();
+
+#ifndef _WIN32
+      int fd = ::open(fileName.c_str(), O_RDONLY);
+      if (fd < 0)
+      {
+        std::cerr << "Cannot open snapshot " << fileName << std::endl;
+        return false;
+      }
+      struct stat status;
+      if (fstat(fd, &status) != 0 || status.st_size < static_cast<off_t>(sizeof(SnapshotHeader)))
+      {
+        std::cerr << "Cannot read snapshot " << fileName << ", the file is too small" << std::endl;
+        ::close(fd);
+        return false;
+      }
+      auto size = static_cast<size_t>(status.st_size);
+      auto mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      ::close(fd);
+      if (mapping == MAP_FAILED)
+      {
+        std::cerr << "Cannot map snapshot " << fileName << " into memory" << std::endl;
+        return false;
+      }
+      _data = static_cast<const char*>(mapping);
+      _size = size;
+      _mapped = true;
+#else
+      std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+      if (!file || file.tellg() < static_cast<std::streamoff>(sizeof(SnapshotHeader)))
+      {
+        std::cerr << "Cannot read snapshot " << fileName << std::endl;
+        return false;
+      }
+      _size = static_cast<size_t>(file.tellg());
+      _buffer.resize((_size + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+      file.seekg(0);
+      if (!file.read(reinterpret_cast<char*>(_buffer.data()), static_cast<std::streamsize>(_size)))
+      {
+        std::cerr << "Cannot read snapshot " << fileName << std::endl;
+        _buffer.clear();
+        return false;
+      }
+      _data = reinterpret_cast<const char*>(_buffer.data());
+#endif
+
+      if (!validate())
+      {
+        std::cerr << "Cannot read snapshot " << fileName << ", the file is corrupt or has an unsupported version"
+                  << std::endl;
+        close();
+        return false;
+      }
+      return true;
+    }
+
+    void SnapshotFile::close()
+    {
+#ifndef _WIN32
+      if (_mapped)
+        munmap(const_cast<char*>(_data), _size);
+#endif
+      _buffer.clear();
+      _buffer.shrink_to_fit();
+      _data = nullptr;
+      _size = 0;
+      _mapped = false;
+    }
+
+    SnapshotFile::Records<CategoryRecord> SnapshotFile::categories(const HotelRecord& hotel) const
+    {
+      return Records<CategoryRecord>(categories().begin() + hotel.firstCategory, hotel.numberOfCategories);
+    }
+
+    SnapshotFile::Records<RoomRecord> SnapshotFile::rooms(const HotelRecord& hotel) const
+    {
+      return Records<RoomRecord>(rooms().begin() + hotel.firstRoom, hotel.numberOfRooms);
+    }
+
+    SnapshotFile::Records<AtomRecord> SnapshotFile::atoms(const ReservationRecord& reservation) const
+    {
+      return Records<AtomRecord>(atoms().begin() + reservation.firstAtom, reservation.numberOfAtoms);
+    }
+
+    std::string_view SnapshotFile::string(StringRef ref) const
+    {
+      return std::string_view(_data + header().strings.offset + ref.offset, ref.length);
+    }
+
+    void SnapshotFile::load(hotel::HotelCollection& hotels, hotel::PlanningBoard& planning) const
+    {
+      for (auto& hotelRecord : this->hotels())
+      {
+        auto hotel = std::make_unique<hotel::Hotel>(std::string(string(hotelRecord.name)));
+        hotel->setId(hotelRecord.id);
+        hotel->setRevision(hotelRecord.revision);
+
+        auto categoryRecords = categories(hotelRecord);
+        for (auto& categoryRecord : categoryRecords)
+        {
+          auto category = std::make_unique<hotel::RoomCategory>(std::string(string(categoryRecord.shortCode)),
+                                                                std::string(string(categoryRecord.name)));
+          category->setId(categoryRecord.id);
+          category->setRevision(categoryRecord.revision);
+          hotel->addRoomCategory(std::move(category));
+        }
+        for (auto& roomRecord : rooms(hotelRecord))
+        {
+          auto room = std::make_unique<hotel::HotelRoom>(std::string(string(roomRecord.name)));
+          room->setId(roomRecord.id);
+          room->setRevision(roomRecord.revision);
+          hotel->addRoom(std::move(room), hotel->categories()[roomRecord.category].get());
+        }
+        hotels.addHotel(std::move(hotel));
+      }
+
+      std::vector<hotel::Reservation> reservations;
+      reservations.reserve(this->reservations().size());
+      for (auto& reservationRecord : this->reservations())
+      {
+        auto& reservation = reservations.emplace_back(string(reservationRecord.description));
+        reservation.setId(reservationRecord.id);
+        reservation.setRevision(reservationRecord.revision);
+        reservation.setStatus(static_cast<hotel::Reservation::ReservationStatus>(reservationRecord.status));
+        reservation.setNumberOfAdults(reservationRecord.adults);
+        reservation.setNumberOfChildren(reservationRecord.children);
+        if (reservationRecord.hasOwnerPerson)
+          reservation.setReservationOwnerPerson(reservationRecord.ownerPersonId);
+
+        // The atoms have been checked for continuity by validate(), they can be appended directly
+        auto atomRecords = atoms(reservationRecord);
+        reservation.atoms().reserve(atomRecords.size());
+        for (auto& atomRecord : atomRecords)
+        {
+          hotel::ReservationAtom atom(atomRecord.roomId,
+                                      boost::gregorian::date_period(hotel::fromDayNumber(atomRecord.fromDay),
+                                                                    hotel::fromDayNumber(atomRecord.toDay)));
+          atom.setId(atomRecord.id);
+          atom.setRevision(atomRecord.revision);
+          reservation.atoms().push_back(atom);
+        }
+      }
+      planning.addReservations(reservations);
+    }
+
+    bool SnapshotFile::validate() const
+    {
+      if (_size < sizeof(SnapshotHeader))
+        return false;
+
+      auto& header = this->header();
+      if (std::memcmp(header.magic, snapshotMagic, sizeof(header.magic)) != 0 || header.version != snapshotVersion ||
+          header.byteOrderMark != snapshotByteOrderMark || header.fileSize != _size)
+        return false;
+
+      if (!isValidSection(header.hotels, sizeof(HotelRecord), _size) ||
+          !isValidSection(header.categories, sizeof(CategoryRecord), _size) ||
+          !isValidSection(header.rooms, sizeof(RoomRecord), _size) ||
+          !isValidSection(header.reservations, sizeof(ReservationRecord), _size) ||
+          !isValidSection(header.atoms, sizeof(AtomRecord), _size) || !isValidSection(header.strings, 1, _size))
+        return false;
+
+      auto stringsSize = header.strings.count;
+      auto isValidString = [stringsSize](StringRef ref) { return isValidRange(ref.offset, ref.length, stringsSize); };
+
+      for (auto& category : categories())
+        if (!isValidString(category.shortCode) || !isValidString(category.name))
+          return false;
+      std::vector<std::string_view> shortCodes;
+      for (auto& hotel : hotels())
+      {
+        if (!isValidString(hotel.name) ||
+            !isValidRange(hotel.firstCategory, hotel.numberOfCategories, header.categories.count) ||
+            !isValidRange(hotel.firstRoom, hotel.numberOfRooms, header.rooms.count))
+          return false;
+        for (auto& room : rooms(hotel))
+          if (room.category >= hotel.numberOfCategories)
+            return false;
+
+        // The short codes of the categories of a hotel are unique, see Hotel::addRoomCategory()
+        shortCodes.clear();
+        for (auto& category : categories(hotel))
+          shortCodes.push_back(string(category.shortCode));
+        std::sort(shortCodes.begin(), shortCodes.end());
+        if (std::adjacent_find(shortCodes.begin(), shortCodes.end()) != shortCodes.end())
+          return false;
+      }
+      for (auto& room : rooms())
+        if (!isValidString(room.name))
+          return false;
+
+      for (auto& reservation : reservations())
+      {
+        if (!isValidString(reservation.description) || reservation.numberOfAtoms == 0 ||
+            !isValidRange(reservation.firstAtom, reservation.numberOfAtoms, header.atoms.count) ||
+            reservation.status < hotel::Reservation::Unknown || reservation.status > hotel::Reservation::Archived)
+          return false;
+
+        // The atoms of a reservation have to be non empty and continuous, see Reservation::isValid()
+        auto atomRecords = atoms(reservation);
+        for (size_t i = 0; i < atomRecords.size(); ++i)
+          if (atomRecords[i].fromDay >= atomRecords[i].toDay ||
+              (i > 0 && atomRecords[i - 1].toDay != atomRecords[i].fromDay))
+            return false;
+      }
+
+      // The reservations have to fit on one planning board, otherwise load() could not add them: the ids are unique and
+      // the atoms in a room do not overlap
+      std::vector<int32_t> ids;
+      ids.reserve(header.reservations.count);
+      for (auto& reservation : reservations())
+        if (reservation.id != 0)
+          ids.push_back(reservation.id);
+      std::sort(ids.begin(), ids.end());
+      if (std::adjacent_find(ids.begin(), ids.end()) != ids.end())
+        return false;
+
+      std::vector<const AtomRecord*> atomsByRoom;
+      atomsByRoom.reserve(header.atoms.count);
+      for (auto& reservation : reservations())
+        for (auto& atom : atoms(reservation))
+          atomsByRoom.push_back(&atom);
+      std::sort(atomsByRoom.begin(), atomsByRoom.end(), [](auto a, auto b) {
+        return std::tie(a->roomId, a->fromDay) < std::tie(b->roomId, b->fromDay);
+      });
+      auto overlaps = [](auto a, auto b) { return a->roomId == b->roomId && b->fromDay < a->toDay; };
+      return std::adjacent_find(atomsByRoom.begin(), atomsByRoom.end(), overlaps) == atomsByRoom.end();
+    }
+
+  } // namespace binary
+} // namespace persistence
@@ -0,0 +1,222 @@
+#ifndef PERSISTENCE_BINARY_SNAPSHOT_H
+#define PERSISTENCE_BINARY_SNAPSHOT_H
+
+#include "hotel/hotelcollection.h"
+#include "hotel/planning.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace persistence
+{
+  namespace binary
+  {
+    /**
+     * @brief The binary snapshot format stores the planning state of a client (hotels and reservations) in one file
+     *
+     * The file is a header followed by flat arrays of fixed size records and a pool of (not null terminated) strings.
+     * Records refer to strings and to other records by index, never by address, thus the whole file can be mapped into
+     * memory and used in place without any parsing. All values are stored in the byte order of the machine which wrote
+     * the snapshot; a snapshot written on a machine with a different byte order is rejected like any other version.
+     *
+     * Layout (every section is aligned to 8 bytes):
+     *  - SnapshotHeader
+     *  - HotelRecord[numberOfHotels]
+     *  - CategoryRecord[numberOfCategories], grouped by hotel
+     *  - RoomRecord[numberOfRooms], grouped by hotel
+     *  - ReservationRecord[numberOfReservations]
+     *  - AtomRecord[numberOfAtoms], grouped by reservation
+     *  - the string pool
+     *
+     * The version has to be increased whenever the layout of any record changes.
+     */
+    constexpr char snapshotMagic[8] = {'H', 'O', 'T', 'E', 'L', 'S', 'N', 'P'};
+    constexpr uint32_t snapshotVersion = 1;
+    // Written as a number, so that the byte order of the file can be detected
+    constexpr uint32_t snapshotByteOrderMark = 0x01020304;
+
+    struct StringRef
+    {
+      uint32_t offset;
+      uint32_t length;
+    };
+
+    struct SectionRef
+    {
+      uint64_t offset;
+      uint64_t count;
+    };
+
+    struct SnapshotHeader
+    {
+      char magic[8];
+      uint32_t version;
+      uint32_t byteOrderMark;
+      uint64_t fileSize;
+      SectionRef hotels;
+      SectionRef categories;
+      SectionRef rooms;
+      SectionRef reservations;
+      SectionRef atoms;
+      //! The offset and the size in bytes of the string pool
+      SectionRef strings;
+    };
+
+    struct HotelRecord
+    {
+      int32_t id;
+      int32_t revision;
+      StringRef name;
+      uint32_t firstCategory;
+      uint32_t numberOfCategories;
+      uint32_t firstRoom;
+      uint32_t numberOfRooms;
+    };
+
+    struct CategoryRecord
+    {
+      int32_t id;
+      int32_t revision;
+      StringRef shortCode;
+      StringRef name;
+    };
+
+    struct RoomRecord
+    {
+      int32_t id;
+      int32_t revision;
+      StringRef name;
+      //! Index of the category within the categories of the hotel of the room
+      uint32_t category;
+    };
+
+    struct ReservationRecord
+    {
+      int32_t id;
+      int32_t revision;
+      int32_t status;
+      int32_t adults;
+      int32_t children;
+      int32_t ownerPersonId;
+      uint32_t hasOwnerPerson;
+      StringRef description;
+      uint32_t firstAtom;
+      uint32_t numberOfAtoms;
+    };
+
+    struct AtomRecord
+    {
+      int32_t id;
+      int32_t revision;
+      int32_t roomId;
+      hotel::DayNumber fromDay;
+      hotel::DayNumber toDay;
+    };
+
+    /**
+     * @brief writeSnapshot writes the given hotels and the reservations of the given planning board to a file
+     *
+     * The snapshot is written to a temporary file first, which is flushed to the disk (fsync) and then replaces the
+     * given file. The directory is flushed after the rename as well. Thus a crash while writing never leaves a
+     * truncated snapshot behind, either the old or the new snapshot survives. Temporary reservations are not stored.
+     *
+     * @note On Windows the files are not flushed explicitly, a crash of the system may lose the snapshot there.
+     *
+     * @return true on success, otherwise the error is reported on std::cerr
+     */
+    bool writeSnapshot(const std::string& fileName, const hotel::HotelCollection& hotels,
+                       const hotel::PlanningBoard& planning);
+
+    /**
+     * @brief The SnapshotFile class gives read access to a snapshot written by writeSnapshot()
+     *
+     * The file is mapped into memory (or read into a buffer on platforms without mmap). All sections, indexes and
+     * string references are validated once when the file is opened, afterwards the records can be accessed in place
+     * without any further checks. load() creates the hotel objects and fills a planning board from the records.
+     *
+     * A snapshot only reflects the state at the time it was written. After loading it, a client has to reconcile it
+     * with the data streams of the backend, which deliver the current state.
+     */
+    class SnapshotFile
+    {
+    public:
+      template <class T> class Records
+      {
+      public:
+        Records(const T* begin, size_t size) : _begin(begin), _size(size) {}
+
+        const T* begin() const { return _begin; }
+        const T* end() const { return _begin + _size; }
+        size_t size() const { return _size; }
+        bool empty() const { return _size == 0; }
+        const T& operator[](size_t i) const { return _begin[i]; }
+
+      private:
+        const T* _begin;
+        size_t _size;
+      };
+
+      SnapshotFile() = default;
+      SnapshotFile(const SnapshotFile& that) = delete;
+      SnapshotFile& operator=(const SnapshotFile& that) = delete;
+      ~SnapshotFile();
+
+      /**
+       * @brief open maps the given snapshot file into memory and validates it
+       * @return true on success. If the file does not exist, has a different version or is corrupt, false is returned
+       *         and the error is reported on std::cerr.
+       */
+      bool open(const std::string& fileName);
+      void close();
+      bool isOpen() const { return _data != nullptr; }
+
+      Records<HotelRecord> hotels() const { return records<HotelRecord>(header().hotels); }
+      Records<CategoryRecord> categories() const { return records<CategoryRecord>(header().categories); }
+      Records<RoomRecord> rooms() const { return records<RoomRecord>(header().rooms); }
+      Records<ReservationRecord> reservations() const { return records<ReservationRecord>(header().reservations); }
+      Records<AtomRecord> atoms() const { return records<AtomRecord>(header().atoms); }
+
+      Records<CategoryRecord> categories(const HotelRecord& hotel) const;
+      Records<RoomRecord> rooms(const HotelRecord& hotel) const;
+      Records<AtomRecord> atoms(const ReservationRecord& reservation) const;
+      std::string_view string(StringRef ref) const;
+
+      /**
+       * @brief load adds all hotels of the snapshot to the collection and all reservations to the planning board
+       *
+       * The reservations are added in one batch (see PlanningBoard::addReservations). Enabling arena allocation on the
+       * planning board beforehand makes loading large snapshots considerably faster.
+       *
+       * open() has already verified that the reservations of the snapshot fit on one planning board, thus load() only
+       * fails if the planning board is not empty.
+       *
+       * @throws std::logic_error if a reservation conflicts with a reservation already on the planning board, in which
+       *         case the hotels have been added but none of the reservations
+       */
+      void load(hotel::HotelCollection& hotels, hotel::PlanningBoard& planning) const;
+
+    private:
+      const SnapshotHeader& header() const { return *reinterpret_cast<const SnapshotHeader*>(_data); }
+      template <class T> Records<T> records(const SectionRef& section) const
+      {
+        static_assert(std::is_trivially_copyable_v<T>, "snapshot records must be trivially copyable");
+        return Records<T>(reinterpret_cast<const T*>(_data + section.offset), section.count);
+      }
+
+      bool validate() const;
+
+      const char* _data = nullptr;
+      size_t _size = 0;
+      // Used instead of the mapping on platforms without mmap
+      std::vector<uint64_t> _buffer;
+      bool _mapped = false;
+    };
+
+  } // namespace binary
+} // namespace persistence
+
+#endif // PERSISTENCE_BINARY_SNAPSHOT_H
@@ -8,6 +8,10 @@ namespace persistence
 {
   template <> StreamableType DataStream::GetStreamTypeFor<hotel::Hotel>() { return StreamableType::Hotel; }
   template <> StreamableType DataStream::GetStreamTypeFor<hotel::Reservation>() { return StreamableType::Reservation; }
+  template <> StreamableType DataStream::GetStreamTypeFor<hotel::RoomAvailability>()
+  {
+    return StreamableType::RoomAvailability;
+  }
 
   UniqueDataStreamHandle::UniqueDataStreamHandle(UniqueDataStreamHandle&& that)
       : _backend(that._backend), _dataStream(std::move(that._dataStream))
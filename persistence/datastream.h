@@ -18,7 +18,7 @@ namespace persistence
   /**
    * @brief The StreamableType enum holds all possible native data types a steam can have
    */
-  enum class StreamableType { NullStream, Hotel, Reservation };
+  enum class StreamableType { NullStream, Hotel, Reservation, RoomAvailability };
 
   struct DataStreamItemsAdded { StreamableItems newItems; };
   struct DataStreamItemsUpdated { StreamableItems updatedItems; };
@@ -0,0 +1,29 @@
+#include "persistence/datastreamdiff.h"
+
+namespace persistence
+{
+  namespace
+  {
+    std::vector<hotel::Reservation> copyReservations(const std::vector<const hotel::Reservation*>& reservations)
+    {
+      std::vector<hotel::Reservation> result;
+      result.reserve(reservations.size());
+      for (auto reservation : reservations)
+        result.push_back(*reservation);
+      return result;
+    }
+  } // namespace
+
+  std::vector<DataStreamChange> makeDataStreamChanges(const hotel::PlanningDiff& diff)
+  {
+    std::vector<DataStreamChange> changes;
+    if (!diff.removed.empty())
+      changes.push_back(DataStreamItemsRemoved{diff.removed});
+    if (!diff.updated.empty())
+      changes.push_back(DataStreamItemsUpdated{copyReservations(diff.updated)});
+    if (!diff.added.empty())
+      changes.push_back(DataStreamItemsAdded{copyReservations(diff.added)});
+    return changes;
+  }
+
+} // namespace persistence
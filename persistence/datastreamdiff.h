@@ -0,0 +1,26 @@
+#ifndef PERSISTENCE_DATASTREAMDIFF_H
+#define PERSISTENCE_DATASTREAMDIFF_H
+
+#include "persistence/datastream.h"
+
+#include "hotel/planningdiff.h"
+
+#include <vector>
+
+namespace persistence
+{
+  /**
+   * @brief makeDataStreamChanges expresses the given diff as changes of a reservation stream
+   *
+   * Applying the changes to an observer which holds the source state of the diff brings it to the target state, thus a
+   * reconnecting client (or a client starting from a snapshot) only has to receive the differences instead of a full
+   * reload. The removals come first, followed by the updates and the additions. Empty changes are left out, an empty
+   * diff results in no changes at all.
+   *
+   * @see hotel::diffReservations
+   */
+  std::vector<DataStreamChange> makeDataStreamChanges(const hotel::PlanningDiff& diff);
+
+} // namespace persistence
+
+#endif // PERSISTENCE_DATASTREAMDIFF_H
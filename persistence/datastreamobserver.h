@@ -1,6 +1,7 @@
 #ifndef PERSISTENCE_DATASTREAMOBSERVER_H
 #define PERSISTENCE_DATASTREAMOBSERVER_H
 
+#include "hotel/availabilitysearch.h"
 #include "hotel/hotel.h"
 #include "hotel/reservation.h"
 
@@ -10,7 +11,8 @@
 
 namespace persistence
 {
-  typedef std::variant<std::vector<hotel::Hotel>, std::vector<hotel::Reservation>> StreamableItems;
+  typedef std::variant<std::vector<hotel::Hotel>, std::vector<hotel::Reservation>, std::vector<hotel::RoomAvailability>>
+      StreamableItems;
 
   /**
    * @brief The DataStreamObserver class is the baseclass for all classes who want to listen to datastreams
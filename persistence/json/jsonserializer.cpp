@@ -159,6 +159,29 @@ namespace persistence
       return {{"Person", "Person"}};
     }
 
+    template <> nlohmann::json serialize(const hotel::RoomAvailability& item)
+    {
+      nlohmann::json obj = serialize<hotel::PersistentObject>(item);
+      obj["hotel_id"] = item.hotelId();
+      obj["category_id"] = item.categoryId();
+      obj["from"] = boost::gregorian::to_iso_extended_string(item.dateRange().begin());
+      obj["to"] = boost::gregorian::to_iso_extended_string(item.dateRange().end());
+      obj["gap_before"] = item.gapBefore();
+      obj["gap_after"] = item.gapAfter();
+      return obj;
+    }
+    template <> hotel::RoomAvailability deserialize(const nlohmann::json& json)
+    {
+      auto fromDate = boost::gregorian::from_string(json["from"]);
+      auto toDate = boost::gregorian::from_string(json["to"]);
+
+      hotel::RoomAvailability availability(json["id"], json["hotel_id"], json["category_id"],
+                                           boost::gregorian::date_period(fromDate, toDate), json["gap_before"],
+                                           json["gap_after"]);
+      deserializePersistentObject(availability, json);
+      return availability;
+    }
+
 
     template <> nlohmann::json serialize(const op::Operation& operation)
     {
@@ -3,6 +3,7 @@
 
 #include "persistence/op/operations.h"
 
+#include "hotel/availabilitysearch.h"
 #include "hotel/hotel.h"
 #include "hotel/hotelcollection.h"
 #include "hotel/planning.h"
@@ -27,6 +28,7 @@ namespace persistence
     template <> nlohmann::json serialize(const hotel::Reservation::ReservationStatus& item);
     template <> nlohmann::json serialize(const hotel::ReservationAtom& item);
     template <> nlohmann::json serialize(const hotel::Person& item);
+    template <> nlohmann::json serialize(const hotel::RoomAvailability& item);
     template <> nlohmann::json serialize(const persistence::op::StreamableType& type);
 
     void deserializePersistentObject(hotel::PersistentObject& item, const nlohmann::json& json);
@@ -37,6 +39,7 @@ namespace persistence
     template <> hotel::ReservationAtom deserialize(const nlohmann::json& json);
     template <> hotel::Reservation::ReservationStatus deserialize(const nlohmann::json& json);
     template <> hotel::Person deserialize(const nlohmann::json& json);
+    template <> hotel::RoomAvailability deserialize(const nlohmann::json& json);
 
     template <> persistence::op::StreamableType deserialize(const nlohmann::json& json);
     template <> std::optional<persistence::op::Operation> deserialize(const nlohmann::json& json);
@@ -146,6 +146,14 @@ namespace persistence
           data.push_back(persistence::json::deserialize<hotel::Reservation>(item));
         return StreamableItems(std::move(data));
       }
+      else if (type == "room_availability")
+      {
+        std::vector<hotel::RoomAvailability> data;
+        data.reserve(array.size());
+        for (auto &item : array)
+          data.push_back(persistence::json::deserialize<hotel::RoomAvailability>(item));
+        return StreamableItems(std::move(data));
+      }
       else
       {
         // Unknown type...
@@ -155,6 +163,10 @@ namespace persistence
 
     template<> std::string JsonSerializer::serializeListType<std::vector<hotel::Hotel>>() { return "hotel"; }
     template<> std::string JsonSerializer::serializeListType<std::vector<hotel::Reservation>>() { return "reservation"; }
+    template<> std::string JsonSerializer::serializeListType<std::vector<hotel::RoomAvailability>>()
+    {
+      return "room_availability";
+    }
 
     std::string JsonSerializer::serializeListType(const StreamableItems &items)
     {
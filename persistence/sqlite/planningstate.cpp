@@ -0,0 +1,222 @@
+#include "persistence/sqlite/planningstate.h"
+
+#include "persistence/sqlite/sqlitestorage.h"
+
+#include "hotel/batchvalidator.h"
+
+#include <cassert>
+
+namespace persistence
+{
+  namespace sqlite
+  {
+    void PlanningState::load(SqliteStorage& storage)
+    {
+      clear();
+      for (auto& hotel : storage.loadAll<hotel::Hotel>())
+        _hotels.addHotel(std::make_unique<hotel::Hotel>(std::move(hotel)));
+
+      // Add the reservations as one batch, except for the later one of each overlapping pair
+      auto reservations = storage.loadAll<hotel::Reservation>();
+      std::vector<bool> isDeferred(reservations.size(), false);
+      for (auto& conflict : hotel::BatchValidator(_planning).validate(reservations))
+        isDeferred[conflict.otherCandidate.value_or(conflict.candidate)] = true;
+
+      std::vector<hotel::Reservation> batch;
+      std::vector<const hotel::Reservation*> deferred;
+      for (size_t i = 0; i < reservations.size(); ++i)
+      {
+        if (!isDeferred[i])
+          batch.push_back(std::move(reservations[i]));
+        else if (reservations[i].isValid())
+          deferred.push_back(&reservations[i]);
+      }
+      for (auto reservation : _planning.addReservations(batch))
+        _frontDesk.add(*reservation);
+      for (auto reservation : deferred)
+        insertReservation(*reservation);
+      _changes = PlanningChanges();
+    }
+
+    void PlanningState::clear()
+    {
+      _frontDesk.clear();
+      _planning.clear();
+      _hotels.clear();
+      _overlapping.clear();
+      _blockers.clear();
+      _nextBlockerId = -1;
+      _changes = PlanningChanges();
+      _changes.reset = true;
+    }
+
+    void PlanningState::storeHotel(const hotel::Hotel& hotel)
+    {
+      // The collection cannot replace a hotel, thus it is rebuilt. Hotels are changed rarely.
+      hotel::HotelCollection hotels;
+      for (auto& existingHotel : _hotels.hotels())
+        if (existingHotel->id() != hotel.id())
+          hotels.addHotel(std::make_unique<hotel::Hotel>(*existingHotel));
+      hotels.addHotel(std::make_unique<hotel::Hotel>(hotel));
+      _hotels = std::move(hotels);
+      _changes.hotelIds.insert(hotel.id());
+    }
+
+    void PlanningState::storeReservation(const hotel::Reservation& reservation)
+    {
+      eraseReservation(reservation.id());
+      if (reservation.isValid())
+      {
+        recordChange(reservation);
+        insertReservation(reservation);
+      }
+    }
+
+    void PlanningState::removeReservation(int reservationId) { eraseReservation(reservationId); }
+
+    const hotel::Reservation* PlanningState::reservation(int reservationId) const
+    {
+      auto overlappingIt = _overlapping.find(reservationId);
+      if (overlappingIt != _overlapping.end())
+        return overlappingIt->second.get();
+      return reservationId > 0 ? _planning.getReservationById(reservationId) : nullptr;
+    }
+
+    std::vector<const hotel::Reservation*> PlanningState::overlappingReservations() const
+    {
+      std::vector<const hotel::Reservation*> result;
+      result.reserve(_overlapping.size());
+      for (auto& overlapping : _overlapping)
+        result.push_back(overlapping.second.get());
+      return result;
+    }
+
+    std::vector<const hotel::Reservation*> PlanningState::blockers() const
+    {
+      std::vector<const hotel::Reservation*> result;
+      for (auto& blockers : _blockers)
+        for (auto blockerId : blockers.second)
+          result.push_back(_planning.getReservationById(blockerId));
+      return result;
+    }
+
+    PlanningChanges PlanningState::takeChanges()
+    {
+      PlanningChanges changes;
+      std::swap(changes, _changes);
+      return changes;
+    }
+
+    void PlanningState::insertReservation(const hotel::Reservation& reservation)
+    {
+      assert(reservation.isValid());
+      if (_planning.canAddReservation(reservation))
+      {
+        _frontDesk.add(*_planning.addReservation(std::make_unique<hotel::Reservation>(reservation)));
+        return;
+      }
+
+      auto& overlapping = _overlapping[reservation.id()];
+      overlapping = std::make_unique<hotel::Reservation>(reservation);
+      _frontDesk.add(*overlapping);
+      placeBlockers(*overlapping);
+    }
+
+    void PlanningState::eraseReservation(int reservationId)
+    {
+      auto overlappingIt = _overlapping.find(reservationId);
+      if (overlappingIt != _overlapping.end())
+      {
+        recordChange(*overlappingIt->second);
+        removeBlockers(reservationId);
+        _frontDesk.remove(*overlappingIt->second);
+        _overlapping.erase(overlappingIt);
+      }
+      else if (auto reservation = reservationId > 0 ? _planning.getReservationById(reservationId) : nullptr)
+      {
+        recordChange(*reservation);
+        _frontDesk.remove(*reservation);
+        _planning.removeReservation(reservation);
+      }
+      else
+      {
+        return;
+      }
+
+      // The days of the removed reservation may have been shared with an overlapping reservation
+      if (!_overlapping.empty())
+        rebuildOverlapping();
+    }
+
+    void PlanningState::placeBlockers(const hotel::Reservation& reservation)
+    {
+      auto& blockerIds = _blockers[reservation.id()];
+      for (auto& atom : reservation.atoms())
+      {
+        // Cover each run of days of the atom which is still free
+        auto addBlocker = [&](hotel::DayNumber fromDay, hotel::DayNumber toDay) {
+          boost::gregorian::date_period period(hotel::fromDayNumber(fromDay), hotel::fromDayNumber(toDay));
+          auto blocker = std::make_unique<hotel::Reservation>("", atom.roomId(), period);
+          blocker->setId(_nextBlockerId--);
+          blockerIds.push_back(blocker->id());
+          _planning.addReservation(std::move(blocker));
+        };
+
+        auto runBegin = atom.fromDay();
+        for (auto day = atom.fromDay(); day < atom.toDay(); ++day)
+        {
+          boost::gregorian::date_period night(hotel::fromDayNumber(day), hotel::fromDayNumber(day + 1));
+          if (_planning.isFree(atom.roomId(), night))
+            continue;
+          if (runBegin < day)
+            addBlocker(runBegin, day);
+          runBegin = day + 1;
+        }
+        if (runBegin < atom.toDay())
+          addBlocker(runBegin, atom.toDay());
+      }
+    }
+
+    void PlanningState::removeBlockers(int reservationId)
+    {
+      auto blockersIt = _blockers.find(reservationId);
+      if (blockersIt == _blockers.end())
+        return;
+      for (auto blockerId : blockersIt->second)
+        _planning.removeReservation(blockerId);
+      _blockers.erase(blockersIt);
+    }
+
+    void PlanningState::rebuildOverlapping()
+    {
+      for (auto& overlapping : _overlapping)
+        removeBlockers(overlapping.first);
+
+      for (auto it = _overlapping.begin(); it != _overlapping.end();)
+      {
+        auto& reservation = *it->second;
+        if (_planning.canAddReservation(reservation))
+        {
+          _frontDesk.remove(reservation);
+          _frontDesk.add(*_planning.addReservation(std::make_unique<hotel::Reservation>(reservation)));
+          it = _overlapping.erase(it);
+        }
+        else
+        {
+          ++it;
+        }
+      }
+      for (auto& overlapping : _overlapping)
+        placeBlockers(*overlapping.second);
+    }
+
+    void PlanningState::recordChange(const hotel::Reservation& reservation)
+    {
+      for (auto& atom : reservation.atoms())
+        _changes.roomPeriods.push_back({atom.roomId(), atom.fromDay(), atom.toDay()});
+      if (reservation.isValid())
+        _changes.stays.push_back({reservation.firstAtom()->fromDay(), reservation.lastAtom()->toDay()});
+    }
+
+  } // namespace sqlite
+} // namespace persistence
@@ -0,0 +1,125 @@
+#ifndef PERSISTENCE_SQLITE_PLANNINGSTATE_H
+#define PERSISTENCE_SQLITE_PLANNINGSTATE_H
+
+#include "hotel/daynumber.h"
+#include "hotel/frontdeskindex.h"
+#include "hotel/hotelcollection.h"
+#include "hotel/planning.h"
+#include "hotel/reservation.h"
+
+#include <map>
+#include <memory>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+namespace persistence
+{
+  namespace sqlite
+  {
+    class SqliteStorage;
+
+    /**
+     * @brief The PlanningChanges struct summarizes the modifications of a PlanningState since the changes have been
+     *        taken the last time
+     *
+     * Derived data streams use it to decide whether their results can have changed.
+     */
+    struct PlanningChanges
+    {
+      //! The period occupied by an atom of a changed reservation
+      struct RoomPeriod
+      {
+        int roomId;
+        hotel::DayNumber fromDay;
+        hotel::DayNumber toDay;
+      };
+      //! The arrival and departure day of a changed reservation
+      struct Stay
+      {
+        hotel::DayNumber arrival;
+        hotel::DayNumber departure;
+      };
+
+      //! True if the whole state has been replaced, e.g. because all data has been erased
+      bool reset = false;
+      //! The hotels which have been added or updated
+      std::set<int> hotelIds;
+      //! The atoms of the reservations which have been added, updated or removed, both before and after the change
+      std::vector<RoomPeriod> roomPeriods;
+      //! The stays of the reservations which have been added, updated or removed, both before and after the change
+      std::vector<Stay> stays;
+
+      bool empty() const { return !reset && hotelIds.empty() && roomPeriods.empty() && stays.empty(); }
+    };
+
+    /**
+     * @brief The PlanningState class is the in-memory copy of all hotels and reservations of a SqliteBackend
+     *
+     * It is loaded once and then kept in sync with the database by the backend, which allows the derived data streams
+     * and the validation of new reservations to work without loading anything from the database.
+     *
+     * The planning board requires the atoms of a room not to overlap, which reservations written before the validation
+     * existed do not always satisfy. Such an overlapping reservation is kept next to the board and is represented on it
+     * by "blocker" reservations (with negative ids), which cover the days it occupies and which are not already taken
+     * by another reservation. Thus the board still treats all of its rooms as occupied. The front desk index holds all
+     * reservations, including the overlapping ones.
+     *
+     * @note The state is not synchronized, the backend only modifies it while holding its commit mutex.
+     */
+    class PlanningState
+    {
+    public:
+      /**
+       * @brief load replaces the state with the hotels and reservations in the given storage
+       * @note The changes are discarded, the state is expected to match what the streams have been sent already.
+       */
+      void load(SqliteStorage& storage);
+      void clear();
+
+      //! @brief storeHotel adds the given hotel or replaces the hotel with the same id
+      void storeHotel(const hotel::Hotel& hotel);
+      //! @brief storeReservation adds the given reservation or replaces the reservation with the same id
+      void storeReservation(const hotel::Reservation& reservation);
+      void removeReservation(int reservationId);
+
+      const hotel::HotelCollection& hotels() const { return _hotels; }
+      //! @brief planning returns the board with all reservations, except for the overlapping ones (see above)
+      const hotel::PlanningBoard& planning() const { return _planning; }
+      //! @brief frontDesk returns the front desk index of all valid reservations
+      const hotel::FrontDeskIndex& frontDesk() const { return _frontDesk; }
+
+      //! @brief reservation returns the reservation with the given id, or nullptr if there is none
+      const hotel::Reservation* reservation(int reservationId) const;
+      //! @brief overlappingReservations returns the reservations which overlap with the reservations on the board
+      std::vector<const hotel::Reservation*> overlappingReservations() const;
+      //! @brief blockers returns the reservations on the board which stand in for the overlapping reservations
+      std::vector<const hotel::Reservation*> blockers() const;
+
+      //! @brief takeChanges returns the changes since the last call and resets them
+      PlanningChanges takeChanges();
+
+    private:
+      void insertReservation(const hotel::Reservation& reservation);
+      void eraseReservation(int reservationId);
+      void placeBlockers(const hotel::Reservation& reservation);
+      void removeBlockers(int reservationId);
+      //! Puts every overlapping reservation back on the board which fits again and recomputes the other blockers
+      void rebuildOverlapping();
+      void recordChange(const hotel::Reservation& reservation);
+
+      hotel::HotelCollection _hotels;
+      hotel::PlanningBoard _planning;
+      hotel::FrontDeskIndex _frontDesk;
+      // The reservations which do not fit on the board, by id
+      std::map<int, std::unique_ptr<hotel::Reservation>> _overlapping;
+      // The ids of the blockers on the board, by the id of their overlapping reservation
+      std::unordered_map<int, std::vector<int>> _blockers;
+      int _nextBlockerId = -1;
+      PlanningChanges _changes;
+    };
+
+  } // namespace sqlite
+} // namespace persistence
+
+#endif // PERSISTENCE_SQLITE_PLANNINGSTATE_H
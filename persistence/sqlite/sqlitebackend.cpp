@@ -2,7 +2,15 @@
 
 #include "persistence/changequeue.h"
 
+#include "hotel/availabilitysearch.h"
+#include "hotel/batchvalidator.h"
+
+#include <algorithm>
 #include <cassert>
+#include <iostream>
+#include <limits>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace persistence
 {
@@ -23,6 +31,9 @@ namespace persistence
           return initializeTyped<hotel::Hotel>(stream, changeQueue, storage);
         case StreamableType::Reservation:
           return initializeTyped<hotel::Reservation>(stream, changeQueue, storage);
+        case StreamableType::RoomAvailability:
+          // Availabilities are not stored, they are computed by the availability services
+          return;
         }
       }
 
@@ -74,6 +85,9 @@ namespace persistence
           return initializeTyped<hotel::Hotel>(stream, changeQueue, storage);
         case StreamableType::Reservation:
           return initializeTyped<hotel::Reservation>(stream, changeQueue, storage);
+        case StreamableType::RoomAvailability:
+          // Availabilities are not stored, they are computed by the availability services
+          return;
         }
       }
 
@@ -137,7 +151,364 @@ namespace persistence
       }
     };
 
-    DataStreamManager::DataStreamManager()
+    /**
+     * @brief The DerivedDataStreamHandler class is the base class of the handlers whose items are computed from the
+     *        planning state of the backend, instead of being stored
+     *
+     * The handler keeps the last items of every stream. Once a transaction has been committed, only the streams which
+     * are affected by its changes are recomputed, and only the difference to their last items is sent. Subclasses
+     * supply the query and decide which changes affect a stream.
+     */
+    template <class T> class DerivedDataStreamHandler : public DataStreamHandler
+    {
+    public:
+      //! The items of ranked streams are sent in order, the order of unordered streams is unspecified
+      enum class Order { Unordered, Ranked };
+
+      DerivedDataStreamHandler(const sqlite::PlanningState& state, Order order) : _state(state), _order(order) {}
+      virtual ~DerivedDataStreamHandler() = default;
+
+      virtual void initialize(DataStream& stream, std::vector<DataStreamDifferential>& changeQueue,
+                              [[maybe_unused]] sqlite::SqliteStorage& storage) override
+      {
+        auto items = query(stream.streamOptions());
+        std::lock_guard<std::mutex> lock(_itemsMutex);
+        _items[stream.streamId()] = items;
+        changeQueue.push_back({stream.streamId(), DataStreamItemsAdded{std::move(items)}});
+      }
+
+      virtual void addItems([[maybe_unused]] DataStream& stream,
+                            [[maybe_unused]] std::vector<DataStreamDifferential>& changeQueue,
+                            [[maybe_unused]] const StreamableItems& items) override
+      {
+      }
+
+      virtual void updateItems([[maybe_unused]] DataStream& stream,
+                               [[maybe_unused]] std::vector<DataStreamDifferential>& changeQueue,
+                               [[maybe_unused]] const StreamableItems& items) override
+      {
+      }
+
+      virtual void removeItems([[maybe_unused]] DataStream& stream,
+                               [[maybe_unused]] std::vector<DataStreamDifferential>& changeQueue,
+                               [[maybe_unused]] const std::vector<int> ids) override
+      {
+      }
+
+      virtual void clear([[maybe_unused]] DataStream& stream,
+                         [[maybe_unused]] std::vector<DataStreamDifferential>& changeQueue) override
+      {
+        // The message erasing all data may still be rolled back, the items are recomputed by dataChanged()
+      }
+
+      virtual void dataChanged(DataStream& stream, std::vector<DataStreamDifferential>& changeQueue,
+                               const sqlite::PlanningChanges& changes) override
+      {
+        std::lock_guard<std::mutex> lock(_itemsMutex);
+        auto& items = _items[stream.streamId()];
+        if (!changes.reset && !isAffected(stream.streamOptions(), items, changes))
+          return;
+
+        auto newItems = query(stream.streamOptions());
+        sendDifference(stream, changeQueue, items, newItems);
+        items = std::move(newItems);
+      }
+
+      virtual void streamRemoved(const DataStream& stream) override
+      {
+        std::lock_guard<std::mutex> lock(_itemsMutex);
+        _items.erase(stream.streamId());
+      }
+
+      virtual bool loadsFromStorage() const override { return false; }
+
+    protected:
+      //! @brief query computes the items of a stream with the given options from the planning state
+      virtual std::vector<T> query(const nlohmann::json& options) const = 0;
+      //! @brief isAffected returns true if the given changes can modify the items of a stream
+      virtual bool isAffected(const nlohmann::json& options, const std::vector<T>& items,
+                              const sqlite::PlanningChanges& changes) const = 0;
+
+      const sqlite::PlanningState& _state;
+
+    private:
+      void sendDifference(DataStream& stream, std::vector<DataStreamDifferential>& changeQueue,
+                          const std::vector<T>& oldItems, const std::vector<T>& newItems) const
+      {
+        std::unordered_map<int, const T*> oldItemsById;
+        for (auto& item : oldItems)
+          oldItemsById.emplace(item.id(), &item);
+
+        std::unordered_set<int> newIds;
+        std::vector<T> updatedItems;
+        std::vector<T> addedItems;
+        for (auto& item : newItems)
+        {
+          newIds.insert(item.id());
+          auto oldIt = oldItemsById.find(item.id());
+          if (oldIt == oldItemsById.end())
+            addedItems.push_back(item);
+          else if (*oldIt->second != item)
+            updatedItems.push_back(item);
+        }
+        std::vector<int> removedIds;
+        for (auto& item : oldItems)
+          if (newIds.count(item.id()) == 0)
+            removedIds.push_back(item.id());
+
+        // Observers append added items, thus the difference keeps the ranking only if the remaining items stay in order
+        // and the added items come last. Otherwise the stream is sent anew.
+        if (_order == Order::Ranked)
+        {
+          std::vector<int> orderAfterDifference;
+          for (auto& item : oldItems)
+            if (newIds.count(item.id()) != 0)
+              orderAfterDifference.push_back(item.id());
+          for (auto& item : addedItems)
+            orderAfterDifference.push_back(item.id());
+          if (!std::equal(orderAfterDifference.begin(), orderAfterDifference.end(), newItems.begin(), newItems.end(),
+                          [](int id, const T& item) { return id == item.id(); }))
+          {
+            changeQueue.push_back({stream.streamId(), DataStreamCleared{}});
+            changeQueue.push_back({stream.streamId(), DataStreamItemsAdded{newItems}});
+            return;
+          }
+        }
+
+        if (!removedIds.empty())
+          changeQueue.push_back({stream.streamId(), DataStreamItemsRemoved{std::move(removedIds)}});
+        if (!updatedItems.empty())
+          changeQueue.push_back({stream.streamId(), DataStreamItemsUpdated{std::move(updatedItems)}});
+        if (!addedItems.empty())
+          changeQueue.push_back({stream.streamId(), DataStreamItemsAdded{std::move(addedItems)}});
+      }
+
+      Order _order;
+      std::mutex _itemsMutex;
+      // The last items sent, by stream id
+      std::unordered_map<int, std::vector<T>> _items;
+    };
+
+    /**
+     * @brief The AvailabilityDataStreamHandler class implements the availability search services
+     *
+     * The items of the stream are the results of an AvailabilitySearch over the planning state of the backend. A
+     * stream is recomputed when a changed reservation occupies one of its rooms within the searched period or within
+     * the free gap around one of its results, or when one of its hotels changes. The supported options are:
+     *  - "hotel_id", "category_id" (optional): Only search the rooms of the given hotel or category
+     *  - "from", "to" (availability.free_rooms): The period (ISO dates) for which the rooms have to be free
+     *  - "from", "to", "nights" (availability.earliest): The range of arrival dates to search, and the length of stay
+     */
+    class AvailabilityDataStreamHandler : public DerivedDataStreamHandler<hotel::RoomAvailability>
+    {
+    public:
+      enum class Mode { FreeRooms, Earliest };
+
+      AvailabilityDataStreamHandler(const sqlite::PlanningState& state, Mode mode)
+          : DerivedDataStreamHandler(state, Order::Ranked), _mode(mode)
+      {
+      }
+      virtual ~AvailabilityDataStreamHandler() = default;
+
+    protected:
+      virtual std::vector<hotel::RoomAvailability> query(const nlohmann::json& options) const override
+      {
+        try
+        {
+          auto search = parse(options);
+          hotel::AvailabilitySearch availabilitySearch(_state.hotels(), _state.planning());
+          if (_mode == Mode::FreeRooms)
+            return availabilitySearch.findFreeRooms(search.hotelId, search.categoryId,
+                                                    boost::gregorian::date_period(search.from, search.to));
+          else
+            return availabilitySearch.findEarliestFreeRooms(search.hotelId, search.categoryId, search.from, search.to,
+                                                            search.nights);
+        }
+        catch (const std::exception& e)
+        {
+          std::cerr << "Cannot run availability search, invalid stream options: " << e.what() << std::endl;
+          return {};
+        }
+      }
+
+      virtual bool isAffected(const nlohmann::json& options, const std::vector<hotel::RoomAvailability>& items,
+                              const sqlite::PlanningChanges& changes) const override
+      {
+        Search search;
+        try
+        {
+          search = parse(options);
+        }
+        catch (const std::exception&)
+        {
+          return false;
+        }
+
+        for (auto hotelId : changes.hotelIds)
+          if (!search.hotelId || *search.hotelId == hotelId)
+            return true;
+        if (changes.roomPeriods.empty())
+          return false;
+
+        // The results depend on the occupancy of all rooms during the searched period (including the stay following
+        // the latest arrival date), the gaps of the results on the occupancy around them
+        auto fromDay = hotel::toDayNumber(search.from);
+        auto toDay = hotel::toDayNumber(search.to) + (_mode == Mode::Earliest ? search.nights : 0);
+        std::unordered_map<int, const hotel::RoomAvailability*> results;
+        for (auto& item : items)
+          results.emplace(item.roomId(), &item);
+        for (auto& period : changes.roomPeriods)
+        {
+          if (!isSearched(search, period.roomId))
+            continue;
+          if (hotel::periodsIntersect(fromDay, toDay, period.fromDay, period.toDay))
+            return true;
+
+          auto resultIt = results.find(period.roomId);
+          if (resultIt != results.end() && intersectsGaps(*resultIt->second, period))
+            return true;
+        }
+        return false;
+      }
+
+    private:
+      struct Search
+      {
+        std::optional<int> hotelId;
+        std::optional<int> categoryId;
+        boost::gregorian::date from;
+        boost::gregorian::date to;
+        int nights = 0;
+      };
+
+      Search parse(const nlohmann::json& options) const
+      {
+        Search search;
+        if (options.count("hotel_id"))
+          search.hotelId = options["hotel_id"].get<int>();
+        if (options.count("category_id"))
+          search.categoryId = options["category_id"].get<int>();
+        search.from = boost::gregorian::from_string(options["from"].get<std::string>());
+        search.to = boost::gregorian::from_string(options["to"].get<std::string>());
+        if (_mode == Mode::Earliest)
+          search.nights = options["nights"];
+        return search;
+      }
+
+      // Returns true if the given room matches the hotel and category of the search
+      bool isSearched(const Search& search, int roomId) const
+      {
+        auto hotel = _state.hotels().findHotelByRoomId(roomId);
+        if (hotel == nullptr || (search.hotelId && hotel->id() != *search.hotelId))
+          return false;
+        if (!search.categoryId)
+          return true;
+        auto room = _state.hotels().findRoomById(roomId);
+        return room->category() && room->category()->id() == *search.categoryId;
+      }
+
+      static bool intersectsGaps(const hotel::RoomAvailability& result, const sqlite::PlanningChanges::RoomPeriod& period)
+      {
+        constexpr auto unbounded = std::numeric_limits<int>::max();
+        // 64 bit, so that the bounds of the gaps cannot overflow
+        int64_t gapBegin = hotel::toDayNumber(result.dateRange().begin());
+        int64_t gapEnd = hotel::toDayNumber(result.dateRange().end());
+        gapBegin = result.gapBefore() == unbounded ? std::numeric_limits<int64_t>::min() : gapBegin - result.gapBefore();
+        gapEnd = result.gapAfter() == unbounded ? std::numeric_limits<int64_t>::max() : gapEnd + result.gapAfter();
+        // A reservation bordering on the gap changes it as well, e.g. when it is shortened
+        return period.fromDay <= gapEnd && period.toDay >= gapBegin;
+      }
+
+      Mode _mode;
+    };
+
+    /**
+     * @brief The FrontDeskDataStreamHandler class implements the front desk services
+     *
+     * The items of the stream are the reservations arriving on, departing on or staying in-house during the night of
+     * the date given by the option "date" (ISO date). The results are read from the front desk index of the planning
+     * state of the backend. A stream is only recomputed when a changed reservation arrives, departs or stays on its
+     * date, before or after the change.
+     *
+     * @see hotel::FrontDeskIndex
+     */
+    class FrontDeskDataStreamHandler : public DerivedDataStreamHandler<hotel::Reservation>
+    {
+    public:
+      enum class Mode { Arrivals, Departures, InHouse };
+
+      FrontDeskDataStreamHandler(const sqlite::PlanningState& state, Mode mode)
+          : DerivedDataStreamHandler(state, Order::Unordered), _mode(mode)
+      {
+      }
+      virtual ~FrontDeskDataStreamHandler() = default;
+
+    protected:
+      virtual std::vector<hotel::Reservation> query(const nlohmann::json& options) const override
+      {
+        hotel::DayNumber day;
+        try
+        {
+          day = parse(options);
+        }
+        catch (const std::exception& e)
+        {
+          std::cerr << "Cannot run front desk query, invalid stream options: " << e.what() << std::endl;
+          return {};
+        }
+
+        auto& frontDesk = _state.frontDesk();
+        std::vector<const hotel::Reservation*> reservations;
+        if (_mode == Mode::Arrivals)
+          reservations = frontDesk.arrivals(day);
+        else if (_mode == Mode::Departures)
+          reservations = frontDesk.departures(day);
+        else
+          reservations = frontDesk.inHouse(day);
+
+        // Report the reservations in a stable order
+        std::sort(reservations.begin(), reservations.end(),
+                  [](const hotel::Reservation* a, const hotel::Reservation* b) { return a->id() < b->id(); });
+        std::vector<hotel::Reservation> result;
+        result.reserve(reservations.size());
+        for (auto reservation : reservations)
+          result.push_back(*reservation);
+        return result;
+      }
+
+      virtual bool isAffected(const nlohmann::json& options, [[maybe_unused]] const std::vector<hotel::Reservation>& items,
+                              const sqlite::PlanningChanges& changes) const override
+      {
+        hotel::DayNumber day;
+        try
+        {
+          day = parse(options);
+        }
+        catch (const std::exception&)
+        {
+          return false;
+        }
+
+        return std::any_of(changes.stays.begin(), changes.stays.end(), [this, day](auto& stay) {
+          if (_mode == Mode::Arrivals)
+            return stay.arrival == day;
+          else if (_mode == Mode::Departures)
+            return stay.departure == day;
+          else
+            return stay.arrival <= day && day < stay.departure;
+        });
+      }
+
+    private:
+      static hotel::DayNumber parse(const nlohmann::json& options)
+      {
+        return hotel::toDayNumber(boost::gregorian::from_string(options["date"].get<std::string>()));
+      }
+
+      Mode _mode;
+    };
+
+    DataStreamManager::DataStreamManager(const sqlite::PlanningState& state)
     {
       _streamHandlers[HandlerKey{StreamableType::NullStream, ""}] = std::make_unique<DefaultDataStreamHandler>();
       _streamHandlers[HandlerKey{StreamableType::Hotel, ""}] = std::make_unique<DefaultDataStreamHandler>();
@@ -145,6 +516,22 @@ namespace persistence
       _streamHandlers[HandlerKey{StreamableType::Reservation, ""}] = std::make_unique<DefaultDataStreamHandler>();
       _streamHandlers[HandlerKey{StreamableType::Reservation, "reservation.by_id"}] =
           std::make_unique<SingleIdDataStreamHandler>();
+      _streamHandlers[HandlerKey{StreamableType::Reservation, "reservation.arrivals"}] =
+          std::make_unique<FrontDeskDataStreamHandler>(state, FrontDeskDataStreamHandler::Mode::Arrivals);
+      _streamHandlers[HandlerKey{StreamableType::Reservation, "reservation.departures"}] =
+          std::make_unique<FrontDeskDataStreamHandler>(state, FrontDeskDataStreamHandler::Mode::Departures);
+      _streamHandlers[HandlerKey{StreamableType::Reservation, "reservation.in_house"}] =
+          std::make_unique<FrontDeskDataStreamHandler>(state, FrontDeskDataStreamHandler::Mode::InHouse);
+      _streamHandlers[HandlerKey{StreamableType::RoomAvailability, "availability.free_rooms"}] =
+          std::make_unique<AvailabilityDataStreamHandler>(state, AvailabilityDataStreamHandler::Mode::FreeRooms);
+      _streamHandlers[HandlerKey{StreamableType::RoomAvailability, "availability.earliest"}] =
+          std::make_unique<AvailabilityDataStreamHandler>(state, AvailabilityDataStreamHandler::Mode::Earliest);
+    }
+
+    void DataStreamManager::setHandler(StreamableType type, const std::string& endpoint,
+                                       std::unique_ptr<DataStreamHandler> handler)
+    {
+      _streamHandlers[HandlerKey{type, endpoint}] = std::move(handler);
     }
 
     void DataStreamManager::addNewStream(const std::shared_ptr<DataStream>& stream)
@@ -159,6 +546,9 @@ namespace persistence
       _uninitializedStreams.erase(std::remove(_uninitializedStreams.begin(), _uninitializedStreams.end(), stream),
                                   _uninitializedStreams.end());
       _activeStreams.erase(std::remove(_activeStreams.begin(), _activeStreams.end(), stream), _activeStreams.end());
+      _loadingStreams.erase(stream->streamId());
+      if (auto handler = findHandler(*stream))
+        handler->streamRemoved(*stream);
     }
 
     void DataStreamManager::initialize(ChangeQueue& changeQueue, sqlite::SqliteStorage& storage)
@@ -173,19 +563,92 @@ namespace persistence
 
       for (auto& uninitializedStream : uninitializedStreams)
       {
-        auto streamPtr = uninitializedStream.get();
-        auto streamHandler = findHandler(*streamPtr);
         std::vector<DataStreamDifferential> changes;
-        if (streamHandler)
-          streamHandler->initialize(*streamPtr, changes, storage);
-        else
-          std::cerr << "Cannot initialize stream, because there is no handler registered" << std::endl;
-        changes.push_back({streamPtr->streamId(), DataStreamInitialized{}});
+        if (!load(*uninitializedStream, changes, storage))
+          continue;
         for (auto& change : changes)
           changeQueue.addStreamChange(change.streamId, std::move(change.change));
       }
     }
 
+    std::shared_ptr<DataStream> DataStreamManager::beginLoading()
+    {
+      std::lock_guard<std::mutex> lock(_streamMutex);
+      if (_uninitializedStreams.empty())
+        return nullptr;
+      auto stream = _uninitializedStreams.front();
+      _uninitializedStreams.erase(_uninitializedStreams.begin());
+      _activeStreams.push_back(stream);
+      _loadingStreams[stream->streamId()];
+      return stream;
+    }
+
+    bool DataStreamManager::loadsFromStorage(const DataStream& stream)
+    {
+      auto streamHandler = findHandler(stream);
+      return streamHandler == nullptr || streamHandler->loadsFromStorage();
+    }
+
+    bool DataStreamManager::load(DataStream& stream, std::vector<DataStreamDifferential>& changes,
+                                 sqlite::SqliteStorage& storage)
+    {
+      auto streamHandler = findHandler(stream);
+      if (streamHandler)
+        streamHandler->initialize(stream, changes, storage);
+      else
+        std::cerr << "Cannot initialize stream, because there is no handler registered" << std::endl;
+      changes.push_back({stream.streamId(), DataStreamInitialized{}});
+
+      // The stream is initialized without holding the lock, thus removeStream() may have notified the handler before
+      // initialize() has created its state for the stream. Notify the handler again, since nobody else will.
+      std::lock_guard<std::mutex> lock(_streamMutex);
+      auto isStream = [&stream](const auto& activeStream) { return activeStream.get() == &stream; };
+      if (std::any_of(_activeStreams.begin(), _activeStreams.end(), isStream))
+        return true;
+      if (streamHandler)
+        streamHandler->streamRemoved(stream);
+      return false;
+    }
+
+    void DataStreamManager::finishLoading(const DataStream& stream, std::vector<DataStreamDifferential> changes,
+                                          ChangeQueue& changeQueue)
+    {
+      std::unique_lock<std::mutex> lock(_streamMutex);
+      auto it = _loadingStreams.find(stream.streamId());
+      // The stream has been removed while it was loading
+      if (it == _loadingStreams.end())
+        return;
+
+      ChangeList list;
+      list.streamChanges = std::move(changes);
+      for (auto& change : it->second)
+        list.streamChanges.push_back({stream.streamId(), std::move(change)});
+      _loadingStreams.erase(it);
+      lock.unlock();
+
+      changeQueue.addChanges(std::move(list));
+    }
+
+    void DataStreamManager::publishChanges(ChangeList changes, ChangeQueue& changeQueue)
+    {
+      std::unique_lock<std::mutex> lock(_streamMutex);
+      if (!_loadingStreams.empty())
+      {
+        auto& streamChanges = changes.streamChanges;
+        auto published = std::remove_if(streamChanges.begin(), streamChanges.end(), [this](auto& change) {
+          auto it = _loadingStreams.find(change.streamId);
+          if (it == _loadingStreams.end())
+            return false;
+          it->second.push_back(std::move(change.change));
+          return true;
+        });
+        streamChanges.erase(published, streamChanges.end());
+      }
+      lock.unlock();
+
+      changeQueue.addChanges(std::move(changes));
+    }
+
     template <class T, class Func> void DataStreamManager::foreachStream(Func func)
     {
       foreachStream(DataStream::GetStreamTypeFor<T>(), func);
@@ -233,6 +696,18 @@ namespace persistence
           type, [&changeQueue](DataStream& stream, DataStreamHandler& handler) { handler.clear(stream, changeQueue); });
     }
 
+    void DataStreamManager::dataChanged(std::vector<DataStreamDifferential>& changeQueue,
+                                        const sqlite::PlanningChanges& changes)
+    {
+      std::unique_lock<std::mutex> lock(_streamMutex);
+      for (auto& activeStream : _activeStreams)
+      {
+        auto handler = findHandler(*activeStream);
+        if (handler != nullptr)
+          handler->dataChanged(*activeStream, changeQueue, changes);
+      }
+    }
+
     DataStreamHandler* DataStreamManager::findHandler(const DataStream& stream)
     {
       auto it = _streamHandlers.find({stream.streamType(), stream.streamEndpoint()});
@@ -243,10 +718,22 @@ namespace persistence
 
   namespace sqlite
   {
-    SqliteBackend::SqliteBackend(const std::string& databasePath)
-        : _storage(databasePath), _nextOperationId(1), _nextStreamId(1), _backendThread(), _quitBackendThread(false),
-          _workAvailableCondition(), _queueMutex(), _operationsQueue()
+    SqliteBackend::SqliteBackend(const std::string& databasePath, const SqliteOptions& options)
+        : _storage(databasePath, options), _nextOperationId(1), _nextStreamId(1), _backendThread(), _quitBackendThread(false),
+          _workAvailableCondition(), _queueMutex(), _operationsQueue(), _dataStreams(_planningState)
     {
+      _planningState.load(_storage);
+      // The read connections rely on WAL snapshots, with a rollback journal a long read would block all commits
+      if (_storage.isWalEnabled())
+      {
+        for (int i = 0; i < options.readConnections; ++i)
+        {
+          auto storage = std::make_unique<SqliteStorage>(databasePath, options, SqliteStorage::Access::ReadOnly);
+          if (!storage->isWalEnabled())
+            break;
+          _readStorages.push_back(std::move(storage));
+        }
+      }
       start();
     }
 
@@ -270,6 +757,8 @@ namespace persistence
     {
       assert(!_backendThread.joinable());
       _backendThread = std::thread([this]() { this->threadMain(); });
+      for (auto& storage : _readStorages)
+        _readerThreads.emplace_back([this, &storage = *storage]() { this->readerMain(storage); });
     }
 
     void SqliteBackend::stopAndJoin()
@@ -279,9 +768,13 @@ namespace persistence
         std::unique_lock<std::mutex> lock(_queueMutex);
         _quitBackendThread = true;
         _workAvailableCondition.notify_all();
+        _streamsAvailableCondition.notify_all();
         lock.unlock();
 
         _backendThread.join();
+        for (auto& thread : _readerThreads)
+          thread.join();
+        _readerThreads.clear();
       }
     }
 
@@ -298,7 +791,10 @@ namespace persistence
       _dataStreams.addNewStream(sharedState);
       lock.unlock();
 
-      _workAvailableCondition.notify_one();
+      if (_readStorages.empty())
+        _workAvailableCondition.notify_one();
+      else
+        _streamsAvailableCondition.notify_one();
 
       return persistence::UniqueDataStreamHandle(this, sharedState);
     }
@@ -313,55 +809,264 @@ namespace persistence
         std::unique_lock<std::mutex> lock(_queueMutex);
         std::vector<QueuedOperation> newTasks;
         std::swap(newTasks, _operationsQueue);
-        const bool hasUninitializedStreams = _dataStreams.hasUninitializedStreams();
-        // Sleep until there is work to do
+        const bool hasUninitializedStreams = _readStorages.empty() && _dataStreams.hasUninitializedStreams();
+        // Sleep until there is work to do, checkpoint the WAL first if there is nothing else to do
         if (!_quitBackendThread && newTasks.empty() && !hasUninitializedStreams)
+        {
+          if (_needsCheckpoint)
+          {
+            lock.unlock();
+            _storage.checkpoint();
+            _needsCheckpoint = false;
+            continue;
+          }
           _workAvailableCondition.wait(lock);
+        }
         lock.unlock();
 
-        // Initialize new data streams
-        _dataStreams.initialize(_changeQueue, _storage);
+        // Initialize new data streams, unless the readers do
+        if (_readStorages.empty())
+          _dataStreams.initialize(_changeQueue, _storage);
 
         // Process tasks
-        for (auto& operationsMessage : newTasks)
+        if (!newTasks.empty())
+          executeGroup(newTasks);
+      }
+    }
+
+    void SqliteBackend::readerMain(SqliteStorage& storage)
+    {
+      while (!_quitBackendThread)
+      {
+        std::unique_lock<std::mutex> lock(_queueMutex);
+        if (!_quitBackendThread && !_dataStreams.hasUninitializedStreams())
+          _streamsAvailableCondition.wait(lock);
+        lock.unlock();
+
+        // Take the snapshot between two groups, so that the stream receives the changes of exactly those groups which
+        // are not part of the snapshot
+        std::unique_lock<std::mutex> commitLock(_commitMutex);
+        auto stream = _dataStreams.beginLoading();
+        if (stream == nullptr)
+          continue;
+        if (!_dataStreams.loadsFromStorage(*stream))
         {
-          _storage.beginTransaction();
-          ChangeList transactionChanges;
-          std::vector<persistence::TaskResult> results;
-          bool rollback = false;
-          for (auto& operation : operationsMessage.first)
-          {
-            auto result =
-                std::visit([this, &transactionChanges](
-                               auto& op) { return this->executeOperation(op, transactionChanges.streamChanges); },
-                           operation);
-            bool succeeded = result.status != TaskResultStatus::Error;
-            results.push_back(std::move(result));
-
-            if (!succeeded)
-            {
-              rollback = true;
-              break;
-            }
-          }
+          // The planning state is only modified while holding the lock, which is cheaper than taking a snapshot
+          std::vector<DataStreamDifferential> changes;
+          _dataStreams.load(*stream, changes, storage);
+          _dataStreams.finishLoading(*stream, std::move(changes), _changeQueue);
+          continue;
+        }
+        storage.beginReadTransaction();
+        commitLock.unlock();
 
-          if (rollback)
-          {
-            _storage.rollbackTransaction();
-          }
-          else
+        std::vector<DataStreamDifferential> changes;
+        _dataStreams.load(*stream, changes, storage);
+        storage.rollbackTransaction();
+
+        commitLock.lock();
+        _dataStreams.finishLoading(*stream, std::move(changes), _changeQueue);
+      }
+    }
+
+    void SqliteBackend::executeGroup(std::vector<QueuedOperation>& tasks)
+    {
+      std::lock_guard<std::mutex> commitLock(_commitMutex);
+      // All messages are executed in one transaction, each of them in a savepoint. Thus a failing message only rolls
+      // back its own changes, while the whole group shares a single commit (and a single sync of the database).
+      _storage.beginTransaction();
+      ChangeList groupChanges;
+      std::vector<std::vector<persistence::TaskResult>> groupResults(tasks.size());
+      std::vector<bool> executed(tasks.size(), false);
+      bool anyExecuted = false;
+      for (size_t i = 0; i < tasks.size(); ++i)
+      {
+        auto& results = groupResults[i];
+        // Reject the whole message if it would create overlapping reservations, without touching the database. The
+        // validation sees the changes of the messages executed before within the group.
+        if (auto error = validateReservations(tasks[i].first))
+        {
+          results.push_back(std::move(*error));
+          continue;
+        }
+
+        _storage.beginSavepoint();
+        _pendingStateChanges.clear();
+        std::vector<DataStreamDifferential> messageChanges;
+        bool rollback = false;
+        for (auto& operation : tasks[i].first)
+        {
+          auto result = std::visit(
+              [this, &messageChanges](auto& op) { return this->executeOperation(op, messageChanges); }, operation);
+          bool succeeded = result.status != TaskResultStatus::Error;
+          results.push_back(std::move(result));
+
+          if (!succeeded)
           {
-            _storage.commitTransaction();
-            _changeQueue.addChanges(std::move(transactionChanges));
+            rollback = true;
+            break;
           }
-          operationsMessage.second.resolve(std::move(results));
+        }
+
+        if (rollback)
+        {
+          _storage.rollbackSavepoint();
+        }
+        else
+        {
+          _storage.releaseSavepoint();
+          for (auto& stateChange : _pendingStateChanges)
+            stateChange(_planningState);
+          std::move(messageChanges.begin(), messageChanges.end(), std::back_inserter(groupChanges.streamChanges));
+          executed[i] = true;
+          anyExecuted = true;
         }
       }
+
+      _pendingStateChanges.clear();
+
+      // The results and changes are only published once they are durable
+      if (_storage.commitTransaction())
+      {
+        // Derived streams only have to be updated once, for the final state of the group
+        if (anyExecuted)
+        {
+          _needsCheckpoint = _storage.options().checkpointPolicy == SqliteOptions::CheckpointPolicy::WhenIdle;
+          _dataStreams.dataChanged(groupChanges.streamChanges, _planningState.takeChanges());
+        }
+        _dataStreams.publishChanges(std::move(groupChanges), _changeQueue);
+      }
+      else
+      {
+        _storage.rollbackTransaction();
+        // The planning state already contains the changes of the group
+        if (anyExecuted)
+          _planningState.load(_storage);
+        for (size_t i = 0; i < tasks.size(); ++i)
+          if (executed[i])
+            groupResults[i] = {TaskResult{TaskResultStatus::Error, {{"message", "Cannot commit transaction"}}}};
+      }
+
+      for (size_t i = 0; i < tasks.size(); ++i)
+        tasks[i].second.resolve(std::move(groupResults[i]));
+    }
+
+    std::optional<TaskResult> SqliteBackend::validateReservations(const op::Operations& operations)
+    {
+      // Collect the reservations written by the operations, together with the index of their operation
+      std::vector<const hotel::Reservation*> candidates;
+      std::vector<size_t> candidateOperations;
+      std::vector<int> replacedIds;
+      bool erasesAllData = false;
+      for (size_t i = 0; i < operations.size(); ++i)
+      {
+        auto& operation = operations[i];
+        const op::StreamableTypePtr* item = nullptr;
+        if (auto storeNew = std::get_if<op::StoreNew>(&operation))
+          item = &storeNew->newItem;
+        else if (auto update = std::get_if<op::Update>(&operation))
+          item = &update->updatedItem;
+        else if (auto remove = std::get_if<op::Delete>(&operation))
+        {
+          if (remove->type == op::StreamableType::Reservation)
+            replacedIds.push_back(remove->id);
+        }
+        else if (std::holds_alternative<op::EraseAllData>(operation))
+          erasesAllData = true;
+
+        auto reservation = item ? std::get_if<std::unique_ptr<hotel::Reservation>>(item) : nullptr;
+        if (reservation && *reservation)
+        {
+          candidates.push_back(reservation->get());
+          candidateOperations.push_back(i);
+          if (std::holds_alternative<op::Update>(operation))
+            replacedIds.push_back((*reservation)->id());
+        }
+      }
+      if (candidates.empty())
+        return std::nullopt;
+
+      // Validate against the planning state, which already reflects the messages executed before within the group.
+      // The reservations replaced or deleted by the operations are ignored. So are the blockers of the overlapping
+      // reservations, since these are checked with all of their days below.
+      static const hotel::PlanningBoard emptyPlanning;
+      auto& planning = erasesAllData ? emptyPlanning : _planningState.planning();
+      std::vector<const hotel::Reservation*> ignored;
+      std::vector<const hotel::Reservation*> overlapping;
+      if (!erasesAllData)
+      {
+        auto isReplaced = [&replacedIds](int id) {
+          return std::find(replacedIds.begin(), replacedIds.end(), id) != replacedIds.end();
+        };
+        ignored = _planningState.blockers();
+        for (auto id : replacedIds)
+          if (auto reservation = planning.getReservationById(id))
+            ignored.push_back(reservation);
+        for (auto reservation : _planningState.overlappingReservations())
+          if (!isReplaced(reservation->id()))
+            overlapping.push_back(reservation);
+      }
+      auto conflicts = hotel::BatchValidator(planning).validate(candidates, ignored);
+
+      // Reservations overlapping each other only exist in databases written before the validation, there are few
+      for (size_t i = 0; i < candidates.size(); ++i)
+      {
+        if (!candidates[i]->isValid())
+          continue;
+        for (auto existing : overlapping)
+          for (auto& atom : candidates[i]->atoms())
+            for (auto& existingAtom : existing->atoms())
+              if (atom.intersectsWith(existingAtom))
+              {
+                hotel::ReservationConflict conflict{hotel::ReservationConflict::Kind::ConflictWithBoard, i};
+                conflict.existing = existing;
+                conflict.roomId = atom.roomId();
+                conflict.period = atom.dateRange().intersection(existingAtom.dateRange());
+                conflicts.push_back(conflict);
+              }
+      }
+      std::stable_sort(conflicts.begin(), conflicts.end(),
+                       [](auto& a, auto& b) { return a.candidate < b.candidate; });
+      if (conflicts.empty())
+        return std::nullopt;
+
+      nlohmann::json conflictList = nlohmann::json::array();
+      for (auto& conflict : conflicts)
+      {
+        nlohmann::json obj;
+        obj["operation"] = candidateOperations[conflict.candidate];
+        switch (conflict.kind)
+        {
+        case hotel::ReservationConflict::Kind::InvalidReservation:
+          obj["kind"] = "invalid";
+          break;
+        case hotel::ReservationConflict::Kind::ConflictInBatch:
+          obj["kind"] = "conflict_in_batch";
+          obj["other_operation"] = candidateOperations[*conflict.otherCandidate];
+          break;
+        case hotel::ReservationConflict::Kind::ConflictWithBoard:
+          obj["kind"] = "conflict_with_existing";
+          obj["reservation_id"] = conflict.existing->id();
+          break;
+        }
+        if (conflict.kind != hotel::ReservationConflict::Kind::InvalidReservation)
+        {
+          obj["room_id"] = conflict.roomId;
+          obj["from"] = boost::gregorian::to_iso_extended_string(conflict.period.begin());
+          obj["to"] = boost::gregorian::to_iso_extended_string(conflict.period.end());
+        }
+        conflictList.push_back(std::move(obj));
+      }
+
+      return TaskResult{TaskResultStatus::Error,
+                        {{"message", "Cannot store reservations, " + std::to_string(conflicts.size()) + " conflicts"},
+                         {"conflicts", std::move(conflictList)}}};
     }
 
     TaskResult SqliteBackend::executeOperation(op::EraseAllData&, std::vector<DataStreamDifferential>& streamChanges)
     {
       _storage.deleteAll();
+      _pendingStateChanges.push_back([](PlanningState& state) { state.clear(); });
 
       _dataStreams.clear(streamChanges, StreamableType::Reservation);
       _dataStreams.clear(streamChanges, StreamableType::Hotel);
@@ -384,6 +1089,7 @@ namespace persistence
     TaskResult SqliteBackend::executeStoreNew(hotel::Hotel& hotel, std::vector<DataStreamDifferential>& streamChanges)
     {
       _storage.storeNewHotel(hotel);
+      _pendingStateChanges.push_back([hotel](PlanningState& state) { state.storeHotel(hotel); });
       _dataStreams.addItems(streamChanges, StreamableType::Hotel, std::vector<hotel::Hotel>{{hotel}});
       return TaskResult{TaskResultStatus::Successful, {{"id", hotel.id()}}};
     }
@@ -392,6 +1098,7 @@ namespace persistence
                                               std::vector<DataStreamDifferential>& streamChanges)
     {
       _storage.storeNewReservationAndAtoms(reservation);
+      _pendingStateChanges.push_back([reservation](PlanningState& state) { state.storeReservation(reservation); });
       _dataStreams.addItems(streamChanges, StreamableType::Reservation, std::vector<hotel::Reservation>{{reservation}});
       return TaskResult{TaskResultStatus::Successful, {{"id", reservation.id()}}};
     }
@@ -432,12 +1139,14 @@ namespace persistence
 
     void SqliteBackend::executeUpdate(const hotel::Hotel& hotel, std::vector<DataStreamDifferential>& streamChanges)
     {
+      _pendingStateChanges.push_back([hotel](PlanningState& state) { state.storeHotel(hotel); });
       _dataStreams.updateItems(streamChanges, StreamableType::Hotel, std::vector<hotel::Hotel>{{hotel}});
     }
 
     void SqliteBackend::executeUpdate(const hotel::Reservation& reservation,
                                       std::vector<DataStreamDifferential>& streamChanges)
     {
+      _pendingStateChanges.push_back([reservation](PlanningState& state) { state.storeReservation(reservation); });
       _dataStreams.updateItems(streamChanges, StreamableType::Reservation,
                                std::vector<hotel::Reservation>{{reservation}});
     }
@@ -456,6 +1165,7 @@ namespace persistence
       if (op.type == persistence::op::StreamableType::Reservation)
       {
         _storage.deleteReservationById(op.id);
+        _pendingStateChanges.push_back([id = op.id](PlanningState& state) { state.removeReservation(id); });
         _dataStreams.removeItems(streamChanges, StreamableType::Reservation, {op.id});
       }
       else
@@ -1,6 +1,7 @@
 #ifndef PERSISTENCE_SQLITE_SQLITEBACKEND_H
 #define PERSISTENCE_SQLITE_SQLITEBACKEND_H
 
+#include "persistence/sqlite/planningstate.h"
 #include "persistence/sqlite/sqlitestorage.h"
 
 #include "persistence/backend.h"
@@ -23,6 +24,7 @@
 #include <string>
 #include <queue>
 #include <functional>
+#include <optional>
 
 namespace persistence
 {
@@ -38,14 +40,41 @@ namespace persistence
       virtual void updateItems(DataStream& stream, std::vector<DataStreamDifferential>& changeQueue, const StreamableItems& items) = 0;
       virtual void removeItems(DataStream& stream, std::vector<DataStreamDifferential>& ChangeQueue, const std::vector<int> ids) = 0;
       virtual void clear(DataStream& stream, std::vector<DataStreamDifferential>& changeQueue) = 0;
+      /**
+       * @brief dataChanged is called for every stream once per committed transaction
+       *
+       * Streams whose items are derived from other data (e.g. availability searches) can use this to update their
+       * items. The planning state of the backend already reflects the given changes of the transaction.
+       */
+      virtual void dataChanged([[maybe_unused]] DataStream& stream,
+                               [[maybe_unused]] std::vector<DataStreamDifferential>& changeQueue,
+                               [[maybe_unused]] const sqlite::PlanningChanges& changes)
+      {
+      }
+      //! @brief streamRemoved is called when the given stream has been removed, to release any state kept for it
+      virtual void streamRemoved([[maybe_unused]] const DataStream& stream) {}
+      /**
+       * @brief loadsFromStorage returns false if initialize() does not read from the storage
+       *
+       * Such streams are initialized from the planning state of the backend, thus the reader threads initialize them
+       * while holding the commit mutex, without taking a snapshot of the database.
+       */
+      virtual bool loadsFromStorage() const { return true; }
     };
 
     class DataStreamManager
     {
     public:
-      DataStreamManager();
+      //! The handlers of the derived streams read from the given state, which is modified by the backend
+      explicit DataStreamManager(const sqlite::PlanningState& state);
       virtual ~DataStreamManager() = default;
 
+      /**
+       * @brief setHandler registers the handler of the streams with the given type and endpoint
+       * @note setHandler must be called before any stream is added!
+       */
+      void setHandler(StreamableType type, const std::string& endpoint, std::unique_ptr<DataStreamHandler> handler);
+
       /**
        * @note addNewStream must be synchronized!
        * @see collectNewStreams
@@ -61,6 +90,36 @@ namespace persistence
        */
       void initialize(ChangeQueue& changeQueue, sqlite::SqliteStorage& storage);
 
+      /**
+       * @brief beginLoading takes one of the new streams for initialization on another thread
+       *
+       * The stream becomes active right away, thus it receives the changes of all transactions committed from now on.
+       * These changes are held back by publishChanges() until finishLoading() has published the initial items. The
+       * caller has to take the snapshot it loads the stream from before any further transaction is committed.
+       *
+       * @return the stream, or nullptr if there are no new streams
+       */
+      std::shared_ptr<DataStream> beginLoading();
+      //! @brief loadsFromStorage returns true if the given stream is initialized from the storage
+      bool loadsFromStorage(const DataStream& stream);
+      /**
+       * @brief load creates the initial items of the given stream
+       *
+       * The stream may be removed while it is initialized, in which case the handler releases the state it has just
+       * created for the stream and the items are to be discarded.
+       *
+       * @return false if the stream has been removed in the meantime
+       */
+      bool load(DataStream& stream, std::vector<DataStreamDifferential>& changes, sqlite::SqliteStorage& storage);
+      //! @brief finishLoading publishes the initial items of a stream followed by the changes held back in the meantime
+      void finishLoading(const DataStream& stream, std::vector<DataStreamDifferential> changes,
+                         ChangeQueue& changeQueue);
+      /**
+       * @brief publishChanges adds the given changes to the change queue, except for those of streams still loading
+       * @note The calls of publishChanges() and finishLoading() have to be serialized by the caller
+       */
+      void publishChanges(ChangeList changes, ChangeQueue& changeQueue);
+
       /**
        * @brief Calls func for each data stream in the active queue
        */
@@ -80,6 +139,8 @@ namespace persistence
       virtual void updateItems(std::vector<DataStreamDifferential>& changeQueue, StreamableType type, const StreamableItems items);
       virtual void removeItems(std::vector<DataStreamDifferential>& changeQueue, StreamableType type, std::vector<int> ids);
       virtual void clear(std::vector<DataStreamDifferential>& changeQueue, StreamableType type);
+      //! @see DataStreamHandler::dataChanged
+      virtual void dataChanged(std::vector<DataStreamDifferential>& changeQueue, const sqlite::PlanningChanges& changes);
 
     private:
       DataStreamHandler* findHandler(const DataStream& stream);
@@ -90,6 +151,8 @@ namespace persistence
       mutable std::mutex _streamMutex;
       std::vector<std::shared_ptr<DataStream>> _uninitializedStreams;
       std::vector<std::shared_ptr<DataStream>> _activeStreams;
+      //! The changes held back for streams which are loaded by beginLoading() and finishLoading(), by stream id
+      std::map<int, std::vector<DataStreamChange>> _loadingStreams;
     };
   }
 
@@ -99,11 +162,21 @@ namespace persistence
      * @brief The SqliteBackend class is the sqlite data backend for the application
      *
      * This particular backend will create its own worker thread, on which all data operations will be executed.
+     *
+     * In WAL mode, new streams are initialized on a pool of read-only connections with threads of their own (see
+     * SqliteOptions::readConnections). Each of them loads a stream from a snapshot of the database, thus loading a
+     * large stream does not delay the operations of other clients. A snapshot is always taken between two groups of
+     * operations; the changes of groups committed after the snapshot are delivered after the initial items.
+     *
+     * All hotels and reservations are also kept in memory (see PlanningState), which is updated with every committed
+     * message. The derived streams (availability and front desk services) are computed from it.
+     *
+     * @see SqliteOptions for the durability and performance settings of the database
      */
     class SqliteBackend final : public Backend
     {
     public:
-      SqliteBackend(const std::string& databasePath);
+      SqliteBackend(const std::string& databasePath, const SqliteOptions& options = SqliteOptions());
       virtual ~SqliteBackend();
 
       virtual fas::Future<std::vector<TaskResult>> queueOperations(op::Operations operations) override;
@@ -121,6 +194,23 @@ namespace persistence
       void start();
       void stopAndJoin();
       void threadMain();
+      void readerMain(SqliteStorage& storage);
+
+      typedef std::pair<op::Operations, fas::Promise<std::vector<TaskResult>>> QueuedOperation;
+      /**
+       * @brief executeGroup executes the given messages with group commit
+       *
+       * Every message runs in a savepoint of one transaction, which is committed once for the whole group. The promises
+       * are resolved and the stream changes are published only after the commit.
+       */
+      void executeGroup(std::vector<QueuedOperation>& tasks);
+
+      /**
+       * @brief validateReservations checks the reservations stored or updated by the given operations against each
+       *        other and against the reservations in the planning state, before anything is written
+       * @return An error result listing all conflicts, or nothing if the operations can be executed
+       */
+      std::optional<TaskResult> validateReservations(const op::Operations& operations);
 
       TaskResult executeOperation(op::EraseAllData&, std::vector<DataStreamDifferential>& streamChanges);
       TaskResult executeOperation(op::StoreNew& op, std::vector<DataStreamDifferential>& streamChanges);
@@ -143,12 +233,24 @@ namespace persistence
 
       std::thread _backendThread;
       std::atomic<bool> _quitBackendThread;
+      // True if transactions have been committed since the last checkpoint (CheckpointPolicy::WhenIdle only)
+      bool _needsCheckpoint = false;
       std::condition_variable _workAvailableCondition;
+      // Held by the worker thread while executing and committing a group, and by the readers while taking a snapshot
+      std::mutex _commitMutex;
+
+      std::vector<std::unique_ptr<SqliteStorage>> _readStorages;
+      std::vector<std::thread> _readerThreads;
+      std::condition_variable _streamsAvailableCondition;
 
       std::mutex _queueMutex;
-      typedef std::pair<op::Operations, fas::Promise<std::vector<TaskResult>>> QueuedOperation;
       std::vector<QueuedOperation> _operationsQueue;
 
+      // All hotels and reservations, kept in sync with the committed state of the database (see executeGroup)
+      PlanningState _planningState;
+      // The modifications of the planning state by the message being executed, applied once its savepoint is released
+      std::vector<std::function<void(PlanningState&)>> _pendingStateChanges;
+
       detail::DataStreamManager _dataStreams;
     };
 
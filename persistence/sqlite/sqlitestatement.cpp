@@ -1,5 +1,7 @@
 #include "persistence/sqlite/sqlitestatement.h"
 
+#include "hotel/daynumber.h"
+
 namespace persistence
 {
   namespace sqlite
@@ -57,16 +59,16 @@ namespace persistence
       sqlite3_bind_text(_statement, pos, text, -1, SQLITE_TRANSIENT);
     }
 
-    void SqliteStatement::bindArgument(int pos, const std::string& text)
+    void SqliteStatement::bindArgument(int pos, std::string_view text)
     {
-      sqlite3_bind_text(_statement, pos, text.c_str(), static_cast<int>(text.size()), SQLITE_TRANSIENT);
+      sqlite3_bind_text(_statement, pos, text.data(), static_cast<int>(text.size()), SQLITE_TRANSIENT);
     }
 
     void SqliteStatement::bindArgument(int pos, int64_t value) { sqlite3_bind_int64(_statement, pos, value); }
 
     void SqliteStatement::bindArgument(int pos, boost::gregorian::date date)
     {
-      bindArgument(pos, boost::gregorian::to_iso_string(date));
+      bindArgument(pos, static_cast<int64_t>(hotel::toDayNumber(date)));
     }
 
     void SqliteStatement::readArg(int pos, std::string& val)
@@ -80,9 +82,7 @@ namespace persistence
 
     void SqliteStatement::readArg(int pos, boost::gregorian::date& date)
     {
-      std::string val;
-      readArg(pos, val);
-      date = boost::gregorian::from_undelimited_string(val);
+      date = hotel::fromDayNumber(sqlite3_column_int(_statement, pos));
     }
 
   } // namespace sqlite
@@ -5,6 +5,7 @@
 #include <sqlite3.h>
 
 #include <string>
+#include <string_view>
 
 namespace persistence
 {
@@ -14,7 +15,8 @@ namespace persistence
     /**
      * @brief The SqliteStatement class holds a prepared SQL statement
      *
-     * The class furthermore provides facilities for the execution of the query and the binding of values.
+     * The class furthermore provides facilities for the execution of the query and the binding of values. Dates are
+     * bound and read as integer day numbers (see hotel::DayNumber).
      */
     class SqliteStatement
     {
@@ -30,7 +32,7 @@ namespace persistence
        * @brief Executes the SQL statements with the given parameters
        * The parameters are sequentially bound to the prepared statement.
        */
-      template <typename... Args> bool execute(Args... args)
+      template <typename... Args> bool execute(const Args&... args)
       {
         if (!prepareForQuery())
           return false;
@@ -63,7 +65,7 @@ namespace persistence
       bool prepareForQuery();
 
       void bindArgument(int pos, const char* text);
-      void bindArgument(int pos, const std::string& text);
+      void bindArgument(int pos, std::string_view text);
       void bindArgument(int pos, int64_t value);
       void bindArgument(int pos, boost::gregorian::date date);
 
@@ -79,7 +81,7 @@ namespace persistence
       }
 
       template <int Pos> void bindArguments() {}
-      template <int Pos = 1, typename T, typename... Args> void bindArguments(T val, Args... others)
+      template <int Pos = 1, typename T, typename... Args> void bindArguments(const T& val, const Args&... others)
       {
         bindArgument(Pos, val);
         bindArguments<Pos + 1, Args...>(others...);
@@ -89,6 +91,33 @@ namespace persistence
       sqlite3_stmt* _statement;
     };
 
+    template <typename... Types> struct TypeList
+    {
+    };
+
+    /**
+     * @brief The TypedStatement class gives access to a SqliteStatement with fixed types of parameters and columns
+     *
+     * Passing the wrong number of parameters or reading a row into the wrong types fails at compile time.
+     *
+     * @see SqliteStatement
+     */
+    template <typename Parameters, typename Columns> class TypedStatement;
+
+    template <typename... Parameters, typename... Columns>
+    class TypedStatement<TypeList<Parameters...>, TypeList<Columns...>>
+    {
+    public:
+      explicit TypedStatement(SqliteStatement& statement) : _statement(statement) {}
+
+      bool execute(const Parameters&... parameters) { return _statement.execute(parameters...); }
+      bool hasResultRow() { return _statement.hasResultRow(); }
+      void readRow(Columns&... columns) { _statement.readRow(columns...); }
+
+    private:
+      SqliteStatement& _statement;
+    };
+
   } // namespace sqlite
 } // namespace persistence
 
@@ -3,6 +3,8 @@
 #include "hotel/person.h"
 
 #include <iostream>
+#include <stdexcept>
+#include <type_traits>
 
 namespace persistence
 {
@@ -17,6 +19,32 @@ namespace persistence
           std::cerr << "Cannot execute query: " << sql;
       }
 
+      int queryInt(sqlite3* db, const std::string& sql)
+      {
+        SqliteStatement statement(db, sql);
+        int result = 0;
+        if (statement.execute() && statement.hasResultRow())
+          statement.readRow(result);
+        return result;
+      }
+
+      // Dates are stored as day numbers (see hotel::DayNumber), which are julian day numbers, as known by sqlite
+      std::string dayNumberFromIsoString(const std::string& column)
+      {
+        return "CAST(julianday(substr(" + column + ", 1, 4) || '-' || substr(" + column + ", 5, 2) || '-' || substr(" +
+               column + ", 7, 2)) + 0.5 AS INTEGER)";
+      }
+
+      void createIndexes(sqlite3* db)
+      {
+        // The atoms are read by reservation and ordered by date, availability checks look up rooms by date
+        executeSQL(db, "CREATE INDEX IF NOT EXISTS h_reservation_atom_reservation_id "
+                       "ON h_reservation_atom (reservation_id, date_from);");
+        executeSQL(db, "CREATE INDEX IF NOT EXISTS h_reservation_atom_room_id_date_from "
+                       "ON h_reservation_atom (room_id, date_from);");
+        executeSQL(db, "CREATE INDEX IF NOT EXISTS h_room_hotel_id ON h_room (hotel_id);");
+      }
+
       std::string serializeReservationStatus(hotel::Reservation::ReservationStatus status)
       {
         using Status = hotel::Reservation::ReservationStatus;
@@ -62,11 +90,149 @@ namespace persistence
         std::cerr << "Unknown reservation status: " << str;
         return Status::Unknown;
       }
+
+      /**
+       * The statements used by SqliteStorage, each of them is a type with its SQL and the types of its parameters and
+       * result columns. The statements are prepared in the order of AllStatements, which also yields their index.
+       */
+      namespace statements
+      {
+        using boost::gregorian::date;
+        using std::string;
+        using std::string_view;
+
+        template <typename ParameterList, typename ColumnList> struct Statement
+        {
+          using Parameters = ParameterList;
+          using Columns = ColumnList;
+        };
+
+        struct HotelInsert : Statement<TypeList<string>, TypeList<>>
+        {
+          static constexpr const char* sql = "INSERT INTO h_hotel (name) VALUES (?);";
+        };
+        struct HotelUpdate : Statement<TypeList<string, int, int>, TypeList<>>
+        {
+          static constexpr const char* sql =
+              "UPDATE h_hotel SET name=?, revision=revision+1 WHERE id=? and revision=?;";
+        };
+        struct HotelAll : Statement<TypeList<>, TypeList<int, int, string>>
+        {
+          static constexpr const char* sql = "SELECT id, revision, name FROM h_hotel;";
+        };
+        struct HotelById : Statement<TypeList<int>, TypeList<int, int, string>>
+        {
+          static constexpr const char* sql = "SELECT id, revision, name FROM h_hotel WHERE id = ?;";
+        };
+        struct RoomCategoryInsert : Statement<TypeList<int, string, string>, TypeList<>>
+        {
+          static constexpr const char* sql =
+              "INSERT INTO h_room_category (hotel_id, short_code, name) VALUES (?, ?, ?);";
+        };
+        struct RoomCategoryByHotelId : Statement<TypeList<int>, TypeList<int, string, string>>
+        {
+          static constexpr const char* sql = "SELECT id, short_code, name FROM h_room_category WHERE hotel_id = ?;";
+        };
+        struct RoomInsert : Statement<TypeList<int, int, string>, TypeList<>>
+        {
+          static constexpr const char* sql = "INSERT INTO h_room (hotel_id, category_id, name) VALUES (?, ?, ?);";
+        };
+        struct RoomByHotelId : Statement<TypeList<int>, TypeList<int, int, string>>
+        {
+          static constexpr const char* sql = "SELECT id, category_id, name FROM h_room WHERE hotel_id = ?;";
+        };
+        struct ReservationAndAtomsAll
+            : Statement<TypeList<>, TypeList<int, int, string, string, int, int, int, int, date, date>>
+        {
+          static constexpr const char* sql =
+              "SELECT r.id, r.revision, r.description, r.status, r.adults, r.children, a.id, a.room_id, a.date_from, "
+              "a.date_to FROM h_reservation as r, h_reservation_atom as a WHERE "
+              "a.reservation_id = r.id ORDER BY r.id, a.date_from;";
+        };
+        struct ReservationAndAtomsByReservationId
+            : Statement<TypeList<int>, TypeList<int, string, string, int, int, int, int, date, date>>
+        {
+          static constexpr const char* sql =
+              "SELECT r.revision, r.description, r.status, r.adults, r.children, a.id, a.room_id, a.date_from, "
+              "a.date_to FROM h_reservation as r, h_reservation_atom as a WHERE "
+              "a.reservation_id = r.id and r.id = ? ORDER BY r.id, a.date_from;";
+        };
+        struct ReservationInsert : Statement<TypeList<string_view, string, int, int>, TypeList<>>
+        {
+          static constexpr const char* sql =
+              "INSERT INTO h_reservation (description, status, adults, children) VALUES (?, ?, ?, ?);";
+        };
+        struct ReservationUpdate : Statement<TypeList<string_view, string, int, int, int, int>, TypeList<>>
+        {
+          static constexpr const char* sql = "UPDATE h_reservation SET description=?, status=?, adults=?, children=?, "
+                                             "revision=revision+1 WHERE id = ? AND revision = ?;";
+        };
+        // A prepared statement can only hold a single SQL statement, thus the atoms are deleted separately
+        struct ReservationDelete : Statement<TypeList<int>, TypeList<>>
+        {
+          static constexpr const char* sql = "DELETE FROM h_reservation WHERE id = ?;";
+        };
+        struct ReservationAtomInsert : Statement<TypeList<int, int, date, date>, TypeList<>>
+        {
+          static constexpr const char* sql =
+              "INSERT INTO h_reservation_atom (reservation_id, room_id, date_from, date_to) VALUES (?, ?, ?, ?);";
+        };
+        struct ReservationAtomDeleteByReservationId : Statement<TypeList<int>, TypeList<>>
+        {
+          static constexpr const char* sql = "DELETE FROM h_reservation_atom WHERE reservation_id = ?;";
+        };
+
+        using AllStatements =
+            TypeList<HotelInsert, HotelUpdate, HotelAll, HotelById, RoomCategoryInsert, RoomCategoryByHotelId,
+                     RoomInsert, RoomByHotelId, ReservationAndAtomsAll, ReservationAndAtomsByReservationId,
+                     ReservationInsert, ReservationUpdate, ReservationDelete, ReservationAtomInsert,
+                     ReservationAtomDeleteByReservationId>;
+
+        template <typename... Statements> constexpr size_t size(TypeList<Statements...>)
+        {
+          return sizeof...(Statements);
+        }
+
+        template <typename Statement, typename... Statements> constexpr size_t indexOf(TypeList<Statements...>)
+        {
+          size_t index = 0;
+          bool found = false;
+          ((found = found || std::is_same_v<Statement, Statements>, index += found ? 0 : 1), ...);
+          return index;
+        }
+
+        template <typename... Statements>
+        void prepare(sqlite3* db, std::vector<SqliteStatement>& result, TypeList<Statements...>)
+        {
+          result.reserve(sizeof...(Statements));
+          (result.emplace_back(db, Statements::sql), ...);
+        }
+      } // namespace statements
+    }
+
+    SqliteOptions SqliteOptions::legacy()
+    {
+      SqliteOptions options;
+      options.journalMode = JournalMode::Delete;
+      options.synchronous = Synchronous::Full;
+      options.mmapSize = 0;
+      options.cacheSizeKiB = 2000;
+      return options;
+    }
+
+    template <typename Statement> auto SqliteStorage::query()
+    {
+      constexpr auto index = statements::indexOf<Statement>(statements::AllStatements{});
+      static_assert(index < statements::size(statements::AllStatements{}),
+                    "The statement is not part of AllStatements");
+      return TypedStatement<typename Statement::Parameters, typename Statement::Columns>(_statements[index]);
     }
 
-    SqliteStorage::SqliteStorage(const std::string& file) : _db(nullptr)
+    SqliteStorage::SqliteStorage(const std::string& file, const SqliteOptions& options, Access access)
+        : _options(options), _db(nullptr)
     {
-      if (sqlite3_open(file.c_str(), &_db))
+      auto flags = access == Access::ReadOnly ? SQLITE_OPEN_READONLY : SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
+      if (sqlite3_open_v2(file.c_str(), &_db, flags, nullptr))
       {
         std::cerr << "Cannot open sqlite database: " << file << std::endl;
         sqlite3_close(_db);
@@ -75,12 +241,41 @@ namespace persistence
 
       if (_db != nullptr)
       {
-        createSchema();
+        if (access == Access::ReadWrite)
+        {
+          configure();
+          try
+          {
+            createSchema();
+          }
+          catch (...)
+          {
+            // The destructor is not run for a partially constructed object
+            sqlite3_close(_db);
+            throw;
+          }
+        }
+        else
+        {
+          // The journal mode is a property of the database file, which has been set by the writer
+          SqliteStatement journalModeQuery(_db, "PRAGMA journal_mode;");
+          std::string journalMode;
+          if (journalModeQuery.execute() && journalModeQuery.hasResultRow())
+            journalModeQuery.readRow(journalMode);
+          _walEnabled = journalMode == "wal";
+          executeSQL(_db, "PRAGMA mmap_size=" + std::to_string(_options.mmapSize) + ";");
+          executeSQL(_db, "PRAGMA cache_size=-" + std::to_string(_options.cacheSizeKiB) + ";");
+        }
         prepareQueries();
       }
     }
 
-    SqliteStorage::~SqliteStorage() { sqlite3_close(_db); }
+    SqliteStorage::~SqliteStorage()
+    {
+      // The connection can only be closed once all of its statements have been finalized
+      _statements.clear();
+      sqlite3_close(_db);
+    }
 
     void SqliteStorage::deleteAll()
     {
@@ -100,7 +295,8 @@ namespace persistence
 
     void SqliteStorage::deleteReservationById(int id)
     {
-      query("reservation.delete").execute(id, id);
+      query<statements::ReservationAtomDeleteByReservationId>().execute(id);
+      query<statements::ReservationDelete>().execute(id);
     }
 
 
@@ -110,7 +306,7 @@ namespace persistence
       std::vector<hotel::Hotel> results;
 
       // Read hotels
-      auto& hotelsQuery = query("hotel.all");
+      auto hotelsQuery = query<statements::HotelAll>();
       hotelsQuery.execute();
       while (hotelsQuery.hasResultRow())
       {
@@ -126,7 +322,7 @@ namespace persistence
       for (auto& hotel : results)
       {
         // Read categories
-        auto& categoriesQuery = query("room_category.by_hotel_id");
+        auto categoriesQuery = query<statements::RoomCategoryByHotelId>();
         categoriesQuery.execute(hotel.id());
         while (categoriesQuery.hasResultRow())
         {
@@ -140,7 +336,7 @@ namespace persistence
         }
 
         // Read rooms
-        auto& roomsQuery = query("room.by_hotel_id");
+        auto roomsQuery = query<statements::RoomByHotelId>();
         roomsQuery.execute(hotel.id());
         while (roomsQuery.hasResultRow())
         {
@@ -167,7 +363,7 @@ namespace persistence
     {
       std::vector<hotel::Reservation> result;
 
-      auto& reservationsQuery = query("reservation_and_atoms.all");
+      auto reservationsQuery = query<statements::ReservationAndAtomsAll>();
       reservationsQuery.execute();
       std::unique_ptr<hotel::Reservation> current = nullptr;
       while (reservationsQuery.hasResultRow())
@@ -221,7 +417,7 @@ namespace persistence
       std::optional<hotel::Hotel> result;
 
       // Read hotels
-      auto& hotelQuery = query("hotel.by_id");
+      auto hotelQuery = query<statements::HotelById>();
       hotelQuery.execute(id);
       if (hotelQuery.hasResultRow())
       {
@@ -238,7 +434,7 @@ namespace persistence
       if (result)
       {
         // Read categories
-        auto& categoriesQuery = query("room_category.by_hotel_id");
+        auto categoriesQuery = query<statements::RoomCategoryByHotelId>();
         categoriesQuery.execute(result->id());
         while (categoriesQuery.hasResultRow())
         {
@@ -252,7 +448,7 @@ namespace persistence
         }
 
         // Read rooms
-        auto& roomsQuery = query("room.by_hotel_id");
+        auto roomsQuery = query<statements::RoomByHotelId>();
         roomsQuery.execute(result->id());
         while (roomsQuery.hasResultRow())
         {
@@ -279,7 +475,7 @@ namespace persistence
     {
       std::optional<hotel::Reservation> result;
 
-      auto& reservationsQuery = query("reservation_and_atoms.by_reservation_id");
+      auto reservationsQuery = query<statements::ReservationAndAtomsByReservationId>();
       reservationsQuery.execute(id);
       while (reservationsQuery.hasResultRow())
       {
@@ -317,21 +513,21 @@ namespace persistence
     void SqliteStorage::storeNewHotel(hotel::Hotel& hotel)
     {
       // First, store the hotel
-      query("hotel.insert").execute(hotel.name());
+      query<statements::HotelInsert>().execute(hotel.name());
       hotel.setId(static_cast<int>(lastInsertId()));
       hotel.setRevision(1);
 
       // Store all of the categories
       for (auto& category : hotel.categories())
       {
-        query("room_category.insert").execute(hotel.id(), category->shortCode(), category->name());
+        query<statements::RoomCategoryInsert>().execute(hotel.id(), category->shortCode(), category->name());
         category->setId(static_cast<int>(lastInsertId()));
       }
 
       // Store all of the rooms
       for (auto& room : hotel.rooms())
       {
-        query("room.insert").execute(hotel.id(), room->category()->id(), room->name());
+        query<statements::RoomInsert>().execute(hotel.id(), room->category()->id(), room->name());
         room->setId(static_cast<int>(lastInsertId()));
       }
     }
@@ -339,13 +535,13 @@ namespace persistence
     void SqliteStorage::storeNewReservationAndAtoms(hotel::Reservation& reservation)
     {
       auto reservationStatus = serializeReservationStatus(reservation.status());
-      query("reservation.insert").execute(reservation.description(), reservationStatus,
+      query<statements::ReservationInsert>().execute(reservation.description(), reservationStatus,
                                           reservation.numberOfAdults(), reservation.numberOfChildren());
       reservation.setId(static_cast<int>(lastInsertId()));
       reservation.setRevision(1);
       for (auto& atom : reservation.atoms())
       {
-        auto& q = query("reservation_atom.insert");
+        auto q = query<statements::ReservationAtomInsert>();
         q.execute(reservation.id(), atom.roomId(), atom.dateRange().begin(), atom.dateRange().end());
         atom.setId(static_cast<int>(lastInsertId()));
       }
@@ -354,7 +550,7 @@ namespace persistence
     template <>
     bool SqliteStorage::update<hotel::Hotel>(hotel::Hotel& value)
     {
-      auto& q = query("hotel.update");
+      auto q = query<statements::HotelUpdate>();
       q.execute(value.name(), value.id(), value.revision());
 
       int updatedRows = sqlite3_changes(_db);
@@ -369,7 +565,7 @@ namespace persistence
     template <>
     bool SqliteStorage::update<hotel::Reservation>(hotel::Reservation& value)
     {
-      auto& q = query("reservation.update");
+      auto q = query<statements::ReservationUpdate>();
       q.execute(value.description(), serializeReservationStatus(value.status()), value.numberOfAdults(),
                 value.numberOfChildren(), value.id(), value.revision());
 
@@ -391,62 +587,98 @@ namespace persistence
       return false;
     }
 
-    SqliteStatement& SqliteStorage::query(const std::string& key)
+    int64_t SqliteStorage::lastInsertId() { return sqlite3_last_insert_rowid(_db); }
+
+    void SqliteStorage::beginTransaction() { sqlite3_exec(_db, "BEGIN TRANSACTION", nullptr, nullptr, nullptr); }
+    bool SqliteStorage::commitTransaction()
     {
-      auto it = _statements.find(key);
-      if (it == _statements.end())
-      {
-        std::cerr << "Query '" << key << "' does not exist!" << std::endl;
-      }
+      if (sqlite3_exec(_db, "COMMIT TRANSACTION", nullptr, nullptr, nullptr) == SQLITE_OK)
+        return true;
+
+      std::cerr << "Cannot commit transaction: " << sqlite3_errmsg(_db) << std::endl;
+      return false;
+    }
+    void SqliteStorage::rollbackTransaction() { sqlite3_exec(_db, "ROLLBACK TRANSACTION", nullptr, nullptr, nullptr); }
 
-      return it->second;
+    void SqliteStorage::beginReadTransaction()
+    {
+      sqlite3_exec(_db, "BEGIN TRANSACTION", nullptr, nullptr, nullptr);
+      // A deferred transaction takes its snapshot with the first read
+      executeSQL(_db, "SELECT count(*) FROM sqlite_master;");
     }
 
-    int64_t SqliteStorage::lastInsertId() { return sqlite3_last_insert_rowid(_db); }
+    void SqliteStorage::beginSavepoint() { sqlite3_exec(_db, "SAVEPOINT operations", nullptr, nullptr, nullptr); }
+    void SqliteStorage::releaseSavepoint()
+    {
+      sqlite3_exec(_db, "RELEASE SAVEPOINT operations", nullptr, nullptr, nullptr);
+    }
+    void SqliteStorage::rollbackSavepoint()
+    {
+      // Rolling back to a savepoint keeps it open, it still has to be released
+      sqlite3_exec(_db, "ROLLBACK TO SAVEPOINT operations", nullptr, nullptr, nullptr);
+      releaseSavepoint();
+    }
 
-    void SqliteStorage::beginTransaction() { sqlite3_exec(_db, "BEGIN TRANSACTION", nullptr, nullptr, nullptr); }
-    void SqliteStorage::commitTransaction() { sqlite3_exec(_db, "COMMIT TRANSACTION", nullptr, nullptr, nullptr); }
-    void SqliteStorage::rollbackTransaction() { sqlite3_exec(_db, "ROLLBACK TRANSACTION", nullptr, nullptr, nullptr); }
+    void SqliteStorage::checkpoint()
+    {
+      if (_db != nullptr && _options.journalMode == SqliteOptions::JournalMode::Wal)
+        sqlite3_wal_checkpoint_v2(_db, nullptr, SQLITE_CHECKPOINT_PASSIVE, nullptr, nullptr);
+    }
 
-    void SqliteStorage::prepareQueries()
+    void SqliteStorage::configure()
     {
-      _statements.emplace("hotel.insert", SqliteStatement(_db, "INSERT INTO h_hotel (name) VALUES (?);"));
-      _statements.emplace("hotel.update", SqliteStatement(_db, "UPDATE h_hotel SET name=?, revision=revision+1 WHERE id=? and revision=?;"));
-      _statements.emplace("hotel.all", SqliteStatement(_db, "SELECT id, revision, name FROM h_hotel;"));
-      _statements.emplace("hotel.by_id", SqliteStatement(_db, "SELECT id, revision, name FROM h_hotel WHERE id = ?;"));
-      _statements.emplace(
-          "room_category.insert",
-          SqliteStatement(_db, "INSERT INTO h_room_category (hotel_id, short_code, name) VALUES (?, ?, ?);"));
-      _statements.emplace("room_category.by_hotel_id",
-                          SqliteStatement(_db, "SELECT id, short_code, name FROM h_room_category WHERE hotel_id = ?;"));
-      _statements.emplace("room.insert",
-                          SqliteStatement(_db, "INSERT INTO h_room (hotel_id, category_id, name) VALUES (?, ?, ?);"));
-      _statements.emplace("room.by_hotel_id",
-                          SqliteStatement(_db, "SELECT id, category_id, name FROM h_room WHERE hotel_id = ?;"));
-
-      _statements.emplace(
-          "reservation_and_atoms.all",
-          SqliteStatement(_db, "SELECT r.id, r.revision, r.description, r.status, r.adults, r.children, a.id, a.room_id, a.date_from, a.date_to "
-                               "FROM h_reservation as r, h_reservation_atom as a WHERE "
-                               "a.reservation_id = r.id ORDER BY r.id, a.date_from;"));
-      _statements.emplace(
-          "reservation_and_atoms.by_reservation_id",
-          SqliteStatement(_db, "SELECT r.revision, r.description, r.status, r.adults, r.children, a.id, a.room_id, a.date_from, a.date_to "
-                               "FROM h_reservation as r, h_reservation_atom as a WHERE "
-                               "a.reservation_id = r.id and r.id = ? ORDER BY r.id, a.date_from;"));
-      _statements.emplace("reservation.insert",
-                          SqliteStatement(_db, "INSERT INTO h_reservation (description, status, adults, children) VALUES (?, ?, ?, ?);"));
-      _statements.emplace("reservation.update",
-                          SqliteStatement(_db, "UPDATE h_reservation SET description=?, status=?, adults=?, children=?, revision=revision+1 WHERE id = ? AND revision = ?;"));
-      _statements.emplace("reservation.delete",
-                          SqliteStatement(_db, "DELETE FROM h_reservation_atom where reservation_id = ?; DELETE FROM h_reservation WHERE reservation_id = ?;"));
-      _statements.emplace("reservation_atom.insert",
-                          SqliteStatement(_db, "INSERT INTO h_reservation_atom (reservation_id, room_id, "
-                                               "date_from, date_to) VALUES (?, ?, ?, ?);"));
+      using JournalMode = SqliteOptions::JournalMode;
+      using Synchronous = SqliteOptions::Synchronous;
+
+      const char* journalMode = "delete";
+      switch (_options.journalMode)
+      {
+      case JournalMode::Delete: journalMode = "delete"; break;
+      case JournalMode::Truncate: journalMode = "truncate"; break;
+      case JournalMode::Persist: journalMode = "persist"; break;
+      case JournalMode::Memory: journalMode = "memory"; break;
+      case JournalMode::Wal: journalMode = "wal"; break;
+      case JournalMode::Off: journalMode = "off"; break;
+      }
+      // The journal mode cannot always be changed (e.g. in-memory databases do not support WAL), check the result
+      SqliteStatement journalModeQuery(_db, std::string("PRAGMA journal_mode=") + journalMode + ";");
+      std::string actualJournalMode;
+      if (journalModeQuery.execute() && journalModeQuery.hasResultRow())
+        journalModeQuery.readRow(actualJournalMode);
+      _walEnabled = actualJournalMode == "wal";
+      if (actualJournalMode != journalMode)
+        std::cerr << "Cannot set sqlite journal mode " << journalMode << ", using " << actualJournalMode << std::endl;
+
+      const char* synchronous = "full";
+      switch (_options.synchronous)
+      {
+      case Synchronous::Off: synchronous = "off"; break;
+      case Synchronous::Normal: synchronous = "normal"; break;
+      case Synchronous::Full: synchronous = "full"; break;
+      case Synchronous::Extra: synchronous = "extra"; break;
+      }
+      executeSQL(_db, std::string("PRAGMA synchronous=") + synchronous + ";");
+      executeSQL(_db, "PRAGMA mmap_size=" + std::to_string(_options.mmapSize) + ";");
+      // A negative cache size is interpreted as KiB by sqlite, a positive one as number of pages
+      executeSQL(_db, "PRAGMA cache_size=-" + std::to_string(_options.cacheSizeKiB) + ";");
+      auto autoCheckpoint =
+          _options.checkpointPolicy == SqliteOptions::CheckpointPolicy::Automatic ? _options.autoCheckpointPages : 0;
+      sqlite3_wal_autocheckpoint(_db, autoCheckpoint);
     }
 
+    void SqliteStorage::prepareQueries() { statements::prepare(_db, _statements, statements::AllStatements{}); }
+
     void SqliteStorage::createSchema()
     {
+      // Dropped tables (see deleteAll()) are created again with the current schema
+      auto version = queryInt(_db, "PRAGMA user_version;");
+      auto hasTables = queryInt(_db, "SELECT count(*) FROM sqlite_master WHERE type='table' AND name='h_hotel';") > 0;
+      if (version > schemaVersion)
+        throw std::runtime_error("the database has schema version " + std::to_string(version) +
+                                 ", which is newer than the supported version " + std::to_string(schemaVersion));
+      if (hasTables && version < schemaVersion && !migrateSchema(version))
+        throw std::runtime_error("cannot migrate the database from schema version " + std::to_string(version));
+
       executeSQL(_db, "CREATE TABLE IF NOT EXISTS h_hotel ("
                       "id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, "
                       "revision INTEGER NOT NULL DEFAULT 1, "
@@ -473,8 +705,52 @@ namespace persistence
                       "id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, "
                       "reservation_id INTEGER NOT NULL," // Foreign key
                       "room_id INTEGER NOT NULL,"        // Foreign key
-                      "date_from TEXT NOT NULL,"
-                      "date_to TEXT NOT NULL);");
+                      "date_from INTEGER NOT NULL,"      // Day number
+                      "date_to INTEGER NOT NULL);");     // Day number
+      createIndexes(_db);
+
+      if (!hasTables)
+        executeSQL(_db, "PRAGMA user_version=" + std::to_string(schemaVersion) + ";");
+    }
+
+    bool SqliteStorage::migrateSchema(int fromVersion)
+    {
+      // Every migration runs in a transaction of its own, which also updates the version. Thus a failed or interrupted
+      // migration leaves the database untouched and is repeated the next time the database is opened.
+      auto execute = [this](const std::string& sql) {
+        char* error = nullptr;
+        if (sqlite3_exec(_db, sql.c_str(), nullptr, nullptr, &error) == SQLITE_OK)
+          return true;
+        std::cerr << "Cannot migrate the database schema: " << (error ? error : "") << std::endl;
+        sqlite3_free(error);
+        return false;
+      };
+
+      if (fromVersion < 1)
+      {
+        // Version 1: Store the dates of the atoms as day numbers instead of ISO strings (YYYYMMDD), add indexes
+        beginTransaction();
+        bool succeeded =
+            execute("CREATE TABLE h_reservation_atom_v1 ("
+                    "id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, "
+                    "reservation_id INTEGER NOT NULL,"
+                    "room_id INTEGER NOT NULL,"
+                    "date_from INTEGER NOT NULL,"
+                    "date_to INTEGER NOT NULL);") &&
+            execute("INSERT INTO h_reservation_atom_v1 (id, reservation_id, room_id, date_from, date_to) "
+                    "SELECT id, reservation_id, room_id, " +
+                    dayNumberFromIsoString("date_from") + ", " + dayNumberFromIsoString("date_to") +
+                    " FROM h_reservation_atom;") &&
+            execute("DROP TABLE h_reservation_atom;") &&
+            execute("ALTER TABLE h_reservation_atom_v1 RENAME TO h_reservation_atom;") &&
+            execute("PRAGMA user_version=1;");
+        if (!succeeded || !commitTransaction())
+        {
+          rollbackTransaction();
+          return false;
+        }
+      }
+      return true;
     }
 
   } // namespace sqlite
@@ -11,20 +11,76 @@
 #include <sqlite3.h>
 
 #include <cstdint>
-#include <map>
 #include <memory>
 #include <optional>
 #include <string>
+#include <vector>
 
 namespace persistence
 {
   namespace sqlite
   {
+    /**
+     * @brief The SqliteOptions struct holds the durability and performance settings of a sqlite database
+     *
+     * The defaults are meant for production: the write ahead log allows readers to run concurrently with the writer and
+     * a commit only appends to the log, which with synchronous=NORMAL is not synced before every commit. A power loss
+     * may thus roll back the last transactions, but it never corrupts the database. legacy() returns the settings of
+     * sqlite itself (rollback journal, synchronous=FULL), which sync the database file several times per commit.
+     */
+    struct SqliteOptions
+    {
+      enum class JournalMode { Delete, Truncate, Persist, Memory, Wal, Off };
+      enum class Synchronous { Off, Normal, Full, Extra };
+      enum class CheckpointPolicy
+      {
+        //! Sqlite checkpoints the WAL itself once it grows beyond autoCheckpointPages
+        Automatic,
+        //! The WAL is checkpointed by the backend whenever it runs out of work, commits never pay for checkpoints
+        WhenIdle
+      };
+
+      JournalMode journalMode = JournalMode::Wal;
+      Synchronous synchronous = Synchronous::Normal;
+      //! The maximum number of bytes of the database file which are accessed through memory mapping, 0 disables mmap
+      int64_t mmapSize = 256 * 1024 * 1024;
+      //! The size of the page cache in KiB
+      int64_t cacheSizeKiB = 64 * 1024;
+      //! Only used with the WAL journal mode
+      CheckpointPolicy checkpointPolicy = CheckpointPolicy::Automatic;
+      //! The number of WAL pages which trigger an automatic checkpoint
+      int autoCheckpointPages = 1000;
+      /**
+       * The number of read-only connections, each with its own thread, which SqliteBackend uses to initialize streams
+       * concurrently with the writes. Only used with the WAL journal mode, otherwise (or if 0) the streams are
+       * initialized on the thread of the writer.
+       */
+      int readConnections = 2;
+
+      //! Returns the default settings of sqlite, as used before the options were introduced
+      static SqliteOptions legacy();
+    };
 
     class SqliteStorage
     {
     public:
-      SqliteStorage(const std::string& file);
+      //! The version of the schema created by this class, see createSchema()
+      static constexpr int schemaVersion = 1;
+
+      enum class Access
+      {
+        ReadWrite,
+        //! The connection can only read, the schema and the journal mode have to be set up by a writer before
+        ReadOnly
+      };
+
+      /**
+       * @brief SqliteStorage opens the given database, creating or migrating its schema when opened for writing
+       * @note std::runtime_error is thrown if the schema of the database is newer than schemaVersion or cannot be
+       *       migrated, a database which cannot be read correctly is never used.
+       */
+      SqliteStorage(const std::string& file, const SqliteOptions& options = SqliteOptions(),
+                    Access access = Access::ReadWrite);
       ~SqliteStorage();
 
       void deleteAll();
@@ -45,18 +101,60 @@ namespace persistence
       void getReservation();
 
       void beginTransaction();
-      void commitTransaction();
+      //! @brief commitTransaction commits the current transaction, returns false if the commit failed
+      bool commitTransaction();
       void rollbackTransaction();
+      /**
+       * @brief beginReadTransaction starts a transaction and takes its snapshot of the database right away
+       *
+       * In WAL mode all queries of the transaction see the database as of this call, even if a writer commits changes
+       * in the meantime. The transaction is ended with commitTransaction() or rollbackTransaction().
+       */
+      void beginReadTransaction();
+
+      /**
+       * @brief beginSavepoint starts a nested transaction within the current transaction
+       *
+       * A savepoint is either released, which keeps its changes as part of the outer transaction, or rolled back, which
+       * only undoes the changes made since the savepoint was started.
+       */
+      void beginSavepoint();
+      void releaseSavepoint();
+      void rollbackSavepoint();
+
+      const SqliteOptions& options() const { return _options; }
+      //! @brief isWalEnabled returns true if the database actually uses the write ahead log
+      bool isWalEnabled() const { return _walEnabled; }
+      /**
+       * @brief checkpoint copies the content of the WAL back into the database file
+       * @note This only has an effect with the WAL journal mode, it is a passive checkpoint which never blocks readers
+       */
+      void checkpoint();
 
     private:
-      SqliteStatement& query(const std::string& key);
+      //! @brief query returns the prepared statement of the given statement type, see sqlitestorage.cpp
+      template <typename Statement> auto query();
       int64_t lastInsertId();
 
       void prepareQueries();
+      /**
+       * @brief createSchema creates the tables of an empty database or migrates an older schema
+       *
+       * The version of the schema is stored in the user_version of the database. Databases created before the schema
+       * was versioned have version 0.
+       *
+       * @note std::runtime_error is thrown if the schema is newer than schemaVersion or if the migration fails.
+       */
       void createSchema();
+      //! @brief migrateSchema migrates the schema to schemaVersion, returns false if a migration has been rolled back
+      bool migrateSchema(int fromVersion);
+      void configure();
 
+      SqliteOptions _options;
+      bool _walEnabled = false;
       sqlite3* _db;
-      std::map<std::string, SqliteStatement> _statements;
+      //! The prepared statements, in the order of their definition
+      std::vector<SqliteStatement> _statements;
     };
 
   } // namespace sqlite
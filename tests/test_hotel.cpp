@@ -92,6 +92,16 @@ TEST(Hotel, Hotel)
   ASSERT_EQ("CODE", copy.getCategoryById(1)->shortCode());
   ASSERT_EQ(1, copy.getCategoryByShortCode("CODE")->id());
   ASSERT_EQ("Room 1", copy.rooms()[0]->name());
+  ASSERT_EQ(copy.getCategoryByShortCode("CODE"), copy.rooms()[0]->category());
+
+  // Copy assignment replaces the previous contents
+  copy.addRoomCategory(std::make_unique<hotel::RoomCategory>("OTHER", "My Other Category"));
+  copy = hotel;
+  copy = hotel;
+  ASSERT_EQ(1u, copy.rooms().size());
+  ASSERT_EQ(1u, copy.categories().size());
+  ASSERT_EQ(copy.getCategoryByShortCode("CODE"), copy.rooms()[0]->category());
+  ASSERT_EQ(hotel, copy);
 }
 
 TEST(Hotel, HotelCollection)
@@ -134,6 +144,20 @@ TEST(Hotel, HotelCollection)
   ASSERT_EQ(1u, copy.allRoomsByCategory(1).size());
   ASSERT_EQ("Room", copy.allRooms()[0]->name());
   ASSERT_EQ("Room", copy.allRoomsByCategory(1)[0]->name());
+
+  // The indexes of the copy point to its own hotels
+  ASSERT_EQ(copy.hotels()[0]->rooms()[0].get(), copy.findRoomById(2));
+  ASSERT_EQ(copy.hotels()[0].get(), copy.findHotelByRoomId(2));
+  ASSERT_EQ(collection.hotels()[0].get(), collection.findHotelByRoomId(2));
+  ASSERT_EQ(nullptr, collection.findHotelByRoomId(1));
+
+  hotel::HotelCollection moved;
+  moved = std::move(copy);
+  ASSERT_EQ(moved.hotels()[0].get(), moved.findHotelByRoomId(2));
+  moved.clear();
+  ASSERT_EQ(nullptr, moved.findRoomById(2));
+  ASSERT_EQ(0u, moved.allRoomsByCategory(1).size());
+  ASSERT_EQ(0u, moved.allRoomIDs().size());
 }
 
 TEST(Hotel, ReservationAtom)
@@ -158,6 +182,32 @@ TEST(Hotel, ReservationAtom)
   ASSERT_EQ(atom1Copy, atom1);
 }
 
+TEST(Hotel, DayNumbers)
+{
+  using namespace boost::gregorian;
+  hotel::ReservationAtom atom(10, date_period(date(2016, 2, 28), date(2016, 3, 2)));
+  ASSERT_EQ(3, atom.toDay() - atom.fromDay());
+  ASSERT_EQ(date(2016, 2, 28), hotel::fromDayNumber(atom.fromDay()));
+  ASSERT_EQ(date(2016, 3, 2), hotel::fromDayNumber(atom.toDay()));
+  ASSERT_EQ(date(1400, 1, 1), hotel::fromDayNumber(hotel::toDayNumber(date(1400, 1, 1))));
+  ASSERT_EQ(date(9999, 12, 31), hotel::fromDayNumber(hotel::toDayNumber(date(9999, 12, 31))));
+
+  // The integer intersection test must behave exactly like the one of boost, including empty and inverted periods
+  auto base = date(2017, 1, 1);
+  for (int aFrom = 0; aFrom < 6; ++aFrom)
+    for (int aTo = 0; aTo < 6; ++aTo)
+      for (int bFrom = 0; bFrom < 6; ++bFrom)
+        for (int bTo = 0; bTo < 6; ++bTo)
+        {
+          date_period a(base + days(aFrom), base + days(aTo));
+          date_period b(base + days(bFrom), base + days(bTo));
+          auto intersects = hotel::periodsIntersect(hotel::toDayNumber(a.begin()), hotel::toDayNumber(a.end()),
+                                                    hotel::toDayNumber(b.begin()), hotel::toDayNumber(b.end()));
+          ASSERT_EQ(a.intersects(b), intersects);
+          ASSERT_EQ(a.intersects(b), hotel::ReservationAtom(1, a).intersectsWith(hotel::ReservationAtom(1, b)));
+        }
+}
+
 TEST(Hotel, Reservation)
 {
   using namespace boost::gregorian;
@@ -263,3 +313,65 @@ TEST(Hotel, Reservation)
   ASSERT_EQ(reservation, reservation);
   ASSERT_NE(reservation, emptyReservation);
 }
+
+TEST(Hotel, ReservationAtomStorage)
+{
+  using namespace boost::gregorian;
+
+  // Counts the allocations of a memory resource
+  struct CountingResource : std::pmr::memory_resource
+  {
+    size_t allocations = 0;
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+      ++allocations;
+      return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override
+    {
+      std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+  };
+
+  // The first two atoms are stored inline, a short description fits into the string itself
+  CountingResource resource;
+  hotel::Reservation reservation("Short", 1, date_period(date(2017, 1, 1), date(2017, 1, 5)));
+  reservation.addContinuation(2, date(2017, 1, 8));
+  ASSERT_TRUE(reservation.atoms().isInline());
+  hotel::Reservation copy(reservation, &resource);
+  ASSERT_EQ(reservation, copy);
+  ASSERT_EQ(0u, resource.allocations);
+
+  // More atoms are moved to a buffer allocated from the resource of the reservation
+  copy.addContinuation(3, date(2017, 1, 10));
+  copy.addContinuation(4, date(2017, 1, 12));
+  ASSERT_FALSE(copy.atoms().isInline());
+  ASSERT_EQ(1u, resource.allocations);
+  ASSERT_EQ(4u, copy.atoms().size());
+  ASSERT_EQ(2, copy.atoms()[1].roomId());
+  ASSERT_EQ(4, copy.lastAtom()->roomId());
+  ASSERT_TRUE(copy.isValid());
+
+  // Moving keeps an allocated buffer, inline atoms are copied. The moved-from reservation is empty in both cases.
+  auto firstAtom = copy.firstAtom();
+  hotel::Reservation moved(std::move(copy), &resource);
+  ASSERT_EQ(firstAtom, moved.firstAtom());
+  ASSERT_EQ(0u, copy.atoms().size());
+  hotel::Reservation movedInline(std::move(reservation));
+  ASSERT_TRUE(movedInline.atoms().isInline());
+  ASSERT_EQ(2u, movedInline.atoms().size());
+  ASSERT_FALSE(reservation.isValid());
+
+  // Assignments keep the storage of the target
+  movedInline = moved;
+  ASSERT_EQ(moved, movedInline);
+  ASSERT_EQ(1u, resource.allocations);
+  moved.removeLastAtom();
+  moved.removeLastAtom();
+  moved.removeLastAtom();
+  ASSERT_EQ(1u, moved.atoms().size());
+  ASSERT_EQ(firstAtom, moved.firstAtom());
+  movedInline = moved;
+  ASSERT_EQ(moved, movedInline);
+}
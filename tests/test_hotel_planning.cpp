@@ -1,7 +1,17 @@
 #include "gtest/gtest.h"
 #include "gmock/gmock.h"
 
+#include "hotel/batchvalidator.h"
+#include "hotel/concurrentplanning.h"
 #include "hotel/planning.h"
+#include "hotel/planningdiff.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <random>
+#include <thread>
+#include <utility>
 
 class HotelPlanning : public testing::Test
 {
@@ -100,3 +110,931 @@ TEST_F(HotelPlanning, Planning)
   ASSERT_EQ(1u, board.getReservationsInPeriod(board.getPlanningExtent()).size());
   ASSERT_ANY_THROW(board.removeReservation(nullptr));
 }
+
+TEST_F(HotelPlanning, ReservationIndex)
+{
+  hotel::PlanningBoard board;
+  std::vector<const hotel::Reservation*> pointers;
+  for (int i = 1; i <= 10; ++i)
+  {
+    auto reservation = std::make_unique<hotel::Reservation>(makeReservation(i, 0, 5));
+    reservation->setId(i);
+    pointers.push_back(board.addReservation(std::move(reservation)));
+  }
+  ASSERT_EQ(nullptr, board.getReservationById(0));
+  ASSERT_EQ(nullptr, board.getReservationById(11));
+  for (int i = 1; i <= 10; ++i)
+    ASSERT_EQ(pointers[i - 1], board.getReservationById(i));
+
+  // Adding a second reservation with the same id is not allowed
+  auto duplicate = std::make_unique<hotel::Reservation>(makeReservation(11, 0, 5));
+  duplicate->setId(3);
+  ASSERT_ANY_THROW(board.addReservation(std::move(duplicate)));
+
+  // Removals by id and by pointer must not invalidate the pointers to the remaining reservations
+  board.removeReservation(1);
+  board.removeReservation(pointers[4]);
+  board.removeReservation(42);
+  ASSERT_EQ(8u, board.reservations().size());
+  ASSERT_EQ(nullptr, board.getReservationById(1));
+  ASSERT_EQ(nullptr, board.getReservationById(5));
+  ASSERT_TRUE(board.isFree(1, makeReservation(1, 0, 5).dateRange()));
+  ASSERT_TRUE(board.isFree(5, makeReservation(5, 0, 5).dateRange()));
+  for (int i : {2, 3, 4, 6, 7, 8, 9, 10})
+  {
+    ASSERT_EQ(pointers[i - 1], board.getReservationById(i));
+    ASSERT_EQ(i, pointers[i - 1]->id());
+    ASSERT_FALSE(board.isFree(i, makeReservation(i, 0, 5).dateRange()));
+  }
+
+  // The id can be reused after the removal
+  auto reused = std::make_unique<hotel::Reservation>(makeReservation(1, 0, 5));
+  reused->setId(1);
+  ASSERT_NE(nullptr, board.addReservation(std::move(reused)));
+  ASSERT_EQ(9u, board.reservations().size());
+  ASSERT_NE(nullptr, board.getReservationById(1));
+}
+
+TEST_F(HotelPlanning, BulkInsertion)
+{
+  auto makeBatch = [this](std::vector<std::tuple<int, int, int>> items) {
+    std::vector<std::unique_ptr<hotel::Reservation>> batch;
+    for (auto [room, from, to] : items)
+      batch.push_back(std::make_unique<hotel::Reservation>(makeReservation(room, from, to)));
+    return batch;
+  };
+
+  hotel::PlanningBoard board;
+  board.addReservation(std::make_unique<hotel::Reservation>(makeReservation(1, 5, 10)));
+
+  // A valid batch is added as a whole, and the returned pointers are in the same order as the input
+  auto added = board.addReservations(makeBatch({{1, 20, 25}, {1, 0, 5}, {2, 0, 30}, {1, 10, 20}}));
+  ASSERT_EQ(4u, added.size());
+  ASSERT_EQ(5u, board.reservations().size());
+  ASSERT_EQ(makeReservation(1, 20, 25).dateRange(), added[0]->dateRange());
+  ASSERT_EQ(makeReservation(1, 0, 5).dateRange(), added[1]->dateRange());
+  ASSERT_EQ(makeReservation(2, 0, 30).dateRange(), added[2]->dateRange());
+  ASSERT_EQ(makeReservation(1, 10, 20).dateRange(), added[3]->dateRange());
+  ASSERT_FALSE(board.isFree(1, makeReservation(1, 0, 25).dateRange()));
+  ASSERT_TRUE(board.isFree(1, makeReservation(1, 25, 30).dateRange()));
+  ASSERT_EQ(0, board.getAvailableDaysFrom(1, makeDate(12)));
+  ASSERT_EQ(3, board.getAvailableDaysFrom(1, makeDate(-3)));
+
+  // Batches conflicting with the board or with themselves are rejected without modifying the board
+  ASSERT_ANY_THROW(board.addReservations(makeBatch({{3, 0, 5}, {1, 24, 26}})));
+  ASSERT_ANY_THROW(board.addReservations(makeBatch({{3, 0, 5}, {3, 4, 6}})));
+  ASSERT_ANY_THROW(board.addReservations(makeBatch({{3, 0, 5}, {3, 6, 6}})));
+  auto withNull = makeBatch({{3, 0, 5}});
+  withNull.push_back(nullptr);
+  ASSERT_ANY_THROW(board.addReservations(std::move(withNull)));
+  auto withDuplicateIds = makeBatch({{3, 0, 5}, {4, 0, 5}});
+  withDuplicateIds[0]->setId(7);
+  withDuplicateIds[1]->setId(7);
+  try
+  {
+    board.addReservations(std::move(withDuplicateIds));
+    FAIL() << "the batch with duplicate ids has been added";
+  }
+  catch (const std::logic_error& error)
+  {
+    ASSERT_STREQ("cannot add reservations, duplicate reservation id 7 in the batch", error.what());
+  }
+  ASSERT_EQ(5u, board.reservations().size());
+  ASSERT_TRUE(board.isFree(3, makeReservation(3, 0, 10).dateRange()));
+
+  // Back-to-back reservations in the same batch are fine
+  ASSERT_EQ(2u, board.addReservations(makeBatch({{3, 0, 5}, {3, 5, 6}})).size());
+  ASSERT_EQ(7u, board.reservations().size());
+  ASSERT_EQ(0u, board.addReservations(std::vector<std::unique_ptr<hotel::Reservation>>()).size());
+}
+
+TEST_F(HotelPlanning, BatchValidation)
+{
+  using Kind = hotel::ReservationConflict::Kind;
+  hotel::PlanningBoard board;
+  auto existing = board.addReservation(std::make_unique<hotel::Reservation>(makeReservation(1, 5, 10)));
+  auto removed = board.addReservation(std::make_unique<hotel::Reservation>(makeReservation(2, 0, 10)));
+  board.removeReservation(removed);
+
+  hotel::BatchValidator validator(board);
+  ASSERT_TRUE(validator.validate(std::vector<hotel::Reservation>()).empty());
+  ASSERT_TRUE(validator.validate({makeReservation(1, 0, 5), makeReservation(1, 10, 12), makeReservation(2, 0, 5)})
+                  .empty());
+
+  // Every conflicting pair is reported, ordered by the index of the reservation in the batch
+  auto invalid = makeReservation(3, 6, 6);
+  auto conflicts = validator.validate({makeReservation(1, 8, 12), makeReservation(1, 0, 6), invalid,
+                                       makeReservation(1, 11, 15), makeReservation(1, 4, 20)});
+  ASSERT_EQ(8u, conflicts.size());
+  auto period = [this](int from, int to) { return boost::gregorian::date_period(makeDate(from), makeDate(to)); };
+  ASSERT_EQ((hotel::ReservationConflict{Kind::ConflictWithBoard, 0, std::nullopt, existing, 1, period(8, 10)}),
+            conflicts[0]);
+  ASSERT_EQ((hotel::ReservationConflict{Kind::ConflictInBatch, 0, 4, nullptr, 1, period(8, 12)}), conflicts[1]);
+  ASSERT_EQ((hotel::ReservationConflict{Kind::ConflictInBatch, 0, 3, nullptr, 1, period(11, 12)}), conflicts[2]);
+  ASSERT_EQ((hotel::ReservationConflict{Kind::ConflictInBatch, 1, 4, nullptr, 1, period(4, 6)}), conflicts[3]);
+  ASSERT_EQ((hotel::ReservationConflict{Kind::ConflictWithBoard, 1, std::nullopt, existing, 1, period(5, 6)}),
+            conflicts[4]);
+  ASSERT_EQ(Kind::InvalidReservation, conflicts[5].kind);
+  ASSERT_EQ(2u, conflicts[5].candidate);
+  ASSERT_EQ((hotel::ReservationConflict{Kind::ConflictInBatch, 3, 4, nullptr, 1, period(11, 15)}), conflicts[6]);
+  ASSERT_EQ((hotel::ReservationConflict{Kind::ConflictWithBoard, 4, std::nullopt, existing, 1, period(5, 10)}),
+            conflicts[7]);
+
+  // Replacing the existing reservation, its atoms do not conflict
+  auto replacement = makeReservation(1, 4, 12);
+  ASSERT_TRUE(validator.validate({&replacement}, {existing}).empty());
+  ASSERT_EQ(1u, validator.validate({&replacement}, {}).size());
+
+  // A large batch is validated in parallel, compare it with a brute force check
+  std::mt19937 rng(17);
+  std::uniform_int_distribution<int> roomDistribution(1, 200);
+  std::uniform_int_distribution<int> dayDistribution(0, 2000);
+  std::uniform_int_distribution<int> lengthDistribution(1, 14);
+  for (int i = 0; i < 2000; ++i)
+  {
+    auto from = dayDistribution(rng);
+    auto reservation = makeReservation(roomDistribution(rng), from, from + lengthDistribution(rng));
+    if (board.canAddReservation(reservation))
+      board.addReservation(std::make_unique<hotel::Reservation>(reservation));
+  }
+  std::vector<hotel::Reservation> batch;
+  for (int i = 0; i < 5000; ++i)
+  {
+    auto from = dayDistribution(rng);
+    batch.push_back(makeReservation(roomDistribution(rng), from, from + lengthDistribution(rng)));
+  }
+
+  size_t expectedInBatch = 0;
+  size_t expectedWithBoard = 0;
+  for (size_t i = 0; i < batch.size(); ++i)
+  {
+    for (size_t j = i + 1; j < batch.size(); ++j)
+      if (batch[i].intersectsWith(batch[j]))
+        ++expectedInBatch;
+    for (auto reservation : std::as_const(board).reservations())
+      if (batch[i].intersectsWith(*reservation))
+        ++expectedWithBoard;
+  }
+  conflicts = validator.validate(batch);
+  auto isInBatch = [](auto& x) { return x.kind == Kind::ConflictInBatch; };
+  auto isWithBoard = [](auto& x) { return x.kind == Kind::ConflictWithBoard; };
+  auto inBatch = std::count_if(conflicts.begin(), conflicts.end(), isInBatch);
+  auto withBoard = std::count_if(conflicts.begin(), conflicts.end(), isWithBoard);
+  ASSERT_EQ(expectedInBatch, static_cast<size_t>(inBatch));
+  ASSERT_EQ(expectedWithBoard, static_cast<size_t>(withBoard));
+  for (auto& conflict : conflicts)
+  {
+    auto& candidate = batch[conflict.candidate];
+    if (conflict.kind == Kind::ConflictInBatch)
+      ASSERT_TRUE(candidate.intersectsWith(batch[*conflict.otherCandidate]));
+    else
+      ASSERT_TRUE(candidate.intersectsWith(*conflict.existing));
+    ASSERT_TRUE(candidate.dateRange().contains(conflict.period));
+  }
+  ASSERT_TRUE(std::is_sorted(conflicts.begin(), conflicts.end(),
+                             [](auto& x, auto& y) { return x.candidate < y.candidate; }));
+}
+
+TEST_F(HotelPlanning, ReplaceReservation)
+{
+  hotel::PlanningBoard board;
+  board.setAvailabilityBitmapEnabled(true);
+  board.setSnapshotsEnabled(true);
+  auto original = makeReservation(1, 0, 10);
+  original.setId(3);
+  original.addContinuation(2, makeDate(15));
+  auto reservation = board.addReservation(std::make_unique<hotel::Reservation>(original));
+  auto other = makeReservation(1, 20, 30);
+  other.setId(4);
+  board.addReservation(std::make_unique<hotel::Reservation>(other));
+  auto firstAtom = &reservation->atoms()[0];
+
+  // Moving the reservation within its rooms keeps the reservation and its atoms at the same address
+  auto moved = makeReservation(1, 2, 20);
+  moved.setId(3);
+  moved.addContinuation(2, makeDate(22));
+  moved.setDescription("Moved");
+  ASSERT_EQ(reservation, board.replaceReservation(reservation, moved));
+  ASSERT_EQ(moved, *reservation);
+  ASSERT_EQ(firstAtom, &reservation->atoms()[0]);
+  ASSERT_EQ(reservation, board.getReservationById(3));
+  ASSERT_TRUE(board.isFree(1, makeReservation(1, 0, 2).dateRange()));
+  ASSERT_FALSE(board.isFree(1, makeReservation(1, 19, 20).dateRange()));
+  ASSERT_EQ(0, board.getAvailableDaysFrom(2, makeDate(21)));
+  ASSERT_EQ((std::vector<int>{2}), board.getFreeRooms({1, 2}, makeReservation(1, 0, 3).dateRange()));
+  ASSERT_EQ((std::vector<const hotel::Reservation*>{reservation}),
+            std::as_const(board).getReservationsInRooms(2, 2, makeReservation(1, 20, 22).dateRange()));
+  ASSERT_EQ(makeReservation(1, 2, 30).dateRange(), board.getPlanningExtent());
+
+  // Snapshots share the reservations of the board, a reservation still referenced by a snapshot is copied instead
+  {
+    auto before = board.snapshot();
+    ASSERT_EQ(reservation, before.getReservationById(3));
+    auto renamed = moved;
+    renamed.setDescription("Renamed");
+    auto copy = board.replaceReservation(reservation, renamed);
+    ASSERT_NE(reservation, copy);
+    ASSERT_EQ(copy, board.getReservationById(3));
+    ASSERT_EQ(moved, *before.getReservationById(3));
+    ASSERT_EQ(renamed, *board.snapshot().getReservationById(3));
+    ASSERT_EQ(copy, board.snapshot().getReservationById(3));
+    ASSERT_FALSE(board.isFree(1, makeReservation(1, 19, 20).dateRange()));
+    reservation = copy;
+    moved = renamed;
+  }
+
+  // Replacements overlapping other reservations are rejected without modifying the board
+  ASSERT_ANY_THROW(board.replaceReservation(reservation, makeReservation(1, 15, 21)));
+  ASSERT_ANY_THROW(board.replaceReservation(reservation, makeReservation(3, 5, 5)));
+  ASSERT_ANY_THROW(board.replaceReservation(42, makeReservation(3, 0, 5)));
+  auto withOtherId = makeReservation(3, 0, 5);
+  withOtherId.setId(other.id());
+  ASSERT_ANY_THROW(board.replaceReservation(reservation, withOtherId));
+  ASSERT_EQ(moved, *reservation);
+  ASSERT_EQ(2u, board.reservations().size());
+
+  // Changing the room, the id and the number of atoms
+  auto changed = makeReservation(3, 0, 5);
+  changed.setId(5);
+  ASSERT_EQ(reservation, board.replaceReservation(3, changed));
+  ASSERT_EQ(changed, *reservation);
+  ASSERT_EQ(nullptr, board.getReservationById(3));
+  ASSERT_EQ(reservation, board.getReservationById(5));
+  ASSERT_TRUE(board.isFree(1, makeReservation(1, 0, 20).dateRange()));
+  ASSERT_TRUE(board.isFree(2, makeReservation(2, 0, 30).dateRange()));
+  ASSERT_FALSE(board.isFree(3, makeReservation(3, 4, 5).dateRange()));
+  ASSERT_EQ(makeReservation(1, 0, 30).dateRange(), board.getPlanningExtent());
+  auto grown = makeReservation(3, 0, 5);
+  for (int day = 6; day < 20; ++day)
+    grown.addContinuation(day % 2 + 1, makeDate(day));
+  ASSERT_EQ(reservation, board.replaceReservation(5, grown));
+  ASSERT_EQ(grown, *reservation);
+  ASSERT_EQ((std::vector<int>{2, 3}), board.getFreeRooms({1, 2, 3}, makeReservation(1, 7, 8).dateRange()));
+
+  // Random replacements end up in the same state as a freshly built board
+  std::mt19937 rng(3);
+  std::uniform_int_distribution<int> roomDistribution(1, 5);
+  std::uniform_int_distribution<int> dayDistribution(0, 100);
+  std::uniform_int_distribution<int> lengthDistribution(1, 10);
+  for (int i = 0; i < 2000; ++i)
+  {
+    auto from = dayDistribution(rng);
+    auto replacement = makeReservation(roomDistribution(rng), from, from + lengthDistribution(rng));
+    for (int continuations = i % 3; continuations > 0; --continuations)
+      replacement.addContinuation(roomDistribution(rng), replacement.dateRange().end() + boost::gregorian::days(2));
+    auto reservations = board.reservations();
+    auto target = reservations[static_cast<size_t>(i) % reservations.size()];
+    try
+    {
+      board.replaceReservation(target, replacement);
+      ASSERT_EQ(replacement, *target);
+    }
+    catch (const std::logic_error&)
+    {
+      ASSERT_NE(replacement, *target);
+    }
+  }
+
+  hotel::PlanningBoard reference;
+  for (auto reservation : std::as_const(board).reservations())
+    reference.addReservation(std::make_unique<hotel::Reservation>(*reservation));
+  ASSERT_EQ(reference.getPlanningExtent(), board.getPlanningExtent());
+  std::vector<int> allRooms{1, 2, 3, 4, 5};
+  for (int day = -5; day < 150; ++day)
+  {
+    auto period = makeReservation(1, day, day + 3).dateRange();
+    ASSERT_EQ(reference.getFreeRooms(allRooms, period), board.getFreeRooms(allRooms, period));
+    ASSERT_EQ(std::as_const(reference).getReservationsInPeriod(period).size(),
+              std::as_const(board).getReservationsInPeriod(period).size());
+    for (auto room : allRooms)
+    {
+      ASSERT_EQ(reference.isFree(room, period), board.isFree(room, period));
+      ASSERT_EQ(reference.getAvailableDaysFrom(room, makeDate(day)), board.getAvailableDaysFrom(room, makeDate(day)));
+    }
+  }
+  ASSERT_EQ(board.reservations().size(), board.snapshot().numberOfReservations());
+}
+
+TEST_F(HotelPlanning, FrontDeskIndex)
+{
+  auto sorted = [](std::vector<const hotel::Reservation*> reservations) {
+    std::sort(reservations.begin(), reservations.end());
+    return reservations;
+  };
+
+  hotel::PlanningBoard board;
+  auto arriving = board.addReservation(std::make_unique<hotel::Reservation>(makeReservation(1, 5, 8)));
+  auto changingRooms = makeReservation(2, 3, 5);
+  changingRooms.addContinuation(3, makeDate(7));
+  auto staying = board.addReservation(std::make_unique<hotel::Reservation>(changingRooms));
+
+  for (auto enabled : {false, true})
+  {
+    board.setFrontDeskIndexEnabled(enabled);
+    ASSERT_EQ(enabled, board.isFrontDeskIndexEnabled());
+    ASSERT_EQ((std::vector<const hotel::Reservation*>{arriving}), board.getArrivals(makeDate(5)));
+    ASSERT_EQ((std::vector<const hotel::Reservation*>{staying}), board.getArrivals(makeDate(3)));
+    ASSERT_TRUE(board.getArrivals(makeDate(4)).empty());
+    ASSERT_EQ((std::vector<const hotel::Reservation*>{staying}), board.getDepartures(makeDate(7)));
+    ASSERT_TRUE(board.getDepartures(makeDate(5)).empty());
+    ASSERT_EQ(sorted({arriving, staying}), sorted(board.getInHouse(makeDate(6))));
+    ASSERT_EQ((std::vector<const hotel::Reservation*>{arriving}), board.getInHouse(makeDate(7)));
+    ASSERT_TRUE(board.getInHouse(makeDate(8)).empty());
+  }
+
+  // Random modifications keep the index in sync, compare it with the scans of a board without index
+  std::mt19937 rng(11);
+  std::uniform_int_distribution<int> roomDistribution(1, 20);
+  std::uniform_int_distribution<int> dayDistribution(0, 60);
+  std::uniform_int_distribution<int> lengthDistribution(1, 7);
+  std::uniform_int_distribution<int> actionDistribution(0, 9);
+  for (int i = 0; i < 3000; ++i)
+  {
+    auto from = dayDistribution(rng);
+    auto reservation = makeReservation(roomDistribution(rng), from, from + lengthDistribution(rng));
+    auto action = actionDistribution(rng);
+    auto reservations = board.reservations();
+    if (action < 2 && !reservations.empty())
+      board.removeReservation(reservations[static_cast<size_t>(i) % reservations.size()]);
+    else if (action < 4 && !reservations.empty())
+    {
+      auto target = reservations[static_cast<size_t>(i) % reservations.size()];
+      try
+      {
+        board.replaceReservation(target, reservation);
+      }
+      catch (const std::logic_error&)
+      {
+      }
+    }
+    else if (board.canAddReservation(reservation))
+      board.addReservation(std::make_unique<hotel::Reservation>(reservation));
+  }
+
+  hotel::PlanningBoard reference;
+  for (auto reservation : std::as_const(board).reservations())
+    reference.addReservation(std::make_unique<hotel::Reservation>(*reservation));
+  for (int day = -2; day < 75; ++day)
+  {
+    auto date = makeDate(day);
+    auto toIds = [](const std::vector<const hotel::Reservation*>& reservations) {
+      std::vector<std::pair<int, int>> result;
+      for (auto reservation : reservations)
+        result.emplace_back(reservation->firstAtom()->roomId(), reservation->firstAtom()->fromDay());
+      std::sort(result.begin(), result.end());
+      return result;
+    };
+    ASSERT_EQ(toIds(reference.getArrivals(date)), toIds(board.getArrivals(date)));
+    ASSERT_EQ(toIds(reference.getDepartures(date)), toIds(board.getDepartures(date)));
+    ASSERT_EQ(toIds(reference.getInHouse(date)), toIds(board.getInHouse(date)));
+  }
+
+  board.clear();
+  ASSERT_TRUE(board.getInHouse(makeDate(6)).empty());
+}
+
+TEST_F(HotelPlanning, ConcurrentPlanningBoard)
+{
+  hotel::ConcurrentPlanningBoard board(4);
+  auto reservation = makeReservation(1, 2, 5);
+  reservation.setId(1);
+  ASSERT_THROW(board.tryAddReservation(makeReservation(1, 2, 5)), std::invalid_argument);
+  auto added = board.tryAddReservation(reservation);
+  ASSERT_NE(nullptr, added);
+  ASSERT_EQ(reservation, *added);
+  ASSERT_EQ(added, board.getReservationById(1));
+  ASSERT_EQ(nullptr, board.tryAddReservation(reservation));
+  auto sameId = makeReservation(5, 2, 5);
+  sameId.setId(1);
+  ASSERT_THROW(board.tryAddReservation(sameId), std::logic_error);
+
+  // Reservations spanning multiple rooms (and stripes) are only added if all of the atoms fit
+  auto changingRooms = makeReservation(2, 1, 4);
+  changingRooms.addContinuation(1, makeDate(6));
+  changingRooms.setId(2);
+  ASSERT_FALSE(board.canAddReservation(changingRooms));
+  ASSERT_EQ(nullptr, board.tryAddReservation(changingRooms));
+  ASSERT_TRUE(board.isFree(2, boost::gregorian::date_period(makeDate(1), makeDate(4))));
+  changingRooms.atoms()[1].setRoomId(3);
+  ASSERT_TRUE(board.canAddReservation(changingRooms));
+  ASSERT_NE(nullptr, board.tryAddReservation(changingRooms));
+  ASSERT_EQ(2u, board.numberOfReservations());
+  ASSERT_FALSE(board.isFree(3, boost::gregorian::date_period(makeDate(5), makeDate(6))));
+
+  ASSERT_EQ(added, board.removeReservation(1));
+  ASSERT_EQ(nullptr, board.removeReservation(1));
+  ASSERT_TRUE(board.isFree(1, boost::gregorian::date_period(makeDate(2), makeDate(5))));
+  board.clear();
+  ASSERT_EQ(0u, board.numberOfReservations());
+  ASSERT_TRUE(board.reservations().empty());
+
+  // Many threads compete for overlapping periods, none of the added reservations may overlap
+  const int numberOfThreads = 8;
+  const int reservationsPerThread = 2000;
+  std::atomic<int> numberOfAdded{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < numberOfThreads; ++t)
+    threads.emplace_back([&, t]() {
+      std::mt19937 rng(static_cast<unsigned>(t));
+      std::uniform_int_distribution<int> roomDistribution(1, 16);
+      std::uniform_int_distribution<int> dayDistribution(0, 200);
+      std::uniform_int_distribution<int> lengthDistribution(1, 5);
+      for (int i = 0; i < reservationsPerThread; ++i)
+      {
+        auto from = dayDistribution(rng);
+        auto candidate = makeReservation(roomDistribution(rng), from, from + lengthDistribution(rng));
+        if (i % 3 == 0)
+          candidate.addContinuation(roomDistribution(rng), makeDate(from + 8));
+        candidate.setId(t * reservationsPerThread + i + 1);
+        if (board.tryAddReservation(candidate) != nullptr)
+          ++numberOfAdded;
+        if (i % 10 == 0)
+          board.removeReservation(t * reservationsPerThread + i - 9);
+      }
+    });
+  for (auto& thread : threads)
+    thread.join();
+
+  auto reservations = board.reservations();
+  ASSERT_EQ(board.numberOfReservations(), reservations.size());
+  ASSERT_GT(numberOfAdded.load(), static_cast<int>(reservations.size()));
+  std::vector<hotel::Reservation> copies;
+  for (auto& reservation : reservations)
+    copies.push_back(*reservation);
+  hotel::PlanningBoard planning;
+  ASSERT_NO_THROW(planning.addReservations(copies));
+  for (auto& reservation : reservations)
+    for (auto& atom : reservation->atoms())
+      ASSERT_FALSE(board.isFree(atom.roomId(), atom.dateRange()));
+}
+
+TEST_F(HotelPlanning, PlanningDiff)
+{
+  std::vector<hotel::Reservation> from;
+  for (int i = 1; i <= 5; ++i)
+  {
+    from.push_back(makeReservation(i, 1, 5));
+    from.back().setId(i);
+    from.back().setRevision(1);
+  }
+  // Reservations without id cannot be matched and are ignored
+  from.push_back(makeReservation(10, 1, 5));
+
+  auto to = from;
+  to.erase(to.begin() + 1);
+  to[2].setRevision(2);
+  to[2].atoms()[0].setRoomId(20);
+  to[3].setDescription("Changed without a new revision");
+  to.push_back(makeReservation(6, 1, 5));
+  to.back().setId(6);
+
+  auto diff = hotel::diffReservations(from, to);
+  ASSERT_EQ((std::vector<const hotel::Reservation*>{&to[5]}), diff.added);
+  ASSERT_EQ((std::vector<const hotel::Reservation*>{&to[2]}), diff.updated);
+  ASSERT_EQ((std::vector<int>{2}), diff.removed);
+
+  diff = hotel::diffReservations(from, to, hotel::ReservationComparison::Contents);
+  ASSERT_EQ((std::vector<const hotel::Reservation*>{&to[2], &to[3]}), diff.updated);
+  ASSERT_TRUE(hotel::diffReservations(to, to, hotel::ReservationComparison::Contents).empty());
+
+  // Boards are compared in the same way
+  hotel::PlanningBoard fromBoard;
+  hotel::PlanningBoard toBoard;
+  fromBoard.addReservations(from);
+  toBoard.addReservations(to);
+  diff = hotel::diffReservations(fromBoard, toBoard);
+  ASSERT_EQ(1u, diff.added.size());
+  ASSERT_EQ(6, diff.added[0]->id());
+  ASSERT_EQ(toBoard.getReservationById(4), diff.updated[0]);
+  ASSERT_EQ((std::vector<int>{2}), diff.removed);
+  diff = hotel::diffReservations(toBoard, fromBoard);
+  ASSERT_EQ((std::vector<int>{6}), diff.removed);
+  ASSERT_EQ(fromBoard.getReservationById(2), diff.added[0]);
+}
+
+TEST_F(HotelPlanning, ArenaAllocation)
+{
+  hotel::PlanningBoard board;
+  ASSERT_FALSE(board.isArenaAllocationEnabled());
+  board.setArenaAllocationEnabled(true);
+  ASSERT_TRUE(board.isArenaAllocationEnabled());
+  // Snapshots share the reservations with other threads, thus they cannot be combined with the arena
+  ASSERT_ANY_THROW(board.setSnapshotsEnabled(true));
+
+  // Reservations are added by copy and by moving them into the arena
+  std::vector<hotel::Reservation> reservations;
+  for (int i = 0; i < 100; ++i)
+  {
+    reservations.push_back(makeReservation(i % 10, (i / 10) * 5, (i / 10) * 5 + 5));
+    reservations.back().setDescription("Reservation with a description long enough to be allocated " +
+                                       std::to_string(i));
+    reservations.back().setId(i + 1);
+  }
+  auto added = board.addReservations(reservations);
+  ASSERT_EQ(100u, added.size());
+  auto single = board.addReservation(std::make_unique<hotel::Reservation>(makeReservation(0, 50, 55)));
+  ASSERT_EQ(101u, board.reservations().size());
+  ASSERT_EQ(reservations[42], *board.getReservationById(43));
+  ASSERT_EQ(makeReservation(0, 50, 55).dateRange(), single->dateRange());
+  ASSERT_FALSE(board.isFree(3, makeReservation(3, 0, 50).dateRange()));
+
+  // The mode cannot be changed while the board holds reservations
+  ASSERT_ANY_THROW(board.setArenaAllocationEnabled(false));
+
+  // Removal and copies work as usual, and copies do not share any memory with the arena
+  board.removeReservation(43);
+  ASSERT_EQ(nullptr, board.getReservationById(43));
+  ASSERT_TRUE(board.isFree(2, makeReservation(2, 20, 25).dateRange()));
+  std::vector<hotel::Reservation> copies;
+  for (auto reservation : board.reservations())
+    copies.emplace_back(*reservation);
+  hotel::PlanningBoard heapBoard;
+  heapBoard = board;
+  board.clear();
+  ASSERT_EQ(0u, board.reservations().size());
+  ASSERT_TRUE(board.getPlanningExtent().is_null());
+  ASSERT_EQ(100u, copies.size());
+  ASSERT_EQ(100u, heapBoard.reservations().size());
+  ASSERT_EQ(reservations[0], *heapBoard.getReservationById(1));
+  ASSERT_EQ(std::string(reservations[99].description()), std::string(copies[99].description()));
+
+  // The board can be reused after clearing it, the indexes are rebuilt in the arena
+  board.addReservations(reservations);
+  ASSERT_EQ(100u, board.reservations().size());
+  ASSERT_EQ(reservations[42], *board.getReservationById(43));
+
+  // Moving the board moves the arena together with the reservations and the indexes in it
+  hotel::PlanningBoard movedBoard;
+  movedBoard = std::move(board);
+  ASSERT_TRUE(movedBoard.isArenaAllocationEnabled());
+  movedBoard.removeReservation(43);
+  ASSERT_EQ(99u, movedBoard.reservations().size());
+  ASSERT_EQ(reservations[41], *movedBoard.getReservationById(42));
+  ASSERT_EQ(0u, board.reservations().size());
+  board.addReservations(reservations);
+  ASSERT_EQ(reservations[42], *board.getReservationById(43));
+  board.clear();
+  board.setArenaAllocationEnabled(false);
+  ASSERT_FALSE(board.isArenaAllocationEnabled());
+}
+
+TEST_F(HotelPlanning, Snapshots)
+{
+  hotel::PlanningBoard board;
+  ASSERT_ANY_THROW(board.snapshot());
+  board.addReservation(std::make_unique<hotel::Reservation>(makeReservation(1, 0, 5)));
+  board.setSnapshotsEnabled(true);
+  ASSERT_TRUE(board.isSnapshotsEnabled());
+
+  // Snapshots are not affected by later modifications of the board
+  auto first = board.snapshot();
+  ASSERT_EQ(1u, first.numberOfReservations());
+  auto second = board.addReservation(std::make_unique<hotel::Reservation>(makeReservation(2, 3, 10)));
+  second->setDescription("changed on the board only");
+  auto snapshot = board.snapshot();
+  board.removeReservation(board.reservations().front());
+  board.addReservation(std::make_unique<hotel::Reservation>(makeReservation(1, 2, 4)));
+
+  ASSERT_EQ(1u, first.reservations().size());
+  ASSERT_FALSE(first.isFree(1, makeReservation(1, 4, 5).dateRange()));
+  ASSERT_TRUE(first.isFree(2, makeReservation(2, 0, 20).dateRange()));
+  ASSERT_EQ(makeReservation(1, 0, 5).dateRange(), first.getPlanningExtent());
+
+  ASSERT_EQ(2u, snapshot.reservations().size());
+  ASSERT_EQ(1u, snapshot.getReservationsInPeriod(makeReservation(1, 8, 9).dateRange()).size());
+  ASSERT_EQ(2, snapshot.getAvailableDaysBefore(2, makeDate(12)));
+  ASSERT_EQ(0, snapshot.getAvailableDaysFrom(1, makeDate(4)));
+  ASSERT_FALSE(snapshot.canAddReservation(makeReservation(1, 2, 4)));
+  ASSERT_EQ(makeReservation(1, 0, 10).dateRange(), snapshot.getPlanningExtent());
+
+  auto current = board.snapshot();
+  ASSERT_EQ(2u, current.reservations().size());
+  ASSERT_TRUE(current.isFree(1, makeReservation(1, 0, 2).dateRange()));
+  ASSERT_FALSE(current.isFree(1, makeReservation(1, 3, 4).dateRange()));
+
+  board.clear();
+  ASSERT_EQ(0u, board.snapshot().numberOfReservations());
+  ASSERT_EQ(2u, current.numberOfReservations());
+}
+
+TEST_F(HotelPlanning, SnapshotsWithConcurrentReaders)
+{
+  hotel::PlanningBoard board;
+  board.setSnapshotsEnabled(true);
+  for (int i = 0; i < 100; ++i)
+    board.addReservation(std::make_unique<hotel::Reservation>(makeReservation(i % 10, (i / 10) * 4, (i / 10) * 4 + 4)));
+
+  // Every reader checks that its snapshot stays consistent, while the writer keeps moving the reservations around
+  std::vector<std::thread> readers;
+  std::atomic<bool> failed{false};
+  for (int i = 0; i < 4; ++i)
+  {
+    auto snapshot = board.snapshot();
+    readers.emplace_back([snapshot, &failed]() {
+      auto count = snapshot.numberOfReservations();
+      for (int round = 0; round < 200; ++round)
+      {
+        size_t occupiedRooms = 0;
+        for (int roomId = 0; roomId < 10; ++roomId)
+          occupiedRooms += snapshot.isFree(roomId, snapshot.getPlanningExtent()) ? 0 : 1;
+        if (snapshot.reservations().size() != count || occupiedRooms == 0)
+          failed = true;
+      }
+    });
+    for (int j = 0; j < 50; ++j)
+    {
+      auto reservation = board.reservations().front();
+      auto moved = *reservation;
+      moved.atoms().front().setDateRange(
+          boost::gregorian::date_period(moved.dateRange().begin() + boost::gregorian::days(100),
+                                        moved.dateRange().end() + boost::gregorian::days(100)));
+      board.removeReservation(reservation);
+      board.addReservation(std::make_unique<hotel::Reservation>(moved));
+    }
+  }
+  for (auto& reader : readers)
+    reader.join();
+  ASSERT_FALSE(failed);
+  ASSERT_EQ(100u, board.snapshot().numberOfReservations());
+}
+
+TEST_F(HotelPlanning, OccupancyCounters)
+{
+  using namespace boost::gregorian;
+
+  // Two hotels with 6 rooms each, the room id determines the hotel (1 or 2) and the category (10, 11 or 12)
+  hotel::HotelCollection hotels;
+  for (int hotelId = 1; hotelId <= 2; ++hotelId)
+  {
+    auto hotel = std::make_unique<hotel::Hotel>("Hotel " + std::to_string(hotelId));
+    hotel->setId(hotelId);
+    for (int categoryId = 10; categoryId <= 12; ++categoryId)
+    {
+      hotel->addRoomCategory(std::make_unique<hotel::RoomCategory>(std::to_string(categoryId), "Category"));
+      hotel->getCategoryByShortCode(std::to_string(categoryId))->setId(categoryId);
+    }
+    for (int i = 0; i < 6; ++i)
+    {
+      auto roomId = (hotelId - 1) * 6 + i + 1;
+      hotel->addRoom(std::make_unique<hotel::HotelRoom>("Room"), std::to_string(10 + roomId % 3));
+      hotel->rooms().back()->setId(roomId);
+    }
+    hotels.addHotel(std::move(hotel));
+  }
+
+  auto linearOccupancy = [](const hotel::PlanningBoard& board, std::function<bool(int)> isCounted, date day) {
+    int result = 0;
+    for (auto reservation : board.reservations())
+      for (auto& atom : reservation->atoms())
+        if (isCounted(atom.roomId()) && atom.dateRange().contains(day))
+          ++result;
+    return result;
+  };
+
+  hotel::PlanningBoard board;
+  board.addReservation(std::make_unique<hotel::Reservation>(makeReservation(1, 0, 10)));
+  board.enableOccupancyCounters(hotels);
+  auto counters = board.occupancyCounters();
+  ASSERT_NE(nullptr, counters);
+  ASSERT_EQ(1, counters->occupiedRoomsInHotel(1, makeDate(0)));
+  ASSERT_EQ(0, counters->occupiedRoomsInHotel(1, makeDate(10)));
+  ASSERT_EQ(1, counters->occupiedRoomsInCategory(11, makeDate(5)));
+  ASSERT_EQ(10, counters->roomNightsInHotel(1, date_period(makeDate(-5), makeDate(20))));
+  ASSERT_EQ(0, counters->roomNightsInHotel(2, date_period(makeDate(-5), makeDate(20))));
+
+  std::mt19937 rng(13);
+  std::uniform_int_distribution<> roomDist(1, 13);
+  std::uniform_int_distribution<> dayDist(-50, 400);
+  std::uniform_int_distribution<> lengthDist(1, 30);
+  std::uniform_int_distribution<> percentageDist(0, 100);
+  for (int i = 0; i < 500; ++i)
+  {
+    auto from = dayDist(rng);
+    auto reservation = makeReservation(roomDist(rng), from, from + lengthDist(rng));
+    if (board.canAddReservation(reservation))
+      board.addReservation(std::make_unique<hotel::Reservation>(reservation));
+    auto reservations = board.reservations();
+    if (!reservations.empty() && percentageDist(rng) < 30)
+      board.removeReservation(reservations[std::uniform_int_distribution<size_t>(0, reservations.size() - 1)(rng)]);
+
+    if (i % 50 != 0)
+      continue;
+
+    // Compare whole calendars against the reference
+    auto queryFrom = dayDist(rng) - 20;
+    auto period = date_period(makeDate(queryFrom), makeDate(queryFrom + 60));
+    for (int hotelId = 1; hotelId <= 3; ++hotelId)
+    {
+      auto calendar = counters->hotelCalendar(hotelId, period);
+      ASSERT_EQ(60u, calendar.size());
+      auto isInHotel = [=](int roomId) { return roomId <= 12 && (roomId - 1) / 6 + 1 == hotelId; };
+      int64_t roomNights = 0;
+      for (int day = 0; day < 60; ++day)
+      {
+        auto expected = linearOccupancy(board, isInHotel, makeDate(queryFrom + day));
+        ASSERT_EQ(expected, calendar[day]);
+        ASSERT_EQ(expected, counters->occupiedRoomsInHotel(hotelId, makeDate(queryFrom + day)));
+        roomNights += expected;
+      }
+      ASSERT_EQ(roomNights, counters->roomNightsInHotel(hotelId, period));
+    }
+    for (int categoryId = 10; categoryId <= 12; ++categoryId)
+    {
+      auto calendar = counters->categoryCalendar(categoryId, period);
+      auto isInCategory = [=](int roomId) { return roomId <= 12 && 10 + roomId % 3 == categoryId; };
+      for (int day = 0; day < 60; ++day)
+        ASSERT_EQ(linearOccupancy(board, isInCategory, makeDate(queryFrom + day)), calendar[day]);
+    }
+  }
+
+  board.clear();
+  ASSERT_EQ(0, counters->roomNightsInHotel(1, date_period(makeDate(-100), makeDate(500))));
+  board.disableOccupancyCounters();
+  ASSERT_EQ(nullptr, board.occupancyCounters());
+}
+
+TEST_F(HotelPlanning, RandomizedAvailability)
+{
+  using namespace boost::gregorian;
+
+  // Reference implementations, which linearly scan all of the atoms on the board
+  auto linearIsFree = [](const hotel::PlanningBoard& board, int roomId, date_period period) {
+    for (auto reservation : board.reservations())
+      for (auto& atom : reservation->atoms())
+        if (atom.roomId() == roomId && atom.dateRange().intersects(period))
+          return false;
+    return true;
+  };
+  auto linearAvailableDaysFrom = [](const hotel::PlanningBoard& board, int roomId, date from) {
+    int result = std::numeric_limits<int>::max();
+    for (auto reservation : board.reservations())
+      for (auto& atom : reservation->atoms())
+        if (atom.roomId() == roomId && atom.dateRange().end() > from)
+          result = std::min(result, std::max<int>(0, (atom.dateRange().begin() - from).days()));
+    return result;
+  };
+  auto linearAvailableDaysBefore = [](const hotel::PlanningBoard& board, int roomId, date to) {
+    int result = std::numeric_limits<int>::max();
+    for (auto reservation : board.reservations())
+      for (auto& atom : reservation->atoms())
+        if (atom.roomId() == roomId && atom.dateRange().begin() < to)
+          result = std::min(result, std::max<int>(0, (to - atom.dateRange().end()).days()));
+    return result;
+  };
+  auto linearReservationsInRooms = [](const hotel::PlanningBoard& board, int firstRoomId, int lastRoomId,
+                                      date_period period) {
+    std::vector<const hotel::Reservation*> result;
+    for (auto reservation : board.reservations())
+      for (auto& atom : reservation->atoms())
+        if (atom.roomId() >= firstRoomId && atom.roomId() <= lastRoomId && atom.dateRange().intersects(period))
+        {
+          result.push_back(reservation);
+          break;
+        }
+    return result;
+  };
+
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<> roomDist(1, 4);
+  std::uniform_int_distribution<> dayDist(-5, 120);
+  std::uniform_int_distribution<> lengthDist(-2, 12);
+  std::uniform_int_distribution<> percentageDist(0, 100);
+
+  for (int iteration = 0; iteration < 20; ++iteration)
+  {
+    hotel::PlanningBoard board;
+    for (int i = 0; i < 200; ++i)
+    {
+      // Build a random reservation, possibly with a room change
+      auto from = dayDist(rng);
+      auto to = from + lengthDist(rng);
+      auto reservation = makeReservation(roomDist(rng), from, to);
+      if (to > from && percentageDist(rng) < 20)
+        reservation.addContinuation(roomDist(rng), makeDate(to + 1 + std::abs(lengthDist(rng))));
+
+      bool canAdd = reservation.isValid();
+      for (auto& atom : reservation.atoms())
+        canAdd = canAdd && linearIsFree(board, atom.roomId(), atom.dateRange());
+      ASSERT_EQ(canAdd, board.canAddReservation(reservation));
+      if (canAdd)
+        board.addReservation(std::make_unique<hotel::Reservation>(reservation));
+
+      // Randomly remove some of the reservations again
+      auto reservations = board.reservations();
+      if (!reservations.empty() && percentageDist(rng) < 10)
+      {
+        board.removeReservation(reservations[std::uniform_int_distribution<size_t>(0, reservations.size() - 1)(rng)]);
+      }
+      // Sometimes remove many reservations at once, which forces the atom columns to be compacted
+      if (percentageDist(rng) < 2)
+      {
+        for (size_t j = 0; j < reservations.size() / 2; ++j)
+          board.removeReservation(board.reservations().back());
+      }
+
+      // The incrementally maintained extent must match the extent of all atoms
+      if (!board.reservations().empty())
+      {
+        auto from = date(pos_infin);
+        auto to = date(neg_infin);
+        for (auto reservation : board.reservations())
+        {
+          from = std::min(from, reservation->dateRange().begin());
+          to = std::max(to, reservation->dateRange().end());
+        }
+        ASSERT_EQ(date_period(from, to), board.getPlanningExtent());
+      }
+
+      // Compare random queries against the reference implementation
+      for (int q = 0; q < 10; ++q)
+      {
+        auto roomId = roomDist(rng);
+        auto queryFrom = dayDist(rng);
+        auto period = date_period(makeDate(queryFrom), makeDate(queryFrom + lengthDist(rng)));
+        ASSERT_EQ(linearIsFree(board, roomId, period), board.isFree(roomId, period));
+        ASSERT_EQ(linearAvailableDaysFrom(board, roomId, makeDate(queryFrom)),
+                  board.getAvailableDaysFrom(roomId, makeDate(queryFrom)));
+        ASSERT_EQ(linearAvailableDaysBefore(board, roomId, makeDate(queryFrom)),
+                  board.getAvailableDaysBefore(roomId, makeDate(queryFrom)));
+        ASSERT_EQ(linearReservationsInRooms(board, 1, 4, period), std::as_const(board).getReservationsInPeriod(period));
+        ASSERT_EQ(linearReservationsInRooms(board, roomId, roomId + 1, period),
+                  std::as_const(board).getReservationsInRooms(roomId, roomId + 1, period));
+      }
+    }
+  }
+}
+
+TEST_F(HotelPlanning, AvailabilityBitmap)
+{
+  using namespace boost::gregorian;
+
+  std::mt19937 rng(7);
+  // More than 256 rooms, so that the bitmap has to grow beyond one AVX2 register per day
+  std::uniform_int_distribution<> roomDist(1, 300);
+  std::uniform_int_distribution<> dayDist(-20, 200);
+  std::uniform_int_distribution<> lengthDist(1, 20);
+  std::uniform_int_distribution<> percentageDist(0, 100);
+
+  std::vector<int> allRooms;
+  for (int roomId = 1; roomId <= 310; ++roomId)
+    allRooms.push_back(roomId);
+
+  // The reference board answers the queries without the bitmap
+  hotel::PlanningBoard reference;
+  hotel::PlanningBoard board;
+  ASSERT_FALSE(board.isAvailabilityBitmapEnabled());
+  for (int i = 0; i < 3000; ++i)
+  {
+    if (i == 1000)
+    {
+      // Enabling the bitmap on a filled board must pick up the existing reservations
+      board.setAvailabilityBitmapEnabled(true);
+      ASSERT_TRUE(board.isAvailabilityBitmapEnabled());
+    }
+
+    auto from = dayDist(rng);
+    auto reservation = makeReservation(roomDist(rng), from, from + lengthDist(rng));
+    if (percentageDist(rng) < 20)
+      reservation.addContinuation(roomDist(rng), makeDate(from + 20 + lengthDist(rng)));
+    if (reference.canAddReservation(reservation))
+    {
+      reservation.setId(i + 1);
+      reference.addReservation(std::make_unique<hotel::Reservation>(reservation));
+      board.addReservation(std::make_unique<hotel::Reservation>(reservation));
+    }
+    if (percentageDist(rng) < 10)
+    {
+      auto id = std::uniform_int_distribution<>(1, i + 1)(rng);
+      reference.removeReservation(id);
+      board.removeReservation(id);
+    }
+  }
+
+  for (bool vectorized : {false, true})
+  {
+    hotel::AvailabilityBitmap::setVectorizedKernelsEnabled(vectorized);
+    for (int q = 0; q < 200; ++q)
+    {
+      std::vector<int> rooms;
+      std::sample(allRooms.begin(), allRooms.end(), std::back_inserter(rooms), 40, rng);
+      auto from = dayDist(rng);
+      auto nights = lengthDist(rng) * 2;
+      auto period = date_period(makeDate(from), makeDate(from + nights));
+      ASSERT_EQ(reference.getFreeRooms(rooms, period), board.getFreeRooms(rooms, period));
+
+      rooms.resize(3);
+      auto latest = makeDate(from + lengthDist(rng) * 5);
+      ASSERT_EQ(reference.findFirstFreeRun(rooms, makeDate(from), latest, nights),
+                board.findFirstFreeRun(rooms, makeDate(from), latest, nights));
+    }
+  }
+  hotel::AvailabilityBitmap::setVectorizedKernelsEnabled(true);
+
+  // Unknown rooms are always free, and removing all reservations frees all rooms
+  ASSERT_EQ(std::vector<int>{1000}, board.getFreeRooms({1000}, date_period(makeDate(0), makeDate(5))));
+  board.clear();
+  ASSERT_TRUE(board.isAvailabilityBitmapEnabled());
+  ASSERT_EQ(allRooms, board.getFreeRooms(allRooms, date_period(makeDate(0), makeDate(100))));
+  board.setAvailabilityBitmapEnabled(false);
+  ASSERT_FALSE(board.isAvailabilityBitmapEnabled());
+}
@@ -3,7 +3,9 @@
 #include "server/netserver.h"
 
 #include "persistence/backend.h"
+#include "persistence/binary/snapshot.h"
 #include "persistence/changequeue.h"
+#include "persistence/datastreamdiff.h"
 #include "persistence/sqlite/sqlitebackend.h"
 #include "persistence/op/operations.h"
 #include "persistence/json/jsonserializer.h"
@@ -11,8 +13,13 @@
 
 #include "hotel/hotelcollection.h"
 
+#include <algorithm>
 #include <condition_variable>
 #include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <set>
 #include <thread>
 
 void waitForStreamInitialization(persistence::Backend& backend)
@@ -58,6 +65,8 @@ public:
     // TODO: Right now this test function only works for storing one instance
     auto future = backend.queueOperation(persistence::op::StoreNew{ std::make_unique<hotel::Hotel>(hotel) });
     future.wait();
+    // Streams are initialized concurrently with the operations, they may not have received their initial items yet
+    waitForStreamInitialization(backend);
     backend.changeQueue().applyStreamChanges();
   }
 
@@ -66,6 +75,8 @@ public:
     // TODO: Right now this test function only works for storing one instance
     auto future = backend.queueOperation(persistence::op::StoreNew{ std::make_unique<hotel::Reservation>(reservation) });
     future.wait();
+    // Streams are initialized concurrently with the operations, they may not have received their initial items yet
+    waitForStreamInitialization(backend);
     backend.changeQueue().applyStreamChanges();
   }
 };
@@ -304,6 +315,57 @@ TEST_F(Persistence, FailedTransaction)
   }
 }
 
+TEST_F(Persistence, ConflictingReservations)
+{
+  persistence::sqlite::SqliteBackend backend("test.db");
+  persistence::VectorDataStreamObserver<hotel::Hotel> hotels;
+  auto hotelsStreamHandle = backend.createStreamTyped(&hotels);
+  storeHotel(backend, makeNewHotel("Hotel 1", "Category 1", 10));
+  auto roomId = hotels.items()[0].rooms()[0]->id();
+  auto otherRoomId = hotels.items()[0].rooms()[1]->id();
+
+  persistence::VectorDataStreamObserver<hotel::Reservation> reservations;
+  auto reservationsStreamHandle = backend.createStreamTyped(&reservations);
+  storeReservation(backend, makeNewReservation("Existing", roomId));
+  ASSERT_EQ(1u, reservations.items().size());
+  auto existingId = reservations.items()[0].id();
+
+  // A batch overlapping with itself and with the stored reservation is rejected as a whole, listing all conflicts
+  persistence::op::Operations ops;
+  ops.push_back(persistence::op::StoreNew{std::make_unique<hotel::Reservation>(makeNewReservation("A", otherRoomId))});
+  ops.push_back(persistence::op::StoreNew{std::make_unique<hotel::Reservation>(makeNewReservation("B", roomId))});
+  ops.push_back(persistence::op::StoreNew{std::make_unique<hotel::Reservation>(makeNewReservation("C", otherRoomId))});
+  auto results = backend.queueOperations(std::move(ops)).get();
+  backend.changeQueue().applyStreamChanges();
+
+  ASSERT_EQ(1u, results.size());
+  ASSERT_EQ(persistence::TaskResultStatus::Error, results[0].status);
+  auto& conflicts = results[0].result["conflicts"];
+  ASSERT_EQ(2u, conflicts.size());
+  ASSERT_EQ("conflict_in_batch", conflicts[0]["kind"]);
+  ASSERT_EQ(0, conflicts[0]["operation"]);
+  ASSERT_EQ(2, conflicts[0]["other_operation"]);
+  ASSERT_EQ(otherRoomId, conflicts[0]["room_id"]);
+  ASSERT_EQ("2017-01-01", conflicts[0]["from"]);
+  ASSERT_EQ("2017-01-11", conflicts[0]["to"]);
+  ASSERT_EQ("conflict_with_existing", conflicts[1]["kind"]);
+  ASSERT_EQ(1, conflicts[1]["operation"]);
+  ASSERT_EQ(existingId, conflicts[1]["reservation_id"]);
+  ASSERT_EQ(1u, reservations.items().size());
+
+  // Deleting the existing reservation in the same batch resolves the conflict with it
+  ops.clear();
+  ops.push_back(persistence::op::Delete{persistence::op::StreamableType::Reservation, existingId});
+  ops.push_back(persistence::op::StoreNew{std::make_unique<hotel::Reservation>(makeNewReservation("B", roomId))});
+  ops.push_back(persistence::op::StoreNew{std::make_unique<hotel::Reservation>(makeNewReservation("C", otherRoomId))});
+  results = backend.queueOperations(std::move(ops)).get();
+  backend.changeQueue().applyStreamChanges();
+
+  ASSERT_EQ(3u, results.size());
+  ASSERT_EQ(persistence::TaskResultStatus::Successful, results[2].status);
+  ASSERT_EQ(2u, reservations.items().size());
+}
+
 TEST_F(Persistence, Serialization)
 {
   hotel::Hotel hotelOrig("hello");
@@ -324,6 +386,754 @@ TEST_F(Persistence, Serialization)
   ASSERT_EQ(reservationCopy, reservationOrig);
   ASSERT_EQ(reservationCopy.id(), reservationOrig.id());
   ASSERT_EQ(reservationCopy.revision(), reservationOrig.revision());
+
+  hotel::RoomAvailability availabilityOrig(
+      12, 3, 4, boost::gregorian::date_period(boost::gregorian::date(2017, 8, 20), boost::gregorian::date(2017, 9, 10)),
+      2, std::numeric_limits<int>::max());
+  auto availabilityCopy =
+      persistence::json::deserialize<hotel::RoomAvailability>(persistence::json::serialize(availabilityOrig));
+  ASSERT_EQ(availabilityOrig, availabilityCopy);
+}
+
+TEST_F(Persistence, AvailabilityServices)
+{
+  using namespace boost::gregorian;
+  persistence::sqlite::SqliteBackend backend("test.db");
+
+  persistence::VectorDataStreamObserver<hotel::Hotel> hotels;
+  auto hotelsStreamHandle = backend.createStreamTyped(&hotels);
+  storeHotel(backend, makeNewHotel("Hotel 1", "Category 1", 3));
+  storeHotel(backend, makeNewHotel("Hotel 2", "Category 2", 2));
+  ASSERT_EQ(2u, hotels.items().size());
+  auto& rooms = hotels.items()[0].rooms();
+
+  // The reservations created by makeNewReservation are all in the period 2017-01-01 to 2017-01-11
+  storeReservation(backend, makeNewReservation("Test", rooms[0]->id()));
+
+  persistence::VectorDataStreamObserver<hotel::RoomAvailability> freeRooms;
+  nlohmann::json options = {{"hotel_id", hotels.items()[0].id()}, {"from", "2017-01-05"}, {"to", "2017-01-08"}};
+  auto freeRoomsStreamHandle = backend.createStreamTyped(&freeRooms, "availability.free_rooms", options);
+  waitForStreamInitialization(backend);
+  ASSERT_EQ(2u, freeRooms.items().size());
+  ASSERT_EQ(rooms[1]->id(), freeRooms.items()[0].roomId());
+  ASSERT_EQ(rooms[2]->id(), freeRooms.items()[1].roomId());
+  ASSERT_EQ(date_period(date(2017, 1, 5), date(2017, 1, 8)), freeRooms.items()[0].dateRange());
+
+  persistence::VectorDataStreamObserver<hotel::RoomAvailability> earliest;
+  options = {{"category_id", hotels.items()[0].categories()[0]->id()},
+             {"from", "2017-01-01"},
+             {"to", "2017-03-01"},
+             {"nights", 5}};
+  auto earliestStreamHandle = backend.createStreamTyped(&earliest, "availability.earliest", options);
+  waitForStreamInitialization(backend);
+  ASSERT_EQ(2u, earliest.items().size());
+  ASSERT_EQ(date(2017, 1, 1), earliest.items()[0].dateRange().begin());
+
+  // The results are updated when the data changes, the tightest fit is ranked first
+  auto reservation = makeNewReservation("Test", rooms[1]->id());
+  reservation.atoms()[0].setDateRange(date_period(date(2017, 1, 9), date(2017, 1, 20)));
+  storeReservation(backend, reservation);
+  ASSERT_EQ(2u, freeRooms.items().size());
+  ASSERT_EQ(rooms[1]->id(), freeRooms.items()[0].roomId());
+  ASSERT_EQ(1, freeRooms.items()[0].gapAfter());
+  ASSERT_EQ(rooms[2]->id(), freeRooms.items()[1].roomId());
+
+  storeReservation(backend, makeNewReservation("Test", rooms[2]->id()));
+  ASSERT_EQ(1u, freeRooms.items().size());
+  ASSERT_EQ(1u, earliest.items().size());
+  ASSERT_EQ(rooms[1]->id(), earliest.items()[0].roomId());
+  ASSERT_EQ(date(2017, 1, 1), earliest.items()[0].dateRange().begin());
+}
+
+TEST_F(Persistence, FrontDeskServices)
+{
+  using namespace boost::gregorian;
+  persistence::sqlite::SqliteBackend backend("test.db");
+
+  persistence::VectorDataStreamObserver<hotel::Hotel> hotels;
+  auto hotelsStreamHandle = backend.createStreamTyped(&hotels);
+  storeHotel(backend, makeNewHotel("Hotel 1", "Category 1", 3));
+  ASSERT_EQ(1u, hotels.items().size());
+  auto& rooms = hotels.items()[0].rooms();
+
+  // The reservations created by makeNewReservation are all in the period 2017-01-01 to 2017-01-11
+  storeReservation(backend, makeNewReservation("Test", rooms[0]->id()));
+
+  persistence::VectorDataStreamObserver<hotel::Reservation> arrivals;
+  persistence::VectorDataStreamObserver<hotel::Reservation> departures;
+  persistence::VectorDataStreamObserver<hotel::Reservation> inHouse;
+  auto arrivalsStreamHandle = backend.createStreamTyped(&arrivals, "reservation.arrivals", {{"date", "2017-01-01"}});
+  auto departuresStreamHandle =
+      backend.createStreamTyped(&departures, "reservation.departures", {{"date", "2017-01-11"}});
+  auto inHouseStreamHandle = backend.createStreamTyped(&inHouse, "reservation.in_house", {{"date", "2017-01-10"}});
+  waitForStreamInitialization(backend);
+  ASSERT_EQ(1u, arrivals.items().size());
+  ASSERT_EQ(1u, departures.items().size());
+  ASSERT_EQ(1u, inHouse.items().size());
+  ASSERT_EQ(rooms[0]->id(), arrivals.items()[0].atoms()[0].roomId());
+
+  // The results are updated when the data changes
+  auto reservation = makeNewReservation("Test", rooms[1]->id());
+  reservation.atoms()[0].setDateRange(date_period(date(2017, 1, 5), date(2017, 1, 11)));
+  storeReservation(backend, reservation);
+  ASSERT_EQ(1u, arrivals.items().size());
+  ASSERT_EQ(2u, departures.items().size());
+  ASSERT_EQ(2u, inHouse.items().size());
+
+  // Changed reservations are updated in place, moved ones are removed
+  auto updatedReservation = arrivals.items()[0];
+  updatedReservation.setDescription("Updated");
+  backend.queueOperation(persistence::op::Update{std::make_unique<hotel::Reservation>(updatedReservation)}).wait();
+  backend.changeQueue().applyStreamChanges();
+  ASSERT_EQ(1u, arrivals.items().size());
+  ASSERT_EQ("Updated", arrivals.items()[0].description());
+  updatedReservation = arrivals.items()[0];
+  updatedReservation.atoms()[0].setDateRange(date_period(date(2017, 1, 2), date(2017, 1, 11)));
+  backend.queueOperation(persistence::op::Update{std::make_unique<hotel::Reservation>(updatedReservation)}).wait();
+  backend.changeQueue().applyStreamChanges();
+  ASSERT_TRUE(arrivals.items().empty());
+  ASSERT_EQ(2u, departures.items().size());
+
+  // The night of the departure date does not count as in-house
+  persistence::VectorDataStreamObserver<hotel::Reservation> departed;
+  auto departedStreamHandle = backend.createStreamTyped(&departed, "reservation.in_house", {{"date", "2017-01-11"}});
+  waitForStreamInitialization(backend);
+  ASSERT_TRUE(departed.items().empty());
+}
+
+TEST_F(Persistence, AvailabilityUpdates)
+{
+  using namespace boost::gregorian;
+
+  // Counts the changes sent to the stream
+  struct CountingObserver : public persistence::VectorDataStreamObserver<hotel::RoomAvailability>
+  {
+    void addItems(const std::vector<hotel::RoomAvailability>& items) override
+    {
+      ++changes;
+      VectorDataStreamObserver::addItems(items);
+    }
+    void updateItems(const std::vector<hotel::RoomAvailability>& items) override
+    {
+      ++changes;
+      VectorDataStreamObserver::updateItems(items);
+    }
+    void removeItems(const std::vector<int>& ids) override
+    {
+      ++changes;
+      VectorDataStreamObserver::removeItems(ids);
+    }
+    int changes = 0;
+  };
+
+  int roomId = 0;
+  int existingId = 0;
+  {
+    persistence::sqlite::SqliteBackend backend("test.db");
+    persistence::VectorDataStreamObserver<hotel::Hotel> hotels;
+    auto hotelsStreamHandle = backend.createStreamTyped(&hotels);
+    storeHotel(backend, makeNewHotel("Hotel 1", "Category 1", 2));
+    roomId = hotels.items()[0].rooms()[0]->id();
+
+    persistence::VectorDataStreamObserver<hotel::Reservation> reservations;
+    auto reservationsStreamHandle = backend.createStreamTyped(&reservations);
+    storeReservation(backend, makeNewReservation("Existing", roomId));
+    existingId = reservations.items()[0].id();
+  }
+
+  // A reservation stored before the validation existed, which overlaps with the existing one
+  sqlite3* db = nullptr;
+  ASSERT_EQ(SQLITE_OK, sqlite3_open("test.db", &db));
+  auto sql = "INSERT INTO h_reservation (description, status, adults, children) VALUES ('Legacy', 'new', 2, 0);"
+             "INSERT INTO h_reservation_atom (reservation_id, room_id, date_from, date_to) VALUES (last_insert_rowid(), " +
+             std::to_string(roomId) + ", " + std::to_string(hotel::toDayNumber(date(2017, 1, 5))) + ", " +
+             std::to_string(hotel::toDayNumber(date(2017, 1, 20))) + ");";
+  ASSERT_EQ(SQLITE_OK, sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr));
+  sqlite3_close(db);
+
+  persistence::sqlite::SqliteBackend backend("test.db");
+  persistence::VectorDataStreamObserver<hotel::Reservation> reservations;
+  auto reservationsStreamHandle = backend.createStreamTyped(&reservations);
+  CountingObserver freeRooms;
+  auto freeRoomsStreamHandle =
+      backend.createStreamTyped(&freeRooms, "availability.free_rooms", {{"from", "2017-01-12"}, {"to", "2017-01-15"}});
+  CountingObserver later;
+  auto laterStreamHandle =
+      backend.createStreamTyped(&later, "availability.free_rooms", {{"from", "2017-03-01"}, {"to", "2017-03-05"}});
+  waitForStreamInitialization(backend);
+  ASSERT_EQ(2u, reservations.items().size());
+  ASSERT_EQ(2u, later.items().size());
+
+  // The overlap is reported when the existing reservation is changed, it is not hidden by the validation
+  auto existing = reservations.items()[0].id() == existingId ? reservations.items()[0] : reservations.items()[1];
+  existing.setDescription("Changed");
+  auto results =
+      backend.queueOperation(persistence::op::Update{std::make_unique<hotel::Reservation>(existing)}).get();
+  ASSERT_EQ(persistence::TaskResultStatus::Error, results[0].status);
+  ASSERT_EQ("conflict_with_existing", results[0].result["conflicts"][0]["kind"]);
+  ASSERT_NE(existingId, results[0].result["conflicts"][0]["reservation_id"]);
+  ASSERT_EQ("2017-01-05", results[0].result["conflicts"][0]["from"]);
+  ASSERT_EQ("2017-01-11", results[0].result["conflicts"][0]["to"]);
+
+  // The overlapping reservation occupies its room, even after the reservation it overlaps with has been removed. The
+  // streams are not affected by the removal, thus they are not sent anything.
+  ASSERT_EQ(1u, freeRooms.items().size());
+  ASSERT_NE(roomId, freeRooms.items()[0].roomId());
+  backend.queueOperation(persistence::op::Delete{persistence::op::StreamableType::Reservation, existingId}).wait();
+  backend.changeQueue().applyStreamChanges();
+  ASSERT_EQ(1u, freeRooms.items().size());
+  ASSERT_EQ(1, freeRooms.changes);
+  ASSERT_EQ(1, later.changes);
+
+  // The room becomes free once the overlapping reservation is gone
+  auto legacyId = reservations.items()[0].id() == existingId ? reservations.items()[1].id() : reservations.items()[0].id();
+  backend.queueOperation(persistence::op::Delete{persistence::op::StreamableType::Reservation, legacyId}).wait();
+  backend.changeQueue().applyStreamChanges();
+  ASSERT_EQ(2u, freeRooms.items().size());
+  ASSERT_EQ(roomId, freeRooms.items()[0].roomId());
+}
+
+TEST_F(Persistence, BinarySnapshot)
+{
+  using namespace boost::gregorian;
+
+  hotel::HotelCollection hotels;
+  int nextId = 1;
+  for (auto name : {"Hotel 1", "Hotel 2"})
+  {
+    auto hotel = std::make_unique<hotel::Hotel>(makeNewHotel(name, "Category 1", 3));
+    hotel->addRoomCategory(std::make_unique<hotel::RoomCategory>("Category 2", "Second category"));
+    hotel->addRoom(std::make_unique<hotel::HotelRoom>("Suite"), "Category 2");
+    hotel->setId(nextId++);
+    for (auto& category : hotel->categories())
+      category->setId(nextId++);
+    for (auto& room : hotel->rooms())
+      room->setId(nextId++);
+    hotels.addHotel(std::move(hotel));
+  }
+  auto roomIds = hotels.allRoomIDs();
+
+  hotel::PlanningBoard planning;
+  auto reservation = makeNewReservation("Multiple rooms", roomIds[0]);
+  reservation.setId(100);
+  reservation.setRevision(3);
+  reservation.setNumberOfAdults(2);
+  reservation.setNumberOfChildren(1);
+  reservation.setReservationOwnerPerson(42);
+  reservation.addContinuation(roomIds[5], date(2017, 1, 15));
+  reservation.atoms()[0].setId(101);
+  planning.addReservation(std::make_unique<hotel::Reservation>(reservation));
+  auto other = makeNewReservation("Another reservation with a description which is longer than usual", roomIds[7]);
+  other.setId(200);
+  planning.addReservation(std::make_unique<hotel::Reservation>(other));
+  // Temporary reservations are not stored
+  auto temporary = makeNewReservation("Temporary", roomIds[1]);
+  temporary.setStatus(hotel::Reservation::Temporary);
+  planning.addReservation(std::make_unique<hotel::Reservation>(temporary));
+
+  ASSERT_TRUE(persistence::binary::writeSnapshot("test.snapshot", hotels, planning));
+
+  // The records can be used in place
+  persistence::binary::SnapshotFile file;
+  ASSERT_TRUE(file.open("test.snapshot"));
+  ASSERT_EQ(2u, file.hotels().size());
+  ASSERT_EQ("Hotel 2", file.string(file.hotels()[1].name));
+  ASSERT_EQ(4u, file.rooms(file.hotels()[1]).size());
+  ASSERT_EQ("Second category", file.string(file.categories(file.hotels()[1])[1].name));
+  ASSERT_EQ(2u, file.reservations().size());
+  ASSERT_EQ(3u, file.atoms().size());
+
+  // Loading restores the same state
+  hotel::HotelCollection loadedHotels;
+  hotel::PlanningBoard loadedPlanning;
+  file.load(loadedHotels, loadedPlanning);
+  ASSERT_EQ(2u, loadedHotels.hotels().size());
+  for (size_t i = 0; i < hotels.hotels().size(); ++i)
+  {
+    ASSERT_EQ(*hotels.hotels()[i], *loadedHotels.hotels()[i]);
+    ASSERT_EQ(hotels.hotels()[i]->id(), loadedHotels.hotels()[i]->id());
+    ASSERT_EQ(hotels.hotels()[i]->rooms()[3]->id(), loadedHotels.hotels()[i]->rooms()[3]->id());
+    ASSERT_EQ("Category 2", loadedHotels.hotels()[i]->rooms()[3]->category()->shortCode());
+  }
+  ASSERT_EQ(2u, loadedPlanning.reservations().size());
+  auto loaded = loadedPlanning.getReservationById(100);
+  ASSERT_NE(nullptr, loaded);
+  ASSERT_EQ(reservation, *loaded);
+  ASSERT_EQ(3, loaded->revision());
+  ASSERT_EQ(101, loaded->atoms()[0].id());
+  ASSERT_NE(nullptr, loadedPlanning.getReservationById(200));
+  ASSERT_EQ(other, *loadedPlanning.getReservationById(200));
+  ASSERT_FALSE(loadedPlanning.isFree(roomIds[5], date_period(date(2017, 1, 14), date(2017, 1, 15))));
+  file.close();
+
+  // Missing, truncated or corrupt files are rejected
+  ASSERT_FALSE(file.open("missing.snapshot"));
+  std::string data;
+  {
+    std::ifstream stream("test.snapshot", std::ios::binary);
+    data.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+  }
+  auto writeFile = [](const std::string& data) {
+    std::ofstream stream("test.snapshot", std::ios::binary | std::ios::trunc);
+    stream.write(data.data(), static_cast<std::streamsize>(data.size()));
+  };
+  writeFile(data.substr(0, data.size() - 1));
+  ASSERT_FALSE(file.open("test.snapshot"));
+  auto corrupt = data;
+  corrupt[offsetof(persistence::binary::SnapshotHeader, version)] += 1;
+  writeFile(corrupt);
+  ASSERT_FALSE(file.open("test.snapshot"));
+  corrupt = data;
+  auto& header = *reinterpret_cast<persistence::binary::SnapshotHeader*>(corrupt.data());
+  auto& record = *reinterpret_cast<persistence::binary::ReservationRecord*>(corrupt.data() + header.reservations.offset);
+  record.firstAtom = 1000;
+  writeFile(corrupt);
+  ASSERT_FALSE(file.open("test.snapshot"));
+  ASSERT_FALSE(file.isOpen());
+
+  // So are files which could not be loaded: categories sharing a short code, duplicate ids and overlapping atoms
+  auto corruptRecords = [&data, &writeFile](auto modify) {
+    auto corrupt = data;
+    auto& header = *reinterpret_cast<persistence::binary::SnapshotHeader*>(corrupt.data());
+    modify(header, corrupt.data());
+    writeFile(corrupt);
+  };
+  corruptRecords([](auto& header, char* data) {
+    auto categories = reinterpret_cast<persistence::binary::CategoryRecord*>(data + header.categories.offset);
+    categories[1].shortCode = categories[0].shortCode;
+  });
+  ASSERT_FALSE(file.open("test.snapshot"));
+  corruptRecords([](auto& header, char* data) {
+    auto reservations = reinterpret_cast<persistence::binary::ReservationRecord*>(data + header.reservations.offset);
+    reservations[1].id = reservations[0].id;
+  });
+  ASSERT_FALSE(file.open("test.snapshot"));
+  corruptRecords([](auto& header, char* data) {
+    auto atoms = reinterpret_cast<persistence::binary::AtomRecord*>(data + header.atoms.offset);
+    atoms[2].roomId = atoms[0].roomId;
+  });
+  ASSERT_FALSE(file.open("test.snapshot"));
+
+  // Loading onto a board with conflicting reservations fails
+  writeFile(data);
+  ASSERT_TRUE(file.open("test.snapshot"));
+  hotel::HotelCollection conflictingHotels;
+  hotel::PlanningBoard conflictingPlanning;
+  conflictingPlanning.addReservation(std::make_unique<hotel::Reservation>(makeNewReservation("Blocker", roomIds[7])));
+  ASSERT_THROW(file.load(conflictingHotels, conflictingPlanning), std::logic_error);
+  ASSERT_EQ(1u, conflictingPlanning.reservations().size());
+  file.close();
+  std::remove("test.snapshot");
+}
+
+TEST_F(Persistence, DataStreamDiff)
+{
+  std::vector<hotel::Reservation> from;
+  for (int i = 1; i <= 4; ++i)
+  {
+    from.push_back(makeNewReservation("Reservation " + std::to_string(i), i));
+    from.back().setId(i);
+  }
+  auto to = from;
+  to.erase(to.begin());
+  to[0].setRevision(1);
+  to[0].setDescription("Updated");
+  to.push_back(makeNewReservation("Added", 5));
+  to.back().setId(5);
+
+  // Applying the changes to a stream holding the old state results in the new state
+  auto changes = persistence::makeDataStreamChanges(hotel::diffReservations(from, to));
+  ASSERT_EQ(3u, changes.size());
+  ASSERT_TRUE(std::holds_alternative<persistence::DataStreamItemsRemoved>(changes[0]));
+  ASSERT_TRUE(std::holds_alternative<persistence::DataStreamItemsUpdated>(changes[1]));
+  ASSERT_TRUE(std::holds_alternative<persistence::DataStreamItemsAdded>(changes[2]));
+
+  persistence::VectorDataStreamObserver<hotel::Reservation> observer;
+  persistence::DataStream stream(persistence::StreamableType::Reservation, "", {});
+  stream.connect(1, &observer);
+  stream.applyChange(persistence::DataStreamChange{persistence::DataStreamItemsAdded{from}});
+  for (auto& change : changes)
+    stream.applyChange(change);
+  ASSERT_EQ(to, observer.items());
+
+  ASSERT_TRUE(persistence::makeDataStreamChanges(hotel::diffReservations(to, to)).empty());
+}
+
+TEST_F(Persistence, SqliteOptions)
+{
+  auto hotel = makeNewHotel("Hotel 1", "Category 1", 2);
+  persistence::sqlite::SqliteOptions options;
+  options.checkpointPolicy = persistence::sqlite::SqliteOptions::CheckpointPolicy::WhenIdle;
+  {
+    persistence::sqlite::SqliteBackend backend("test.db", options);
+    persistence::VectorDataStreamObserver<hotel::Hotel> hotels;
+    auto hotelsStreamHandle = backend.createStreamTyped(&hotels);
+    storeHotel(backend, hotel);
+    ASSERT_EQ(1u, hotels.items().size());
+    // The WAL exists while the database is open in WAL mode
+    ASSERT_TRUE(std::ifstream("test.db-wal").good());
+  }
+
+  // The data is still there after switching back to the rollback journal, which removes the WAL
+  {
+    persistence::sqlite::SqliteBackend backend("test.db", persistence::sqlite::SqliteOptions::legacy());
+    persistence::VectorDataStreamObserver<hotel::Hotel> hotels;
+    auto hotelsStreamHandle = backend.createStreamTyped(&hotels);
+    waitForStreamInitialization(backend);
+    ASSERT_EQ(1u, hotels.items().size());
+    ASSERT_EQ(hotel, hotels.items()[0]);
+    ASSERT_FALSE(std::ifstream("test.db-wal").good());
+  }
+}
+
+TEST_F(Persistence, DeleteReservation)
+{
+  persistence::sqlite::SqliteBackend backend("test.db");
+  persistence::VectorDataStreamObserver<hotel::Hotel> hotels;
+  persistence::VectorDataStreamObserver<hotel::Reservation> reservations;
+  auto hotelsStreamHandle = backend.createStreamTyped(&hotels);
+  auto reservationsStreamHandle = backend.createStreamTyped(&reservations);
+  storeHotel(backend, makeNewHotel("Hotel 1", "Category 1", 2));
+  storeReservation(backend, makeNewReservation("Kept", hotels.items()[0].rooms()[0]->id()));
+  storeReservation(backend, makeNewReservation("Deleted", hotels.items()[0].rooms()[1]->id()));
+  ASSERT_EQ(2u, reservations.items().size());
+
+  auto task = backend.queueOperation(
+      persistence::op::Delete{persistence::op::StreamableType::Reservation, reservations.items()[1].id()});
+  ASSERT_EQ(persistence::TaskResultStatus::Successful, task.get()[0].status);
+  backend.changeQueue().applyStreamChanges();
+  ASSERT_EQ(1u, reservations.items().size());
+  ASSERT_EQ("Kept", reservations.items()[0].description());
+
+  // Both the reservation and its atoms are gone from the database
+  sqlite3* db = nullptr;
+  ASSERT_EQ(SQLITE_OK, sqlite3_open("test.db", &db));
+  auto count = [db](const char* table) {
+    sqlite3_stmt* statement = nullptr;
+    sqlite3_prepare_v2(db, (std::string("SELECT count(*) FROM ") + table + ";").c_str(), -1, &statement, nullptr);
+    int result = sqlite3_step(statement) == SQLITE_ROW ? sqlite3_column_int(statement, 0) : -1;
+    sqlite3_finalize(statement);
+    return result;
+  };
+  EXPECT_EQ(1, count("h_reservation"));
+  EXPECT_EQ(1, count("h_reservation_atom"));
+  sqlite3_close(db);
+}
+
+TEST_F(Persistence, SchemaMigration)
+{
+  using namespace boost::gregorian;
+  const char* fileName = "test_migration.db";
+  std::remove(fileName);
+
+  // A database created before the schema was versioned, which stores dates as ISO strings
+  sqlite3* db = nullptr;
+  ASSERT_EQ(SQLITE_OK, sqlite3_open(fileName, &db));
+  ASSERT_EQ(SQLITE_OK,
+            sqlite3_exec(db,
+                         "CREATE TABLE h_hotel (id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, "
+                         "revision INTEGER NOT NULL DEFAULT 1, name TEXT NOT NULL);"
+                         "CREATE TABLE h_room_category (id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, "
+                         "hotel_id INTEGER NOT NULL, short_code TEXT NOT NULL, name TEXT NOT NULL);"
+                         "CREATE TABLE h_room (id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, "
+                         "hotel_id INTEGER NOT NULL, category_id INTEGER NOT NULL, name TEXT NOT NULL);"
+                         "CREATE TABLE h_reservation (id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, "
+                         "revision INTEGER NOT NULL DEFAULT 1, description TEXT NOT NULL, status TEXT NOT NULL, "
+                         "adults INTEGER NOT NULL, children INTEGER NOT NULL);"
+                         "CREATE TABLE h_reservation_atom (id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, "
+                         "reservation_id INTEGER NOT NULL, room_id INTEGER NOT NULL, "
+                         "date_from TEXT NOT NULL, date_to TEXT NOT NULL);"
+                         "INSERT INTO h_hotel (name) VALUES ('Hotel 1');"
+                         "INSERT INTO h_room_category (hotel_id, short_code, name) VALUES (1, 'C', 'Category');"
+                         "INSERT INTO h_room (hotel_id, category_id, name) VALUES (1, 1, 'Room 1');"
+                         "INSERT INTO h_room (hotel_id, category_id, name) VALUES (1, 1, 'Room 2');"
+                         "INSERT INTO h_reservation (description, status, adults, children) "
+                         "VALUES ('Legacy', 'confirmed', 2, 1);"
+                         "INSERT INTO h_reservation_atom (reservation_id, room_id, date_from, date_to) "
+                         "VALUES (1, 1, '20161230', '20170102');"
+                         "INSERT INTO h_reservation_atom (reservation_id, room_id, date_from, date_to) "
+                         "VALUES (1, 2, '20170102', '20170105');",
+                         nullptr, nullptr, nullptr));
+  sqlite3_close(db);
+
+  {
+    persistence::sqlite::SqliteBackend backend(fileName);
+    persistence::VectorDataStreamObserver<hotel::Reservation> reservations;
+    auto reservationsStreamHandle = backend.createStreamTyped(&reservations);
+    waitForStreamInitialization(backend);
+
+    ASSERT_EQ(1u, reservations.items().size());
+    auto& reservation = reservations.items()[0];
+    ASSERT_EQ("Legacy", reservation.description());
+    ASSERT_EQ(2u, reservation.atoms().size());
+    ASSERT_EQ(date_period(date(2016, 12, 30), date(2017, 1, 2)), reservation.atoms()[0].dateRange());
+    ASSERT_EQ(date_period(date(2017, 1, 2), date(2017, 1, 5)), reservation.atoms()[1].dateRange());
+
+    // New atoms continue the ids of the migrated ones
+    hotel::Reservation newReservation("New", 2, date_period(date(2017, 2, 1), date(2017, 2, 4)));
+    storeReservation(backend, newReservation);
+    ASSERT_EQ(2u, reservations.items().size());
+    ASSERT_EQ(3, reservations.items()[1].atoms()[0].id());
+    ASSERT_EQ(newReservation.dateRange(), reservations.items()[1].dateRange());
+  }
+
+  ASSERT_EQ(SQLITE_OK, sqlite3_open(fileName, &db));
+  auto queryInt = [db](const char* sql) {
+    sqlite3_stmt* statement = nullptr;
+    sqlite3_prepare_v2(db, sql, -1, &statement, nullptr);
+    int result = sqlite3_step(statement) == SQLITE_ROW ? sqlite3_column_int(statement, 0) : -1;
+    sqlite3_finalize(statement);
+    return result;
+  };
+  ASSERT_EQ(persistence::sqlite::SqliteStorage::schemaVersion, queryInt("PRAGMA user_version;"));
+  ASSERT_EQ(3, queryInt("SELECT count(*) FROM sqlite_master WHERE type='index' AND name NOT LIKE 'sqlite_%';"));
+  ASSERT_EQ(3, queryInt("SELECT count(*) FROM h_reservation_atom WHERE typeof(date_from)='integer';"));
+  sqlite3_close(db);
+  std::remove(fileName);
+}
+
+TEST_F(Persistence, SchemaMigrationFailure)
+{
+  const char* fileName = "test_migration.db";
+  std::remove(fileName);
+
+  // A legacy atom with a date which cannot be converted violates the NOT NULL constraint of the migrated table
+  sqlite3* db = nullptr;
+  ASSERT_EQ(SQLITE_OK, sqlite3_open(fileName, &db));
+  ASSERT_EQ(SQLITE_OK,
+            sqlite3_exec(db,
+                         "CREATE TABLE h_hotel (id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, "
+                         "revision INTEGER NOT NULL DEFAULT 1, name TEXT NOT NULL);"
+                         "CREATE TABLE h_reservation_atom (id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, "
+                         "reservation_id INTEGER NOT NULL, room_id INTEGER NOT NULL, "
+                         "date_from TEXT NOT NULL, date_to TEXT NOT NULL);"
+                         "INSERT INTO h_reservation_atom (reservation_id, room_id, date_from, date_to) "
+                         "VALUES (1, 1, 'someday', '20170102');",
+                         nullptr, nullptr, nullptr));
+  sqlite3_close(db);
+
+  // The storage refuses to open the database, which is left untouched
+  ASSERT_THROW(persistence::sqlite::SqliteStorage storage(fileName), std::runtime_error);
+  ASSERT_THROW(persistence::sqlite::SqliteBackend backend(fileName), std::runtime_error);
+  ASSERT_EQ(SQLITE_OK, sqlite3_open(fileName, &db));
+  auto queryInt = [db](const char* sql) {
+    sqlite3_stmt* statement = nullptr;
+    sqlite3_prepare_v2(db, sql, -1, &statement, nullptr);
+    int result = sqlite3_step(statement) == SQLITE_ROW ? sqlite3_column_int(statement, 0) : -1;
+    sqlite3_finalize(statement);
+    return result;
+  };
+  ASSERT_EQ(0, queryInt("PRAGMA user_version;"));
+  ASSERT_EQ(1, queryInt("SELECT count(*) FROM h_reservation_atom WHERE typeof(date_from)='text';"));
+
+  // A database written by a newer version is not opened either
+  ASSERT_EQ(SQLITE_OK, sqlite3_exec(db, "DELETE FROM h_reservation_atom; PRAGMA user_version=1000;", nullptr, nullptr,
+                                    nullptr));
+  sqlite3_close(db);
+  ASSERT_THROW(persistence::sqlite::SqliteStorage storage(fileName), std::runtime_error);
+  std::remove(fileName);
+}
+
+TEST_F(Persistence, GroupCommit)
+{
+  persistence::sqlite::SqliteBackend backend("test.db");
+  persistence::VectorDataStreamObserver<hotel::Hotel> hotels;
+  auto hotelsStreamHandle = backend.createStreamTyped(&hotels);
+  waitForStreamInitialization(backend);
+
+  // The messages are queued at once, thus they are usually committed together. A failing message only rolls back its
+  // own operations, independent of whether it shares the transaction with other messages.
+  auto makeStore = [this](const std::string& name) {
+    return persistence::op::StoreNew{std::make_unique<hotel::Hotel>(makeNewHotel(name, "Category", 1))};
+  };
+  std::vector<fas::Future<std::vector<persistence::TaskResult>>> futures;
+  for (int i = 0; i < 10; ++i)
+  {
+    persistence::op::Operations operations;
+    operations.push_back(makeStore("Hotel " + std::to_string(i)));
+    if (i % 3 == 1)
+      operations.push_back(persistence::op::Update{std::make_unique<hotel::Hotel>("Hotel without id")});
+    futures.push_back(backend.queueOperations(std::move(operations)));
+  }
+
+  std::vector<std::string> expectedNames;
+  for (int i = 0; i < 10; ++i)
+  {
+    auto results = futures[static_cast<size_t>(i)].get();
+    if (i % 3 == 1)
+    {
+      ASSERT_EQ(2u, results.size());
+      ASSERT_EQ(persistence::TaskResultStatus::Error, results[1].status);
+    }
+    else
+    {
+      ASSERT_EQ(1u, results.size());
+      ASSERT_EQ(persistence::TaskResultStatus::Successful, results[0].status);
+      expectedNames.push_back("Hotel " + std::to_string(i));
+    }
+  }
+
+  // The changes have been published before the promises were resolved
+  backend.changeQueue().applyStreamChanges();
+  std::vector<std::string> names;
+  for (auto& hotel : hotels.items())
+    names.push_back(hotel.name());
+  ASSERT_EQ(expectedNames, names);
+
+  // Only the successful messages have been committed
+  persistence::VectorDataStreamObserver<hotel::Hotel> reloadedHotels;
+  auto reloadedStreamHandle = backend.createStreamTyped(&reloadedHotels);
+  waitForStreamInitialization(backend);
+  ASSERT_EQ(hotels.items(), reloadedHotels.items());
+}
+
+TEST_F(Persistence, ReadConnectionPool)
+{
+  using namespace boost::gregorian;
+  persistence::sqlite::SqliteBackend backend("test.db");
+  persistence::VectorDataStreamObserver<hotel::Hotel> hotels;
+  auto hotelsStreamHandle = backend.createStreamTyped(&hotels);
+  storeHotel(backend, makeNewHotel("Hotel 1", "Category 1", 10));
+  auto& rooms = hotels.items()[0].rooms();
+
+  persistence::op::Operations initialReservations;
+  for (auto& room : rooms)
+    for (int i = 0; i < 20; ++i)
+    {
+      hotel::Reservation reservation("Initial", room->id(), date_period(date(2017, 1, 1) + days(i), days(1)));
+      initialReservations.push_back(persistence::op::StoreNew{std::make_unique<hotel::Reservation>(reservation)});
+    }
+  backend.queueOperations(std::move(initialReservations)).wait();
+
+  auto byId = [](std::vector<hotel::Reservation> reservations) {
+    std::sort(reservations.begin(), reservations.end(), [](auto& a, auto& b) { return a.id() < b.id(); });
+    return reservations;
+  };
+
+  // Streams are loaded while other messages are committed. No matter whether a message is committed before or after
+  // the snapshot of a stream is taken, the stream has to end up with the same items as a stream loaded afterwards.
+  std::vector<std::unique_ptr<persistence::VectorDataStreamObserver<hotel::Reservation>>> observers;
+  std::vector<persistence::UniqueDataStreamHandle> handles;
+  std::vector<fas::Future<std::vector<persistence::TaskResult>>> futures;
+  for (int round = 0; round < 5; ++round)
+  {
+    observers.push_back(std::make_unique<persistence::VectorDataStreamObserver<hotel::Reservation>>());
+    handles.push_back(backend.createStreamTyped(observers.back().get()));
+    for (size_t i = 0; i < rooms.size(); ++i)
+    {
+      hotel::Reservation reservation("Round " + std::to_string(round), rooms[i]->id(),
+                                     date_period(date(2017, 2, 1) + days(round), days(1)));
+      persistence::op::Operations operations;
+      operations.push_back(persistence::op::StoreNew{std::make_unique<hotel::Reservation>(reservation)});
+      futures.push_back(backend.queueOperations(std::move(operations)));
+    }
+  }
+  for (auto& future : futures)
+    ASSERT_EQ(persistence::TaskResultStatus::Successful, future.get()[0].status);
+  waitForStreamInitialization(backend);
+  backend.changeQueue().applyStreamChanges();
+
+  // Delete some of the reservations while new streams are loading
+  auto reservations = byId(observers.front()->items());
+  ASSERT_EQ(250u, reservations.size());
+  persistence::VectorDataStreamObserver<hotel::Reservation> lateObserver;
+  auto lateHandle = backend.createStreamTyped(&lateObserver);
+  futures.clear();
+  for (size_t i = 0; i < reservations.size(); i += 7)
+  {
+    persistence::op::Operations operations;
+    operations.push_back(persistence::op::Delete{persistence::op::StreamableType::Reservation, reservations[i].id()});
+    futures.push_back(backend.queueOperations(std::move(operations)));
+  }
+  for (auto& future : futures)
+    ASSERT_EQ(persistence::TaskResultStatus::Successful, future.get()[0].status);
+  waitForStreamInitialization(backend);
+  backend.changeQueue().applyStreamChanges();
+
+  persistence::VectorDataStreamObserver<hotel::Reservation> reloaded;
+  auto reloadedHandle = backend.createStreamTyped(&reloaded);
+  waitForStreamInitialization(backend);
+  auto expected = byId(reloaded.items());
+  ASSERT_EQ(250u - 36u, expected.size());
+  for (auto& observer : observers)
+    ASSERT_EQ(expected, byId(observer->items()));
+  ASSERT_EQ(expected, byId(lateObserver.items()));
+}
+
+/**
+ * @brief The RemovedDuringInitializationHandler class removes each stream while initializing it
+ *
+ * Like the handlers of the derived streams, it keeps state for every stream, which is created by initialize() and
+ * released by streamRemoved().
+ */
+class RemovedDuringInitializationHandler : public persistence::detail::DataStreamHandler
+{
+public:
+  virtual void initialize(persistence::DataStream& stream,
+                          std::vector<persistence::DataStreamDifferential>& changeQueue,
+                          [[maybe_unused]] persistence::sqlite::SqliteStorage& storage) override
+  {
+    manager->removeStream(removedStream);
+    streamIds.insert(stream.streamId());
+    changeQueue.push_back({stream.streamId(), persistence::DataStreamItemsAdded{std::vector<hotel::Reservation>()}});
+  }
+
+  virtual void addItems(persistence::DataStream&, std::vector<persistence::DataStreamDifferential>&,
+                        const persistence::StreamableItems&) override
+  {
+  }
+  virtual void updateItems(persistence::DataStream&, std::vector<persistence::DataStreamDifferential>&,
+                           const persistence::StreamableItems&) override
+  {
+  }
+  virtual void removeItems(persistence::DataStream&, std::vector<persistence::DataStreamDifferential>&,
+                           const std::vector<int>) override
+  {
+  }
+  virtual void clear(persistence::DataStream&, std::vector<persistence::DataStreamDifferential>&) override {}
+
+  virtual void streamRemoved(const persistence::DataStream& stream) override { streamIds.erase(stream.streamId()); }
+
+  persistence::detail::DataStreamManager* manager = nullptr;
+  std::shared_ptr<persistence::DataStream> removedStream;
+  std::set<int> streamIds;
+};
+
+TEST_F(Persistence, RemoveStreamDuringInitialization)
+{
+  persistence::sqlite::PlanningState state;
+  persistence::sqlite::SqliteStorage storage("test.db");
+  persistence::detail::DataStreamManager manager(state);
+  auto handler = std::make_unique<RemovedDuringInitializationHandler>();
+  auto& removingHandler = *handler;
+  removingHandler.manager = &manager;
+  manager.setHandler(persistence::StreamableType::Reservation, "test.removed", std::move(handler));
+
+  auto makeStream = [](int id) {
+    auto stream = std::make_shared<persistence::DataStream>(persistence::StreamableType::Reservation, "test.removed",
+                                                            nlohmann::json::object());
+    stream->connect(id, nullptr);
+    return stream;
+  };
+
+  // The worker thread initializes all new streams at once, the items of the removed stream must be discarded
+  persistence::ChangeQueue changeQueue;
+  int queuedChanges = 0;
+  changeQueue.connectToStreamChangesAvailableSignal([&queuedChanges]() { ++queuedChanges; });
+  removingHandler.removedStream = makeStream(1);
+  manager.addNewStream(removingHandler.removedStream);
+  manager.initialize(changeQueue, storage);
+  ASSERT_TRUE(removingHandler.streamIds.empty());
+  ASSERT_EQ(0, queuedChanges);
+
+  // The reader threads initialize one stream at a time
+  removingHandler.removedStream = makeStream(2);
+  manager.addNewStream(removingHandler.removedStream);
+  auto stream = manager.beginLoading();
+  ASSERT_EQ(removingHandler.removedStream, stream);
+  std::vector<persistence::DataStreamDifferential> changes;
+  ASSERT_FALSE(manager.load(*stream, changes, storage));
+  ASSERT_TRUE(removingHandler.streamIds.empty());
 }
 
 TEST_F(Persistence, Net)